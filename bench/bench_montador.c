@@ -0,0 +1,166 @@
+// Benchmark das fases do montador sobre um fonte grande (ver bench/gerador.c).
+// Mede separadamente a primeira passagem (coleta de rótulos e interpretação), a segunda
+// passagem (codificação), a escrita da saída em cada formato e a montagem em fluxo, e
+// informa linhas/s e MB/s (em relação ao tamanho do fonte) de cada fase.
+// O resultado sai em texto, JSON ou CSV, para ser acompanhado entre versões.
+//
+// Compilação e execução (a partir da raiz do repositório):
+//   gcc -O2 -o gerador bench/gerador.c
+//   gcc -O2 -pthread -o bench_montador bench/bench_montador.c
+//   ./gerador -n 2000000 > grande.asm && ./bench_montador -o json grande.asm
+#define MONTADOR_SEM_MAIN
+#include "../montador.c"
+
+#include <time.h>
+
+typedef struct {
+    const char *nome;
+    double melhor;   // Menor tempo entre as repetições, em segundos
+    double soma;     // Para a média
+} Fase;
+
+#define MAXIMO_FASES (3 + NUMERO_FORMATOS_SAIDA)
+
+static Fase fases[MAXIMO_FASES];
+static size_t numero_fases;
+static char nomes_fases[MAXIMO_FASES][32];
+
+static double segundos_agora(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static Fase *fase(const char *nome) {
+    for (size_t i = 0; i < numero_fases; i++) {
+        if (strcmp(fases[i].nome, nome) == 0) return &fases[i];
+    }
+    snprintf(nomes_fases[numero_fases], sizeof(nomes_fases[0]), "%s", nome);
+    fases[numero_fases].nome = nomes_fases[numero_fases];
+    fases[numero_fases].melhor = 1e30;
+    return &fases[numero_fases++];
+}
+
+static void registrar(const char *nome, double inicio) {
+    double tempo = segundos_agora() - inicio;
+    Fase *f = fase(nome);
+    if (tempo < f->melhor) f->melhor = tempo;
+    f->soma += tempo;
+}
+
+static void abortar_com_erros(ListaDiagnosticos *diagnosticos, const char *fase_com_erro) {
+    diagnosticos_imprimir(diagnosticos);
+    fprintf(stderr, "Erros na fase '%s': o benchmark precisa de um fonte que monte sem erros.\n", fase_com_erro);
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    const char *nome_arquivo_entrada = NULL;
+    const char *destino_saida = "/dev/null"; // Sem -s, mede formatação e escrita sem o custo do disco
+    const char *formato_resultado = "texto";
+    int repeticoes = 5, threads = 1, comprimir = 0, uso_incorreto = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) repeticoes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) destino_saida = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) formato_resultado = argv[++i];
+        else if (strcmp(argv[i], "--rvc") == 0) comprimir = 1;
+        else if (nome_arquivo_entrada == NULL) nome_arquivo_entrada = argv[i];
+        else uso_incorreto = 1;
+    }
+    if (uso_incorreto || nome_arquivo_entrada == NULL || threads < 1 || repeticoes < 1 ||
+        (strcmp(formato_resultado, "texto") != 0 && strcmp(formato_resultado, "json") != 0 && strcmp(formato_resultado, "csv") != 0)) {
+        fprintf(stderr, "Uso: %s [-j threads] [-n repetições] [-s arquivo_saida] [-o texto|json|csv] [--rvc] <arquivo_entrada.asm>\n", argv[0]);
+        return 1;
+    }
+
+    Fonte fonte;
+    if (mapear_fonte(nome_arquivo_entrada, &fonte, NULL) != 0) return 1;
+    size_t linhas = 0;
+    for (const char *p = fonte.texto; (p = memchr(p, '\n', fonte.texto + fonte.tamanho - p)) != NULL; p++) linhas++;
+    if (fonte.tamanho > 0 && fonte.texto[fonte.tamanho - 1] != '\n') linhas++;
+
+    inicializar_analisador_lexico();
+    inicializar_tabela_instrucoes();
+    inicializar_tabelas_saida();
+    size_t instrucoes = 0, bytes_codigo = 0;
+
+    for (int r = 0; r < repeticoes; r++) {
+        TabelaRotulos rotulos;
+        memset(&rotulos, 0, sizeof(rotulos));
+        ProgramaIR programa;
+        memset(&programa, 0, sizeof(programa));
+        ListaDiagnosticos diagnosticos = { NULL, 0, 0 };
+
+        double inicio = segundos_agora();
+        if (primeira_passagem(&fonte, &rotulos, &programa, &diagnosticos, comprimir, threads) != 0) abortar_com_erros(&diagnosticos, "primeira_passagem");
+        registrar("primeira_passagem", inicio);
+
+        uint8_t *imagem = malloc(programa.tamanho ? programa.tamanho : 1);
+        if (imagem == NULL) {
+            fprintf(stderr, "Erro: Memória insuficiente para o código montado.\n");
+            return 1;
+        }
+        inicio = segundos_agora();
+        if (segunda_passagem(&fonte, &rotulos, &programa, imagem, &diagnosticos, NULL, NULL, threads) != 0) abortar_com_erros(&diagnosticos, "segunda_passagem");
+        registrar("segunda_passagem", inicio);
+        instrucoes = programa.quantidade;
+        bytes_codigo = programa.tamanho;
+
+        for (size_t f = 0; f < NUMERO_FORMATOS_SAIDA; f++) {
+            char nome[32];
+            snprintf(nome, sizeof(nome), "saida_%s", formatos_saida[f].nome);
+            inicio = segundos_agora();
+            if (escrever_programa(destino_saida, &formatos_saida[f], imagem, programa.tamanho, &programa.dados) != 0) return 1;
+            registrar(nome, inicio);
+        }
+        free(imagem);
+        programa_ir_liberar(&programa);
+        tabela_rotulos_liberar(&rotulos);
+
+        // Passagem única, lendo o fonte da memória como se fosse um pipe
+        FILE *entrada = fmemopen(fonte.texto, fonte.tamanho, "r");
+        if (entrada == NULL) {
+            perror("fmemopen");
+            return 1;
+        }
+        inicio = segundos_agora();
+        if (montar_fluxo(entrada, &rotulos, destino_saida, buscar_formato_saida("bin"), &diagnosticos, comprimir, -1, NULL) != 0) abortar_com_erros(&diagnosticos, "fluxo");
+        registrar("fluxo_bin", inicio);
+        fclose(entrada);
+        tabela_rotulos_liberar(&rotulos);
+        diagnosticos_liberar(&diagnosticos);
+    }
+
+    double megabytes = fonte.tamanho / 1e6;
+    if (strcmp(formato_resultado, "json") == 0) {
+        printf("{\n  \"arquivo\": \"%s\",\n  \"bytes\": %zu,\n  \"linhas\": %zu,\n  \"instrucoes\": %zu,\n"
+               "  \"bytes_codigo\": %zu,\n  \"threads\": %d,\n  \"repeticoes\": %d,\n  \"fases\": [\n",
+               nome_arquivo_entrada, fonte.tamanho, linhas, instrucoes, bytes_codigo, threads, repeticoes);
+        for (size_t i = 0; i < numero_fases; i++) {
+            const Fase *f = &fases[i];
+            printf("    { \"fase\": \"%s\", \"melhor_s\": %.6f, \"media_s\": %.6f, \"linhas_por_s\": %.0f, \"mb_por_s\": %.2f }%s\n",
+                   f->nome, f->melhor, f->soma / repeticoes, linhas / f->melhor, megabytes / f->melhor, i + 1 < numero_fases ? "," : "");
+        }
+        printf("  ]\n}\n");
+    } else if (strcmp(formato_resultado, "csv") == 0) {
+        printf("fase,melhor_s,media_s,linhas_por_s,mb_por_s,linhas,bytes,threads\n");
+        for (size_t i = 0; i < numero_fases; i++) {
+            const Fase *f = &fases[i];
+            printf("%s,%.6f,%.6f,%.0f,%.2f,%zu,%zu,%d\n", f->nome, f->melhor, f->soma / repeticoes,
+                   linhas / f->melhor, megabytes / f->melhor, linhas, fonte.tamanho, threads);
+        }
+    } else {
+        printf("Fonte: %s (%.1f MB, %zu linhas, %zu instruções, %zu bytes de código), %d thread(s), melhor de %d\n",
+               nome_arquivo_entrada, megabytes, linhas, instrucoes, bytes_codigo, threads, repeticoes);
+        printf("%-18s %10s %10s %14s %10s\n", "fase", "melhor(s)", "média(s)", "linhas/s", "MB/s");
+        for (size_t i = 0; i < numero_fases; i++) {
+            const Fase *f = &fases[i];
+            printf("%-18s %10.4f %10.4f %14.0f %10.1f\n", f->nome, f->melhor, f->soma / repeticoes,
+                   linhas / f->melhor, megabytes / f->melhor);
+        }
+    }
+    fonte_liberar(&fonte);
+    return 0;
+}
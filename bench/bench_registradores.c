@@ -0,0 +1,126 @@
+// Micro-benchmark da decodificação de nomes de registradores.
+// Compara obter_numero_registrador (hash perfeito) com a implementação original baseada
+// em uma sequência de strcmp, usando as 65 grafias válidas (33 nomes ABI + x0..x31).
+//
+// Compilação e execução (a partir da raiz do repositório):
+//   gcc -O2 -pthread -o bench_registradores bench/bench_registradores.c && ./bench_registradores
+#define MONTADOR_SEM_MAIN
+#include "../montador.c"
+
+#include <time.h>
+
+#define REPETICOES 2000000
+
+// Implementação original, mantida apenas como referência para a comparação
+static int obter_numero_registrador_linear(const char *nome_reg) {
+    if (strcmp(nome_reg, "zero") == 0) return 0;
+    if (strcmp(nome_reg, "ra") == 0) return 1;
+    if (strcmp(nome_reg, "sp") == 0) return 2;
+    if (strcmp(nome_reg, "gp") == 0) return 3;
+    if (strcmp(nome_reg, "tp") == 0) return 4;
+    if (strcmp(nome_reg, "t0") == 0) return 5;
+    if (strcmp(nome_reg, "t1") == 0) return 6;
+    if (strcmp(nome_reg, "t2") == 0) return 7;
+    if (strcmp(nome_reg, "s0") == 0 || strcmp(nome_reg, "fp") == 0) return 8;
+    if (strcmp(nome_reg, "s1") == 0) return 9;
+    if (strcmp(nome_reg, "a0") == 0) return 10;
+    if (strcmp(nome_reg, "a1") == 0) return 11;
+    if (strcmp(nome_reg, "a2") == 0) return 12;
+    if (strcmp(nome_reg, "a3") == 0) return 13;
+    if (strcmp(nome_reg, "a4") == 0) return 14;
+    if (strcmp(nome_reg, "a5") == 0) return 15;
+    if (strcmp(nome_reg, "a6") == 0) return 16;
+    if (strcmp(nome_reg, "a7") == 0) return 17;
+    if (strcmp(nome_reg, "s2") == 0) return 18;
+    if (strcmp(nome_reg, "s3") == 0) return 19;
+    if (strcmp(nome_reg, "s4") == 0) return 20;
+    if (strcmp(nome_reg, "s5") == 0) return 21;
+    if (strcmp(nome_reg, "s6") == 0) return 22;
+    if (strcmp(nome_reg, "s7") == 0) return 23;
+    if (strcmp(nome_reg, "s8") == 0) return 24;
+    if (strcmp(nome_reg, "s9") == 0) return 25;
+    if (strcmp(nome_reg, "s10") == 0) return 26;
+    if (strcmp(nome_reg, "s11") == 0) return 27;
+    if (strcmp(nome_reg, "t3") == 0) return 28;
+    if (strcmp(nome_reg, "t4") == 0) return 29;
+    if (strcmp(nome_reg, "t5") == 0) return 30;
+    if (strcmp(nome_reg, "t6") == 0) return 31;
+    if (nome_reg[0] == 'x') {
+        int num_reg = atoi(&nome_reg[1]);
+        if (num_reg >= 0 && num_reg <= 31) {
+            return num_reg;
+        }
+    }
+    return -1;
+}
+
+// O montador recebe o nome como token (ponteiro e tamanho) do analisador léxico; aqui o
+// tamanho é calculado a cada chamada, então a medida inclui o strlen
+static int obter_numero_registrador_hash(const char *nome_reg) {
+    return obter_numero_registrador((Token){ nome_reg, (uint32_t)strlen(nome_reg) });
+}
+
+static const char *nomes_validos[] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "fp", "s1",
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
+    "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
+    "t3", "t4", "t5", "t6",
+    "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10",
+    "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", "x19", "x20",
+    "x21", "x22", "x23", "x24", "x25", "x26", "x27", "x28", "x29", "x30", "x31",
+};
+
+#define NUMERO_NOMES (sizeof(nomes_validos) / sizeof(nomes_validos[0]))
+
+static const char *nomes_invalidos[] = {
+    "", "x", "x32", "x3a", "x01", "x-1", "t7", "s12", "a8", "zer", "zeros", "X1", "sp ",
+};
+
+static double segundos_agora(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Mede o tempo médio por chamada, em nanossegundos, sobre todas as grafias válidas
+static double medir(int (*decodificar)(const char *), long *soma) {
+    double inicio = segundos_agora();
+    for (int r = 0; r < REPETICOES; r++) {
+        for (size_t i = 0; i < NUMERO_NOMES; i++) {
+            *soma += decodificar(nomes_validos[i]);
+        }
+    }
+    return (segundos_agora() - inicio) * 1e9 / ((double)REPETICOES * NUMERO_NOMES);
+}
+
+int main(void) {
+    _Static_assert(NUMERO_NOMES == 65, "Devem existir 65 grafias válidas de registradores");
+
+    // Confere que as duas implementações concordam em todas as grafias válidas
+    for (size_t i = 0; i < NUMERO_NOMES; i++) {
+        int esperado = obter_numero_registrador_linear(nomes_validos[i]);
+        int obtido = obter_numero_registrador_hash(nomes_validos[i]);
+        if (esperado != obtido) {
+            fprintf(stderr, "Divergência para '%s': esperado %d, obtido %d\n", nomes_validos[i], esperado, obtido);
+            return 1;
+        }
+    }
+    // E que os nomes malformados são rejeitados
+    for (size_t i = 0; i < sizeof(nomes_invalidos) / sizeof(nomes_invalidos[0]); i++) {
+        if (obter_numero_registrador_hash(nomes_invalidos[i]) != -1) {
+            fprintf(stderr, "Nome inválido '%s' foi aceito\n", nomes_invalidos[i]);
+            return 1;
+        }
+    }
+
+    // A soma impede que o compilador descarte as chamadas
+    long soma_linear = 0, soma_hash = 0;
+    double ns_linear = medir(obter_numero_registrador_linear, &soma_linear);
+    double ns_hash = medir(obter_numero_registrador_hash, &soma_hash);
+
+    printf("Grafias válidas: %zu, repetições: %d\n", NUMERO_NOMES, REPETICOES);
+    printf("strcmp sequencial: %6.2f ns/chamada\n", ns_linear);
+    printf("hash perfeito:     %6.2f ns/chamada\n", ns_hash);
+    printf("aceleração:        %6.2fx\n", ns_linear / ns_hash);
+    return soma_linear == soma_hash ? 0 : 1;
+}
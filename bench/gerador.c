@@ -0,0 +1,156 @@
+// Gerador determinístico de programas RV32I grandes, usado pelos benchmarks do montador.
+// O mesmo conjunto de opções (e a mesma semente) sempre gera exatamente o mesmo fonte.
+//
+// O programa gerado usa todas as formas de operandos do montador, define um rótulo a cada
+// N instruções (densidade configurável) e tem branches e jal para trás e para frente, além
+// de comentários em linhas próprias, comentários no fim das linhas e linhas em branco.
+// Todos os destinos ficam dentro do alcance do branch/jal, então o fonte sempre monta.
+//
+// Compilação e uso (a partir da raiz do repositório):
+//   gcc -O2 -o gerador bench/gerador.c
+//   ./gerador -n 2000000 -r 16 > grande.asm
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Alcance dos branches (+/- 4 KiB) em instruções, com folga
+#define ALCANCE_BRANCH 1000
+
+static uint64_t estado_aleatorio;
+
+// xorshift64*: rápido e idêntico em qualquer plataforma
+static uint32_t aleatorio(void) {
+    estado_aleatorio ^= estado_aleatorio >> 12;
+    estado_aleatorio ^= estado_aleatorio << 25;
+    estado_aleatorio ^= estado_aleatorio >> 27;
+    return (uint32_t)((estado_aleatorio * 2685821657736338717ull) >> 32);
+}
+
+// Inteiro uniforme em [minimo, maximo]
+static long sortear(long minimo, long maximo) {
+    return minimo + (long)(aleatorio() % (uint32_t)(maximo - minimo + 1));
+}
+
+// Verdadeiro com probabilidade 'percentual'/100
+static int chance(int percentual) {
+    return (int)(aleatorio() % 100) < percentual;
+}
+
+static const char *registradores[] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+static const char *reg(void) {
+    return chance(10) ? (const char *[]){ "x5", "x10", "x31", "x0" }[aleatorio() % 4] : registradores[aleatorio() % 32];
+}
+
+static const char *tipo_r[] = { "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and",
+                                "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu" };
+static const char *tipo_i[] = { "addi", "slti", "sltiu", "xori", "ori", "andi" };
+static const char *deslocamentos[] = { "slli", "srli", "srai" };
+static const char *cargas[] = { "lb", "lh", "lw", "lbu", "lhu" };
+static const char *armazenamentos[] = { "sb", "sh", "sw" };
+static const char *branches[] = { "beq", "bne", "blt", "bge", "bltu", "bgeu" };
+
+#define SORTEAR_DE(vetor) vetor[aleatorio() % (sizeof(vetor) / sizeof(vetor[0]))]
+
+typedef struct {
+    long linhas;              // Linhas de instrução a gerar
+    long intervalo_rotulos;   // Uma definição de rótulo a cada N instruções
+    int percentual_branches;  // Percentual de instruções que são branch ou jal
+    int percentual_comentarios;
+    int percentual_brancos;
+    uint64_t semente;
+} Configuracao;
+
+// Escolhe um rótulo destino (índice) para a instrução 'indice', dentro de 'alcance' instruções
+static long escolher_destino(const Configuracao *c, long indice, long alcance, long total_rotulos) {
+    long atual = indice / c->intervalo_rotulos; // Último rótulo definido antes desta instrução
+    long passo = (alcance - c->intervalo_rotulos) / c->intervalo_rotulos; // Desconta a distância até o rótulo atual
+    if (passo < 0) passo = 0;
+    long minimo = atual - passo, maximo = atual + passo;
+    if (minimo < 0) minimo = 0;
+    if (maximo >= total_rotulos) maximo = total_rotulos - 1;
+    return sortear(minimo, maximo);
+}
+
+static void gerar(const Configuracao *c) {
+    long total_rotulos = (c->linhas - 1) / c->intervalo_rotulos + 1;
+    printf("# Programa gerado por bench/gerador.c: %ld instruções, um rótulo a cada %ld, semente %llu\n",
+           c->linhas, c->intervalo_rotulos, (unsigned long long)c->semente);
+
+    for (long i = 0; i < c->linhas; i++) {
+        if (chance(c->percentual_brancos)) printf("\n");
+        if (chance(c->percentual_comentarios)) printf("    # bloco %ld\n", i);
+
+        if (i % c->intervalo_rotulos == 0 && chance(50)) {
+            printf("L%ld: ", i / c->intervalo_rotulos); // Rótulo e instrução na mesma linha
+        } else {
+            if (i % c->intervalo_rotulos == 0) printf("L%ld:\n", i / c->intervalo_rotulos);
+            printf("    ");
+        }
+
+        if (chance(c->percentual_branches)) {
+            // Um destino só é garantido dentro do alcance de um branch se houver rótulos por perto;
+            // caso contrário usa jal, que alcança +/- 1 MiB
+            if (c->intervalo_rotulos <= ALCANCE_BRANCH / 2 && chance(80)) {
+                long destino = escolher_destino(c, i, ALCANCE_BRANCH, total_rotulos);
+                printf("%s %s, %s, L%ld", SORTEAR_DE(branches), reg(), reg(), destino);
+            } else {
+                long destino = escolher_destino(c, i, 200000, total_rotulos);
+                printf("jal %s, L%ld", reg(), destino);
+            }
+        } else {
+            switch (aleatorio() % 10) {
+            case 0: case 1: case 2:
+                printf("%s %s, %s, %s", SORTEAR_DE(tipo_r), reg(), reg(), reg()); break;
+            case 3: case 4:
+                printf("%s %s, %s, %ld", SORTEAR_DE(tipo_i), reg(), reg(), sortear(-2048, 2047)); break;
+            case 5:
+                printf("%s %s, %s, %ld", SORTEAR_DE(deslocamentos), reg(), reg(), sortear(0, 31)); break;
+            case 6:
+                printf("%s %s, %ld(%s)", SORTEAR_DE(cargas), reg(), sortear(-2048, 2047), reg()); break;
+            case 7:
+                printf("%s %s, %ld(%s)", SORTEAR_DE(armazenamentos), reg(), sortear(-2048, 2047), reg()); break;
+            case 8:
+                printf("%s %s, 0x%lx", chance(50) ? "lui" : "auipc", reg(), sortear(0, 0xFFFFF)); break;
+            default:
+                if (chance(50)) printf("jalr %s, %ld(%s)", reg(), sortear(-2048, 2047), reg());
+                else printf("jalr %s, %s, %ld", reg(), reg(), sortear(-2048, 2047));
+                break;
+            }
+        }
+        if (chance(c->percentual_comentarios)) printf(" # comentário %ld", i);
+        printf("\n");
+    }
+    printf("    ecall\n");
+}
+
+int main(int argc, char *argv[]) {
+    Configuracao c = { 1000000, 16, 15, 5, 3, 1 };
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) goto uso;
+        long valor = strtol(argv[i + 1], NULL, 0);
+        if (strcmp(argv[i], "-n") == 0 && valor > 0) c.linhas = valor;
+        else if (strcmp(argv[i], "-r") == 0 && valor > 0) c.intervalo_rotulos = valor;
+        else if (strcmp(argv[i], "-b") == 0 && valor >= 0 && valor <= 100) c.percentual_branches = (int)valor;
+        else if (strcmp(argv[i], "-c") == 0 && valor >= 0 && valor <= 100) c.percentual_comentarios = (int)valor;
+        else if (strcmp(argv[i], "-v") == 0 && valor >= 0 && valor <= 100) c.percentual_brancos = (int)valor;
+        else if (strcmp(argv[i], "-s") == 0) c.semente = (uint64_t)strtoull(argv[i + 1], NULL, 0);
+        else goto uso;
+        i++;
+    }
+    estado_aleatorio = c.semente * 0x9E3779B97F4A7C15ull + 1; // Nunca zero
+
+    static char buffer[1 << 20];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    gerar(&c);
+    return fflush(stdout) == 0 ? 0 : 1;
+
+uso:
+    fprintf(stderr, "Uso: %s [-n instruções] [-r instruções_por_rótulo] [-b %%branches] [-c %%comentários] [-v %%linhas_em_branco] [-s semente]\n", argv[0]);
+    return 1;
+}
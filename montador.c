@@ -1,494 +1,5772 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // Para strtok_r e clock_gettime
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h> // Para uint32_t, uint8_t
+#include <stdarg.h> // Para as mensagens de erro com argumentos variáveis
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>  // Compilar com -pthread
+#include <time.h>
+#include <setjmp.h>       // Para devolver a falta de memória à biblioteca (montador_montar)
+#include <sys/resource.h> // Para o pico de memória (getrusage)
+#include <unistd.h>       // Para sysconf (número de processadores)
+#include <fcntl.h>
+#include <sys/mman.h>     // Para mapear o fonte e os arquivos de .incbin
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>    // Para a classificação vetorial do analisador léxico (SSE2/AVX2)
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>  // Para o modo de observação (--observar)
+#include <poll.h>
+#endif
+
+#include "montador.h"
+
+// Só as funções montador_* (montador.h) são exportadas: todo o resto é static, para que o
+// objeto compilado com -DMONTADOR_SEM_MAIN não colida com os símbolos de quem o usa. As
+// funções que só o main usa são marcadas assim, para não gerar avisos sem ele.
+#ifdef __GNUC__
+#define SOMENTE_LINHA_COMANDO static __attribute__((unused))
+#else
+#define SOMENTE_LINHA_COMANDO static
+#endif
+
+// --- Falta de Memória ---
+// Na linha de comando, faltar memória encerra o programa com uma mensagem. A biblioteca não
+// pode encerrar quem a usa: montador_montar instala um ponto de retorno (um por thread) e a
+// falta volta até ele, que responde MONTADOR_ERRO_MEMORIA. As estruturas só são alteradas
+// depois que a alocação dá certo, então continuam liberáveis; os temporários de uma fase que
+// não pertencem ao contexto são registrados com temporarios_registrar e liberados no retorno.
+typedef struct {
+    jmp_buf ponto;
+    void (*liberar)(void *temporarios); // NULL = a fase atual não tem temporários
+    void *temporarios;
+} RetornoMemoria;
+
+static _Thread_local RetornoMemoria *retorno_memoria; // NULL = linha de comando
+
+// 'finalidade' completa a mensagem da linha de comando ("Memória insuficiente para ...")
+static _Noreturn void memoria_insuficiente(const char *finalidade) {
+    RetornoMemoria *retorno = retorno_memoria;
+    if (retorno == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para %s.\n", finalidade);
+        exit(1);
+    }
+    if (retorno->liberar != NULL) {
+        void (*liberar)(void *) = retorno->liberar;
+        retorno->liberar = NULL;
+        liberar(retorno->temporarios);
+    }
+    longjmp(retorno->ponto, 1);
+}
+
+// Registra os temporários da fase em andamento (NULL, NULL ao terminar a fase)
+static void temporarios_registrar(void (*liberar)(void *), void *temporarios) {
+    if (retorno_memoria == NULL) return;
+    retorno_memoria->liberar = liberar;
+    retorno_memoria->temporarios = temporarios;
+}
+
+// --- Estatísticas (--stats) ---
+// Os tempos de cada fase são medidos apenas quando --stats é usado (na montagem em lote, são
+// somados entre os arquivos). Os contadores do caminho
+// crítico (buscas na tabela de rótulos, instruções por mnemônico, bytes escritos) só existem
+// quando o montador é compilado com -DMONTADOR_ESTATISTICAS; sem essa definição, ESTAT_CONTAR
+// não gera código algum. Os contadores são atômicos relaxados, pois várias threads os somam.
+#define MAXIMO_FASES_ESTATISTICAS 16
+
+typedef struct {
+    const char *nome;
+    double parede, cpu; // Segundos de relógio e de CPU (somando todas as threads)
+} TempoFase;
+
+typedef struct {
+    double parede, cpu;
+} MarcaTempo;
+
+typedef struct {
+    int ativas;                // 1 quando --stats foi pedido
+    TempoFase fases[MAXIMO_FASES_ESTATISTICAS];
+    size_t numero_fases;
+#ifdef MONTADOR_ESTATISTICAS
+    atomic_uint_fast64_t linhas;            // Linhas lidas do fonte
+    atomic_uint_fast64_t instrucoes[256];   // Instruções interpretadas, por índice em tabela_instrucoes
+    atomic_uint_fast64_t buscas_rotulos;    // Buscas e inserções na tabela de rótulos
+    atomic_uint_fast64_t sondagens_rotulos; // Slots examinados nessas buscas
+    atomic_uint_fast64_t bytes_escritos;    // Bytes gravados no arquivo de saída
+#endif
+} Estatisticas;
+
+static Estatisticas estatisticas;
+static pthread_mutex_t trava_fases = PTHREAD_MUTEX_INITIALIZER; // Na montagem em lote, várias threads registram fases
+
+#ifdef MONTADOR_ESTATISTICAS
+#define ESTAT_CONTAR(contador, n) atomic_fetch_add_explicit(&estatisticas.contador, (uint_fast64_t)(n), memory_order_relaxed)
+#else
+#define ESTAT_CONTAR(contador, n) ((void)0)
+#endif
+
+// Marca o início de uma fase (não consulta o relógio se --stats não foi usado)
+static MarcaTempo estatisticas_marcar(void) {
+    MarcaTempo marca = { 0, 0 };
+    if (estatisticas.ativas) {
+        struct timespec parede, cpu;
+        clock_gettime(CLOCK_MONOTONIC, &parede);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+        marca.parede = parede.tv_sec + parede.tv_nsec * 1e-9;
+        marca.cpu = cpu.tv_sec + cpu.tv_nsec * 1e-9;
+    }
+    return marca;
+}
+
+// Soma à fase 'nome' o tempo decorrido desde 'inicio'
+static void estatisticas_fase(const char *nome, MarcaTempo inicio) {
+    if (!estatisticas.ativas) return;
+    MarcaTempo fim = estatisticas_marcar();
+    pthread_mutex_lock(&trava_fases);
+    size_t i = 0;
+    while (i < estatisticas.numero_fases && strcmp(estatisticas.fases[i].nome, nome) != 0) i++;
+    if (i < MAXIMO_FASES_ESTATISTICAS) {
+        if (i == estatisticas.numero_fases) {
+            estatisticas.fases[i].nome = nome;
+            estatisticas.numero_fases++;
+        }
+        estatisticas.fases[i].parede += fim.parede - inicio.parede;
+        estatisticas.fases[i].cpu += fim.cpu - inicio.cpu;
+    }
+    pthread_mutex_unlock(&trava_fases);
+}
+
+// --- Arena para os nomes dos rótulos ---
+// Os nomes são copiados uma única vez para blocos grandes, evitando um malloc por rótulo
+// e permitindo liberar tudo de uma vez ao final da montagem.
+#define TAMANHO_BLOCO_ARENA (64 * 1024)
+
+typedef struct BlocoArena {
+    struct BlocoArena *anterior; // Bloco alocado antes deste (lista encadeada para liberação)
+    size_t usado;                // Bytes já ocupados em 'dados'
+    size_t capacidade;           // Tamanho total de 'dados'
+    char dados[];
+} BlocoArena;
+
+typedef struct {
+    BlocoArena *atual; // Bloco onde as próximas cópias serão feitas
+} Arena;
+
+// Copia 'tamanho' bytes de 'texto' para a arena, acrescentando o terminador nulo
+static const char *arena_copiar_texto(Arena *arena, const char *texto, size_t tamanho) {
+    if (arena->atual == NULL || arena->atual->capacidade - arena->atual->usado < tamanho + 1) {
+        size_t capacidade = TAMANHO_BLOCO_ARENA;
+        if (capacidade < tamanho + 1) capacidade = tamanho + 1; // Nomes gigantes ganham um bloco próprio
+        BlocoArena *bloco = malloc(sizeof(BlocoArena) + capacidade);
+        if (bloco == NULL) memoria_insuficiente("a arena de rótulos");
+        bloco->anterior = arena->atual;
+        bloco->usado = 0;
+        bloco->capacidade = capacidade;
+        arena->atual = bloco;
+    }
+    char *copia = arena->atual->dados + arena->atual->usado;
+    memcpy(copia, texto, tamanho);
+    copia[tamanho] = '\0';
+    arena->atual->usado += tamanho + 1;
+    return copia;
+}
+
+// Libera todos os blocos da arena
+static void arena_liberar(Arena *arena) {
+    while (arena->atual != NULL) {
+        BlocoArena *anterior = arena->atual->anterior;
+        free(arena->atual);
+        arena->atual = anterior;
+    }
+}
+
+// Descarta os textos copiados, mantendo apenas o bloco mais recente para ser reaproveitado
+static void arena_limpar(Arena *arena) {
+    if (arena->atual == NULL) return;
+    BlocoArena *atual = arena->atual;
+    arena->atual = atual->anterior;
+    arena_liberar(arena);
+    atual->anterior = NULL;
+    atual->usado = 0;
+    arena->atual = atual;
+}
+
+// --- Tabela de símbolos (rótulos) ---
+// Tabela hash com endereçamento aberto (sondagem linear). Os rótulos ficam em um vetor denso,
+// na ordem em que foram definidos; a tabela de índices guarda (posição no vetor + 1), com 0
+// indicando um slot vazio. Ambos crescem por duplicação, então não há limite fixo de rótulos
+// nem de tamanho de nome.
+#define CAPACIDADE_INICIAL_ROTULOS 64 // Deve ser potência de 2
 
-// --- Estrutura para armazenar Rótulos ---
-#define MAX_ROTULOS 100 // Número máximo de rótulos que o montador pode lidar
 typedef struct {
-    char nome[50];    // Nome do rótulo
-    int endereco;     // Endereço (em bytes) do rótulo
+    const char *nome;  // Nome do rótulo (armazenado na arena)
+    uint32_t tamanho;  // Comprimento do nome, sem o terminador
+    uint32_t hash;     // Hash do nome, guardado para acelerar o redimensionamento
+    int endereco;      // Endereço (em bytes) do rótulo (-1 = referenciado, mas ainda não definido)
+    uint32_t pendencias; // Montagem em fluxo: última referência ainda não resolvida (índice + 1; 0 = nenhuma)
+    uint32_t global;     // 1 se declarado com .globl (visível para outros objetos na ligação)
+    uint32_t instrucao;  // Montagem em duas passagens: índice, na IR, da instrução que segue o rótulo
+    uint32_t dados;      // 1 se definido na seção .data ('instrucao' é então o índice do item de dados que o segue)
 } Rotulo;
 
-Rotulo rotulos[MAX_ROTULOS];
-int contador_rotulos = 0;
+typedef struct {
+    Rotulo *rotulos;         // Vetor denso de rótulos
+    uint32_t quantidade;     // Rótulos armazenados
+    uint32_t capacidade;     // Capacidade do vetor 'rotulos'
+    uint32_t *indices;       // Slots da tabela hash (índice em 'rotulos' + 1; 0 = vazio)
+    uint32_t mascara;        // Número de slots - 1
+    Arena nomes;             // Armazenamento dos nomes
+} TabelaRotulos;
+
+// Hash FNV-1a de 32 bits
+static uint32_t hash_nome(const char *nome, size_t tamanho) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < tamanho; i++) {
+        hash ^= (uint8_t)nome[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Dobra o número de slots e reinsere os índices existentes
+static void tabela_rotulos_redimensionar(TabelaRotulos *tabela, uint32_t novos_slots) {
+    uint32_t *indices = calloc(novos_slots, sizeof(uint32_t));
+    if (indices == NULL) memoria_insuficiente("a tabela de rótulos");
+    uint32_t mascara = novos_slots - 1;
+    for (uint32_t i = 0; i < tabela->quantidade; i++) {
+        uint32_t slot = tabela->rotulos[i].hash & mascara;
+        while (indices[slot] != 0) slot = (slot + 1) & mascara;
+        indices[slot] = i + 1;
+    }
+    free(tabela->indices);
+    tabela->indices = indices;
+    tabela->mascara = mascara;
+}
+
+// Procura o slot do rótulo; retorna o slot encontrado ou o slot vazio onde ele seria inserido
+static uint32_t tabela_rotulos_sondar(const TabelaRotulos *tabela, const char *nome, size_t tamanho, uint32_t hash) {
+    uint32_t slot = hash & tabela->mascara;
+    ESTAT_CONTAR(buscas_rotulos, 1);
+    ESTAT_CONTAR(sondagens_rotulos, 1);
+    while (tabela->indices[slot] != 0) {
+        const Rotulo *rotulo = &tabela->rotulos[tabela->indices[slot] - 1];
+        if (rotulo->hash == hash && rotulo->tamanho == tamanho && memcmp(rotulo->nome, nome, tamanho) == 0) {
+            break;
+        }
+        slot = (slot + 1) & tabela->mascara;
+        ESTAT_CONTAR(sondagens_rotulos, 1);
+    }
+    return slot;
+}
+
+// Acrescenta um rótulo novo no vetor e no slot vazio 'slot'; retorna sua posição no vetor
+static uint32_t tabela_rotulos_criar(TabelaRotulos *tabela, const char *nome, size_t tamanho, uint32_t hash, uint32_t slot, int endereco) {
+    if (tabela->quantidade == tabela->capacidade) {
+        uint32_t capacidade = tabela->capacidade ? tabela->capacidade * 2 : CAPACIDADE_INICIAL_ROTULOS;
+        Rotulo *novos = realloc(tabela->rotulos, capacidade * sizeof(Rotulo));
+        if (novos == NULL) memoria_insuficiente("a tabela de rótulos");
+        tabela->rotulos = novos;
+        tabela->capacidade = capacidade;
+    }
+
+    uint32_t posicao = tabela->quantidade;
+    Rotulo *rotulo = &tabela->rotulos[posicao];
+    rotulo->nome = arena_copiar_texto(&tabela->nomes, nome, tamanho);
+    rotulo->tamanho = (uint32_t)tamanho;
+    rotulo->hash = hash;
+    rotulo->endereco = endereco;
+    rotulo->pendencias = 0;
+    rotulo->global = 0;
+    rotulo->instrucao = 0;
+    rotulo->dados = 0;
+    tabela->quantidade++;
+    tabela->indices[slot] = tabela->quantidade;
+
+    // Mantém o fator de carga abaixo de 1/2 para que as sondagens continuem curtas
+    if (tabela->quantidade * 2 > tabela->mascara + 1) {
+        tabela_rotulos_redimensionar(tabela, (tabela->mascara + 1) * 2);
+    }
+    return posicao;
+}
+
+// Adiciona (define) um rótulo na tabela. Um rótulo que já existe mas ainda não foi definido
+// (criado por tabela_rotulos_obter, ex.: por .globl) recebe o endereço.
+// Retorna 0 em caso de sucesso ou -1 se o rótulo já estiver definido.
+static int tabela_rotulos_inserir(TabelaRotulos *tabela, const char *nome, size_t tamanho, int endereco) {
+    if (tabela->indices == NULL) {
+        tabela_rotulos_redimensionar(tabela, CAPACIDADE_INICIAL_ROTULOS);
+    }
+    uint32_t hash = hash_nome(nome, tamanho);
+    uint32_t slot = tabela_rotulos_sondar(tabela, nome, tamanho, hash);
+    if (tabela->indices[slot] != 0) {
+        Rotulo *existente = &tabela->rotulos[tabela->indices[slot] - 1];
+        if (existente->endereco != -1) return -1; // Rótulo duplicado
+        existente->endereco = endereco;
+        return 0;
+    }
+    tabela_rotulos_criar(tabela, nome, tamanho, hash, slot, endereco);
+    return 0;
+}
+
+// Retorna a posição do rótulo no vetor, criando-o ainda indefinido (endereço -1) se ele não existir.
+// Usada pela montagem em fluxo, em que um rótulo pode ser referenciado antes de ser definido.
+static uint32_t tabela_rotulos_obter(TabelaRotulos *tabela, const char *nome, size_t tamanho) {
+    if (tabela->indices == NULL) {
+        tabela_rotulos_redimensionar(tabela, CAPACIDADE_INICIAL_ROTULOS);
+    }
+    uint32_t hash = hash_nome(nome, tamanho);
+    uint32_t slot = tabela_rotulos_sondar(tabela, nome, tamanho, hash);
+    if (tabela->indices[slot] != 0) return tabela->indices[slot] - 1;
+    return tabela_rotulos_criar(tabela, nome, tamanho, hash, slot, -1);
+}
+
+// Busca o endereço de um rótulo. Retorna -1 se o rótulo não for encontrado.
+static int tabela_rotulos_buscar(const TabelaRotulos *tabela, const char *nome, size_t tamanho) {
+    if (tabela->indices == NULL) return -1;
+    uint32_t slot = tabela_rotulos_sondar(tabela, nome, tamanho, hash_nome(nome, tamanho));
+    if (tabela->indices[slot] == 0) return -1; // Rótulo não encontrado
+    return tabela->rotulos[tabela->indices[slot] - 1].endereco;
+}
+
+// Esvazia a tabela, mantendo a memória já alocada para a próxima montagem
+static void tabela_rotulos_limpar(TabelaRotulos *tabela) {
+    if (tabela->indices != NULL) memset(tabela->indices, 0, ((size_t)tabela->mascara + 1) * sizeof(uint32_t));
+    tabela->quantidade = 0;
+    arena_limpar(&tabela->nomes);
+}
+
+// Libera toda a memória da tabela e a deixa pronta para ser reutilizada
+static void tabela_rotulos_liberar(TabelaRotulos *tabela) {
+    free(tabela->rotulos);
+    free(tabela->indices);
+    arena_liberar(&tabela->nomes);
+    memset(tabela, 0, sizeof(*tabela));
+}
+
+// --- Analisador Léxico ---
+// As linhas são lidas direto do fonte, sem cópias: cada token é um trecho (início e tamanho)
+// do próprio texto, e uma linha pode ter qualquer tamanho. O texto é classificado em blocos
+// de 64 bytes, e cada classe de caractere vira uma máscara com um bit por byte; achar o fim
+// de um token, o início de um comentário ou o fim da linha é então contar os zeros à direita
+// de uma máscara. A classificação usa AVX2 ou SSE2, conforme o processador (escolhido por
+// inicializar_analisador_lexico), ou uma tabela, e nunca lê além do fim do texto.
+#define TAMANHO_BLOCO_LEXICO 64
+
+enum {
+    CLASSE_SEPARADOR   = 1 << 0, // Espaço, tabulação, vírgula e '\r'
+    CLASSE_COMENTARIO  = 1 << 1, // '#', ';' e '\0': o resto da linha é ignorado
+    CLASSE_QUEBRA      = 1 << 2, // '\n' e todas as posições além do fim do texto
+    CLASSE_DOIS_PONTOS = 1 << 3, // ':', que encerra o nome de um rótulo
+    CLASSE_UTIL        = 1 << 4  // Só para as buscas: qualquer byte que não seja separador
+};
+
+typedef struct {
+    const char *texto; // NULL = a linha não tem mais tokens
+    uint32_t tamanho;
+} Token;
+
+#define TOKEN_LITERAL(texto) ((Token){ (texto), sizeof(texto) - 1 })
+
+typedef struct {
+    const char *posicao; // Próximo byte a examinar
+    const char *fim;     // Fim do texto
+    const char *bloco;   // Início do bloco classificado
+    uint64_t separadores, comentarios, quebras, dois_pontos; // Um bit por byte do bloco
+} Lexico;
+
+static const uint8_t classes_lexicas[256] = {
+    [' '] = CLASSE_SEPARADOR, ['\t'] = CLASSE_SEPARADOR, [','] = CLASSE_SEPARADOR, ['\r'] = CLASSE_SEPARADOR,
+    ['#'] = CLASSE_COMENTARIO, [';'] = CLASSE_COMENTARIO, ['\0'] = CLASSE_COMENTARIO,
+    ['\n'] = CLASSE_QUEBRA, [':'] = CLASSE_DOIS_PONTOS,
+};
+
+// Classifica os 'tamanho' (até 64) bytes a partir de 'bloco'; as posições seguintes contam como quebras
+static void classificar_bloco_escalar(Lexico *lexico, const char *bloco, size_t tamanho) {
+    uint64_t separadores = 0, comentarios = 0, quebras = 0, dois_pontos = 0;
+    for (size_t i = 0; i < tamanho; i++) {
+        unsigned classe = classes_lexicas[(uint8_t)bloco[i]];
+        separadores |= (uint64_t)(classe & 1) << i;
+        comentarios |= (uint64_t)(classe >> 1 & 1) << i;
+        quebras |= (uint64_t)(classe >> 2 & 1) << i;
+        dois_pontos |= (uint64_t)(classe >> 3 & 1) << i;
+    }
+    if (tamanho < TAMANHO_BLOCO_LEXICO) quebras |= ~0ull << tamanho;
+    lexico->separadores = separadores;
+    lexico->comentarios = comentarios;
+    lexico->quebras = quebras;
+    lexico->dois_pontos = dois_pontos;
+}
+
+static void classificar_bloco_tabela(Lexico *lexico, const char *bloco) {
+    classificar_bloco_escalar(lexico, bloco, TAMANHO_BLOCO_LEXICO);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+static void classificar_bloco_sse2(Lexico *lexico, const char *bloco) {
+    uint64_t separadores = 0, comentarios = 0, quebras = 0, dois_pontos = 0;
+    for (int i = 0; i < TAMANHO_BLOCO_LEXICO; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(bloco + i));
+        __m128i separador = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(',')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i comentario = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')), _mm_cmpeq_epi8(v, _mm_set1_epi8(';'))),
+                                          _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        separadores |= (uint64_t)(uint16_t)_mm_movemask_epi8(separador) << i;
+        comentarios |= (uint64_t)(uint16_t)_mm_movemask_epi8(comentario) << i;
+        quebras |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))) << i;
+        dois_pontos |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(':'))) << i;
+    }
+    lexico->separadores = separadores;
+    lexico->comentarios = comentarios;
+    lexico->quebras = quebras;
+    lexico->dois_pontos = dois_pontos;
+}
+
+__attribute__((target("avx2")))
+static void classificar_bloco_avx2(Lexico *lexico, const char *bloco) {
+    uint64_t separadores = 0, comentarios = 0, quebras = 0, dois_pontos = 0;
+    for (int i = 0; i < TAMANHO_BLOCO_LEXICO; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(bloco + i));
+        __m256i separador = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        __m256i comentario = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('#')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(';'))),
+                                             _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        separadores |= (uint64_t)(uint32_t)_mm256_movemask_epi8(separador) << i;
+        comentarios |= (uint64_t)(uint32_t)_mm256_movemask_epi8(comentario) << i;
+        quebras |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))) << i;
+        dois_pontos |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':'))) << i;
+    }
+    lexico->separadores = separadores;
+    lexico->comentarios = comentarios;
+    lexico->quebras = quebras;
+    lexico->dois_pontos = dois_pontos;
+}
+#endif
+
+// Classificação dos blocos completos (de 64 bytes); os do fim do texto usam sempre a tabela
+static void (*classificar_bloco)(Lexico *lexico, const char *bloco) = classificar_bloco_tabela;
+
+// Escolhe a classificação vetorial suportada pelo processador. Deve ser chamada antes de
+// qualquer montagem (sem ela, usa-se a tabela).
+static void inicializar_analisador_lexico(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) classificar_bloco = classificar_bloco_avx2;
+    else if (__builtin_cpu_supports("sse2")) classificar_bloco = classificar_bloco_sse2;
+#endif
+}
+
+static void lexico_classificar(Lexico *lexico, const char *bloco) {
+    size_t restante = (size_t)(lexico->fim - bloco);
+    lexico->bloco = bloco;
+    if (restante >= TAMANHO_BLOCO_LEXICO) classificar_bloco(lexico, bloco);
+    else classificar_bloco_escalar(lexico, bloco, restante);
+}
+
+// Prepara a leitura das linhas de [inicio, fim)
+static void lexico_iniciar(Lexico *lexico, const char *inicio, const char *fim) {
+    lexico->posicao = inicio;
+    lexico->fim = fim;
+    lexico_classificar(lexico, inicio);
+}
+
+static inline uint64_t lexico_mascara(const Lexico *lexico, unsigned classes) {
+    uint64_t mascara = 0;
+    if (classes & CLASSE_SEPARADOR) mascara |= lexico->separadores;
+    if (classes & CLASSE_COMENTARIO) mascara |= lexico->comentarios;
+    if (classes & CLASSE_QUEBRA) mascara |= lexico->quebras;
+    if (classes & CLASSE_DOIS_PONTOS) mascara |= lexico->dois_pontos;
+    if (classes & CLASSE_UTIL) mascara |= ~lexico->separadores;
+    return mascara;
+}
+
+// Retorna o primeiro byte, a partir de 'p', de uma das 'classes'. Toda busca inclui
+// CLASSE_QUEBRA ou CLASSE_UTIL, então sempre para no fim do texto, no máximo.
+static inline const char *lexico_buscar(Lexico *lexico, const char *p, unsigned classes) {
+    for (;;) {
+        size_t desvio = (size_t)(p - lexico->bloco);
+        if (desvio >= TAMANHO_BLOCO_LEXICO) { // Fora do bloco classificado (antes ou depois dele)
+            lexico_classificar(lexico, p);
+            desvio = 0;
+        }
+        uint64_t mascara = lexico_mascara(lexico, classes) & (~0ull << desvio);
+        if (mascara != 0) return lexico->bloco + __builtin_ctzll(mascara);
+        p = lexico->bloco + TAMANHO_BLOCO_LEXICO;
+    }
+}
+
+// Verifica se o byte 'p', do bloco classificado, é de uma das 'classes'
+static inline int lexico_eh(const Lexico *lexico, const char *p, unsigned classes) {
+    return (int)(lexico_mascara(lexico, classes) >> (p - lexico->bloco) & 1);
+}
+
+// Posiciona o léxico no primeiro byte útil da linha atual e o retorna, ou retorna NULL se a
+// linha está vazia ou só tem comentário
+static const char *lexico_linha(Lexico *lexico) {
+    const char *inicio = lexico_buscar(lexico, lexico->posicao, CLASSE_UTIL);
+    lexico->posicao = inicio;
+    return lexico_eh(lexico, inicio, CLASSE_COMENTARIO | CLASSE_QUEBRA) ? NULL : inicio;
+}
+
+// Avança o léxico para o início da linha seguinte (ou para o fim do texto)
+static void lexico_proxima_linha(Lexico *lexico) {
+    const char *quebra = lexico_buscar(lexico, lexico->posicao, CLASSE_QUEBRA);
+    lexico->posicao = quebra < lexico->fim ? quebra + 1 : lexico->fim;
+}
+
+// Lê o próximo token da linha. No fim da linha (ou no início de um comentário), retorna um
+// token com texto NULL e continua lá.
+static Token lexico_proximo(Lexico *lexico) {
+    const char *inicio = lexico_buscar(lexico, lexico->posicao, CLASSE_UTIL);
+    lexico->posicao = inicio;
+    if (lexico_eh(lexico, inicio, CLASSE_COMENTARIO | CLASSE_QUEBRA)) return (Token){ NULL, 0 };
+    lexico->posicao = lexico_buscar(lexico, inicio, CLASSE_SEPARADOR | CLASSE_COMENTARIO | CLASSE_QUEBRA);
+    return (Token){ inicio, (uint32_t)(lexico->posicao - inicio) };
+}
+
+// Lê o nome do rótulo definido no início da linha: o primeiro token, até o ':' (o que vem
+// depois dele no mesmo token é descartado). Se o primeiro token não tem ':', não consome
+// nada e retorna um token com texto NULL.
+static Token lexico_rotulo(Lexico *lexico) {
+    const char *inicio = lexico_buscar(lexico, lexico->posicao, CLASSE_UTIL);
+    const char *fim = lexico_buscar(lexico, inicio, CLASSE_DOIS_PONTOS | CLASSE_SEPARADOR | CLASSE_COMENTARIO | CLASSE_QUEBRA);
+    if (!lexico_eh(lexico, fim, CLASSE_DOIS_PONTOS)) {
+        lexico->posicao = inicio;
+        return (Token){ NULL, 0 };
+    }
+    lexico->posicao = lexico_buscar(lexico, fim, CLASSE_SEPARADOR | CLASSE_COMENTARIO | CLASSE_QUEBRA);
+    return (Token){ inicio, (uint32_t)(fim - inicio) };
+}
+
+// Compara um token com um texto terminado em '\0'
+static int token_igual(Token token, const char *texto) {
+    size_t tamanho = strlen(texto);
+    return token.texto != NULL && token.tamanho == tamanho && memcmp(token.texto, texto, tamanho) == 0;
+}
+
+// --- Funções Auxiliares ---
+// --- Decodificação de registradores ---
+// Os nomes ABI têm no máximo 4 caracteres, então cabem empacotados em um uint32_t
+// (little-endian, primeiro caractere no byte menos significativo). Um hash multiplicativo
+// desse valor leva cada um dos 33 nomes ABI a um slot distinto de uma tabela com 64
+// posições (hash perfeito), e a confirmação é uma única comparação de inteiros.
+// O multiplicador e a tabela abaixo foram gerados fora do montador para esse conjunto de nomes.
+#define MULTIPLICADOR_HASH_REGISTRADORES 0x5EDA92D9u
+#define BITS_HASH_REGISTRADORES 6
+
+typedef struct {
+    uint32_t chave; // Nome empacotado (0 = slot vazio)
+    int numero;     // Número do registrador (0-31)
+} SlotRegistrador;
+
+static const SlotRegistrador slots_registradores[1 << BITS_HASH_REGISTRADORES] = {
+    [ 0] = { 0x00003473u, 20 }, // s4
+    [ 2] = { 0x00003661u, 16 }, // a6
+    [ 3] = { 0x00006172u,  1 }, // ra
+    [ 5] = { 0x00003674u, 31 }, // t6
+    [ 9] = { 0x00003373u, 19 }, // s3
+    [12] = { 0x00003561u, 15 }, // a5
+    [14] = { 0x00003574u, 30 }, // t5
+    [15] = { 0x00007073u,  2 }, // sp
+    [17] = { 0x00003973u, 25 }, // s9
+    [19] = { 0x00003273u, 18 }, // s2
+    [21] = { 0x00003461u, 14 }, // a4
+    [24] = { 0x00003474u, 29 }, // t4
+    [26] = { 0x00007066u,  8 }, // fp
+    [27] = { 0x00003873u, 24 }, // s8
+    [28] = { 0x00003173u,  9 }, // s1
+    [31] = { 0x00003361u, 13 }, // a3
+    [33] = { 0x00003374u, 28 }, // t3
+    [35] = { 0x00313173u, 27 }, // s11
+    [36] = { 0x00003773u, 23 }, // s7
+    [37] = { 0x00003073u,  8 }, // s0
+    [38] = { 0x00007074u,  4 }, // tp
+    [40] = { 0x00003261u, 12 }, // a2
+    [42] = { 0x00003274u,  7 }, // t2
+    [45] = { 0x00003673u, 22 }, // s6
+    [49] = { 0x00003161u, 11 }, // a1
+    [50] = { 0x00007067u,  3 }, // gp
+    [52] = { 0x00003174u,  6 }, // t1
+    [55] = { 0x00003573u, 21 }, // s5
+    [57] = { 0x00003761u, 17 }, // a7
+    [58] = { 0x6F72657Au,  0 }, // zero
+    [59] = { 0x00003061u, 10 }, // a0
+    [61] = { 0x00003074u,  5 }, // t0
+    [62] = { 0x00303173u, 26 }, // s10
+};
+
+// Converte o nome de um registrador (ABI ou xN) para seu número (0-31).
+// Retorna -1 para nomes inválidos, como "x32", "x3a", "x01" ou "t7".
+static int obter_numero_registrador(Token nome_reg) {
+    // Nomes vazios ou com mais de 4 caracteres não são registradores
+    if (nome_reg.texto == NULL || nome_reg.tamanho == 0 || nome_reg.tamanho > 4) return -1;
+    const char *nome = nome_reg.texto;
+    uint32_t tamanho = nome_reg.tamanho;
+
+    // Forma "xN": N de 0 a 31, sem zeros à esquerda
+    if (nome[0] == 'x') {
+        unsigned d1 = (uint8_t)nome[1] - '0';
+        if (tamanho == 2) return d1 <= 9 ? (int)d1 : -1;
+        if (tamanho == 3) {
+            unsigned d2 = (uint8_t)nome[2] - '0';
+            unsigned numero = d1 * 10 + d2;
+            return (d1 >= 1 && d1 <= 3 && d2 <= 9 && numero <= 31) ? (int)numero : -1;
+        }
+        return -1;
+    }
+
+    // Nomes ABI (incluindo "fp", alias de s0), empacotados
+    uint32_t chave = 0;
+    for (uint32_t i = 0; i < tamanho; i++) chave |= (uint32_t)(uint8_t)nome[i] << (8 * i);
+    const SlotRegistrador *slot = &slots_registradores[(chave * MULTIPLICADOR_HASH_REGISTRADORES) >> (32 - BITS_HASH_REGISTRADORES)];
+    return slot->chave == chave ? slot->numero : -1;
+}
+
+// Converte um imediato em texto (decimal, hexadecimal com 0x ou octal com 0), com sinal
+// opcional, para inteiro, com as mesmas regras do strtol (valores grandes demais saturam).
+// Retorna 0 em caso de sucesso ou -1 se o texto não for um número completo.
+static int converter_imediato(Token texto, long *valor) {
+    const char *p = texto.texto, *fim = texto.texto + texto.tamanho;
+    if (p == NULL || p == fim) return -1;
+    int negativo = *p == '-';
+    if (*p == '-' || *p == '+') p++;
+    unsigned base = 10;
+    if (fim - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    } else if (p < fim && p[0] == '0') {
+        base = 8;
+    }
+    if (p == fim) return -1;
+
+    unsigned long limite = negativo ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    unsigned long acumulado = 0;
+    for (; p < fim; p++) {
+        unsigned digito = (uint8_t)*p;
+        if (digito - '0' <= 9) digito -= '0';
+        else if ((digito | 0x20) - 'a' <= 'z' - 'a') digito = (digito | 0x20) - 'a' + 10;
+        else return -1;
+        if (digito >= base) return -1;
+        acumulado = acumulado > (limite - digito) / base ? limite : acumulado * base + digito;
+    }
+    *valor = negativo ? (long)(0 - acumulado) : (long)acumulado;
+    return 0;
+}
+
+// Separa um operando no formato "offset(rs1)" em suas duas partes. Um offset vazio, como em
+// "(sp)", é tratado como 0. O offset pode conter parênteses, como em "%lo(rotulo)(a0)".
+// Retorna -1 se o formato for inválido.
+static int separar_deslocamento_registrador(Token texto, Token *offset_txt, Token *rs1_txt) {
+    if (texto.texto == NULL) return -1;
+    const char *fim = texto.texto + texto.tamanho;
+    const char *abre_parenteses = fim;
+    while (abre_parenteses > texto.texto && abre_parenteses[-1] != '(') abre_parenteses--;
+    if (abre_parenteses-- == texto.texto) return -1;
+    const char *fecha_parenteses = memchr(abre_parenteses + 1, ')', (size_t)(fim - abre_parenteses - 1));
+    if (fecha_parenteses == NULL || fecha_parenteses + 1 != fim) return -1;
+    *offset_txt = (abre_parenteses == texto.texto) ? TOKEN_LITERAL("0") : (Token){ texto.texto, (uint32_t)(abre_parenteses - texto.texto) };
+    *rs1_txt = (Token){ abre_parenteses + 1, (uint32_t)(fecha_parenteses - abre_parenteses - 1) };
+    return 0;
+}
+
+// Converte um número decimal para uma string binária com um número específico de bits
+static void dec_para_bin_n_bits(int num_bits, int decimal, char *string_binaria) {
+    for (int i = num_bits - 1; i >= 0; i--) {
+        string_binaria[num_bits - 1 - i] = ((decimal >> i) & 1) ? '1' : '0';
+    }
+    string_binaria[num_bits] = '\0'; // Terminador nulo
+}
+
+// --- Tabela de Instruções ---
+// Cada instrução suportada é uma linha desta tabela: o formato define qual rotina de codificação
+// é usada e a forma dos operandos define como a linha de assembly é interpretada.
+// Acrescentar uma instrução ao montador é apenas acrescentar uma linha aqui.
+typedef enum {
+    FORMATO_R, // funct7 | rs2 | rs1 | funct3 | rd | opcode
+    FORMATO_I, // imm[11:0] | rs1 | funct3 | rd | opcode
+    FORMATO_S, // imm[11:5] | rs2 | rs1 | funct3 | imm[4:0] | opcode
+    FORMATO_B, // imm[12] | imm[10:5] | rs2 | rs1 | funct3 | imm[4:1] | imm[11] | opcode
+    FORMATO_U, // imm[31:12] | rd | opcode
+    FORMATO_J  // imm[20] | imm[10:1] | imm[11] | imm[19:12] | rd | opcode
+} FormatoInstrucao;
+
+typedef enum {
+    OPERANDOS_RD_RS1_RS2,     // add rd, rs1, rs2
+    OPERANDOS_RD_RS1_IMM,     // addi rd, rs1, imm
+    OPERANDOS_RD_RS1_SHAMT,   // slli rd, rs1, shamt (funct7 vai para imm[11:5])
+    OPERANDOS_RD_OFFSET_RS1,  // lw rd, offset(rs1)
+    OPERANDOS_RS2_OFFSET_RS1, // sw rs2, offset(rs1)
+    OPERANDOS_RS1_RS2_ROTULO, // beq rs1, rs2, rotulo
+    OPERANDOS_RD_IMM20,       // lui rd, imm
+    OPERANDOS_RD_ROTULO,      // jal rd, rotulo
+    OPERANDOS_JALR,           // jalr rd, rs1, offset | jalr rd, offset(rs1) | jalr rd, rs1 | jalr rs1
+    OPERANDOS_NENHUM,         // ecall (funct7 guarda o imediato fixo de 12 bits; 'fixo' é o rs1, ex.: ret)
+    // Formas exclusivas das pseudoinstruções
+    OPERANDOS_RD_RS1_FIXO,    // mv rd, rs (o imediato, ou o rs2 no tipo R, é 'fixo')
+    OPERANDOS_RD_RS2,         // neg rd, rs (rs1 = x0)
+    OPERANDOS_RS1_ROTULO,     // beqz rs, rotulo (rs2 = x0)
+    OPERANDOS_RS2_ROTULO,     // blez rs, rotulo (rs1 = x0)
+    OPERANDOS_RS2_RS1_ROTULO, // bgt rs, rt, rotulo (operandos trocados: blt rt, rs)
+    OPERANDOS_ROTULO,         // j rotulo (rd = 'fixo')
+    OPERANDOS_RS1,            // jr rs (rd = 'fixo')
+    OPERANDOS_RD_IMM32,       // li rd, imm (addi, lui ou lui + addi)
+    OPERANDOS_RD_SIMBOLO      // la rd, rotulo (lui + addi)
+} FormaOperandos;
+
+typedef struct {
+    const char *mnemonico;
+    FormatoInstrucao formato;
+    uint8_t opcode;
+    uint8_t funct3;
+    uint8_t funct7;
+    FormaOperandos operandos;
+    int8_t fixo;    // Pseudoinstruções: registrador ou imediato fixo, conforme a forma dos operandos
+} DescritorInstrucao;
+
+static const DescritorInstrucao tabela_instrucoes[] = {
+    // --- RV32I: tipo R ---
+    { "add",    FORMATO_R, 0b0110011, 0b000, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "sub",    FORMATO_R, 0b0110011, 0b000, 0b0100000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "sll",    FORMATO_R, 0b0110011, 0b001, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "slt",    FORMATO_R, 0b0110011, 0b010, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "sltu",   FORMATO_R, 0b0110011, 0b011, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "xor",    FORMATO_R, 0b0110011, 0b100, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "srl",    FORMATO_R, 0b0110011, 0b101, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "sra",    FORMATO_R, 0b0110011, 0b101, 0b0100000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "or",     FORMATO_R, 0b0110011, 0b110, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    { "and",    FORMATO_R, 0b0110011, 0b111, 0b0000000, OPERANDOS_RD_RS1_RS2, 0 },
+    // --- Extensão M ---
+    { "mul",    FORMATO_R, 0b0110011, 0b000, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "mulh",   FORMATO_R, 0b0110011, 0b001, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "mulhsu", FORMATO_R, 0b0110011, 0b010, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "mulhu",  FORMATO_R, 0b0110011, 0b011, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "div",    FORMATO_R, 0b0110011, 0b100, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "divu",   FORMATO_R, 0b0110011, 0b101, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "rem",    FORMATO_R, 0b0110011, 0b110, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    { "remu",   FORMATO_R, 0b0110011, 0b111, 0b0000001, OPERANDOS_RD_RS1_RS2, 0 },
+    // --- RV32I: tipo I (aritméticas com imediato) ---
+    { "addi",   FORMATO_I, 0b0010011, 0b000, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "slti",   FORMATO_I, 0b0010011, 0b010, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "sltiu",  FORMATO_I, 0b0010011, 0b011, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "xori",   FORMATO_I, 0b0010011, 0b100, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "ori",    FORMATO_I, 0b0010011, 0b110, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "andi",   FORMATO_I, 0b0010011, 0b111, 0b0000000, OPERANDOS_RD_RS1_IMM, 0 },
+    { "slli",   FORMATO_I, 0b0010011, 0b001, 0b0000000, OPERANDOS_RD_RS1_SHAMT, 0 },
+    { "srli",   FORMATO_I, 0b0010011, 0b101, 0b0000000, OPERANDOS_RD_RS1_SHAMT, 0 },
+    { "srai",   FORMATO_I, 0b0010011, 0b101, 0b0100000, OPERANDOS_RD_RS1_SHAMT, 0 },
+    // --- RV32I: tipo I (loads, jalr e sistema) ---
+    { "lb",     FORMATO_I, 0b0000011, 0b000, 0b0000000, OPERANDOS_RD_OFFSET_RS1, 0 },
+    { "lh",     FORMATO_I, 0b0000011, 0b001, 0b0000000, OPERANDOS_RD_OFFSET_RS1, 0 },
+    { "lw",     FORMATO_I, 0b0000011, 0b010, 0b0000000, OPERANDOS_RD_OFFSET_RS1, 0 },
+    { "lbu",    FORMATO_I, 0b0000011, 0b100, 0b0000000, OPERANDOS_RD_OFFSET_RS1, 0 },
+    { "lhu",    FORMATO_I, 0b0000011, 0b101, 0b0000000, OPERANDOS_RD_OFFSET_RS1, 0 },
+    { "jalr",   FORMATO_I, 0b1100111, 0b000, 0b0000000, OPERANDOS_JALR, 0 },
+    { "ecall",  FORMATO_I, 0b1110011, 0b000, 0b0000000, OPERANDOS_NENHUM, 0 },
+    { "ebreak", FORMATO_I, 0b1110011, 0b000, 0b0000001, OPERANDOS_NENHUM, 0 },
+    // --- RV32I: tipo S ---
+    { "sb",     FORMATO_S, 0b0100011, 0b000, 0b0000000, OPERANDOS_RS2_OFFSET_RS1, 0 },
+    { "sh",     FORMATO_S, 0b0100011, 0b001, 0b0000000, OPERANDOS_RS2_OFFSET_RS1, 0 },
+    { "sw",     FORMATO_S, 0b0100011, 0b010, 0b0000000, OPERANDOS_RS2_OFFSET_RS1, 0 },
+    // --- RV32I: tipo B ---
+    { "beq",    FORMATO_B, 0b1100011, 0b000, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    { "bne",    FORMATO_B, 0b1100011, 0b001, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    { "blt",    FORMATO_B, 0b1100011, 0b100, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    { "bge",    FORMATO_B, 0b1100011, 0b101, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    { "bltu",   FORMATO_B, 0b1100011, 0b110, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    { "bgeu",   FORMATO_B, 0b1100011, 0b111, 0b0000000, OPERANDOS_RS1_RS2_ROTULO, 0 },
+    // --- RV32I: tipo U ---
+    { "lui",    FORMATO_U, 0b0110111, 0b000, 0b0000000, OPERANDOS_RD_IMM20, 0 },
+    { "auipc",  FORMATO_U, 0b0010111, 0b000, 0b0000000, OPERANDOS_RD_IMM20, 0 },
+    // --- RV32I: tipo J ---
+    { "jal",    FORMATO_J, 0b1101111, 0b000, 0b0000000, OPERANDOS_RD_ROTULO, 0 },
+    // --- Pseudoinstruções: os campos são os da instrução real em que cada uma se transforma ---
+    { "nop",    FORMATO_I, 0b0010011, 0b000, 0b0000000, OPERANDOS_NENHUM, 0 },            // addi x0, x0, 0
+    { "li",     FORMATO_I, 0b0010011, 0b000, 0b0000000, OPERANDOS_RD_IMM32, 0 },          // addi | lui | lui + addi
+    { "la",     FORMATO_U, 0b0110111, 0b000, 0b0000000, OPERANDOS_RD_SIMBOLO, 0 },        // lui + addi
+    { "mv",     FORMATO_I, 0b0010011, 0b000, 0b0000000, OPERANDOS_RD_RS1_FIXO, 0 },       // addi rd, rs, 0
+    { "not",    FORMATO_I, 0b0010011, 0b100, 0b0000000, OPERANDOS_RD_RS1_FIXO, -1 },      // xori rd, rs, -1
+    { "seqz",   FORMATO_I, 0b0010011, 0b011, 0b0000000, OPERANDOS_RD_RS1_FIXO, 1 },       // sltiu rd, rs, 1
+    { "sltz",   FORMATO_R, 0b0110011, 0b010, 0b0000000, OPERANDOS_RD_RS1_FIXO, 0 },       // slt rd, rs, x0
+    { "neg",    FORMATO_R, 0b0110011, 0b000, 0b0100000, OPERANDOS_RD_RS2, 0 },            // sub rd, x0, rs
+    { "snez",   FORMATO_R, 0b0110011, 0b011, 0b0000000, OPERANDOS_RD_RS2, 0 },            // sltu rd, x0, rs
+    { "sgtz",   FORMATO_R, 0b0110011, 0b010, 0b0000000, OPERANDOS_RD_RS2, 0 },            // slt rd, x0, rs
+    { "beqz",   FORMATO_B, 0b1100011, 0b000, 0b0000000, OPERANDOS_RS1_ROTULO, 0 },        // beq rs, x0, rotulo
+    { "bnez",   FORMATO_B, 0b1100011, 0b001, 0b0000000, OPERANDOS_RS1_ROTULO, 0 },        // bne rs, x0, rotulo
+    { "bltz",   FORMATO_B, 0b1100011, 0b100, 0b0000000, OPERANDOS_RS1_ROTULO, 0 },        // blt rs, x0, rotulo
+    { "bgez",   FORMATO_B, 0b1100011, 0b101, 0b0000000, OPERANDOS_RS1_ROTULO, 0 },        // bge rs, x0, rotulo
+    { "bgtz",   FORMATO_B, 0b1100011, 0b100, 0b0000000, OPERANDOS_RS2_ROTULO, 0 },        // blt x0, rs, rotulo
+    { "blez",   FORMATO_B, 0b1100011, 0b101, 0b0000000, OPERANDOS_RS2_ROTULO, 0 },        // bge x0, rs, rotulo
+    { "bgt",    FORMATO_B, 0b1100011, 0b100, 0b0000000, OPERANDOS_RS2_RS1_ROTULO, 0 },    // blt rt, rs, rotulo
+    { "ble",    FORMATO_B, 0b1100011, 0b101, 0b0000000, OPERANDOS_RS2_RS1_ROTULO, 0 },    // bge rt, rs, rotulo
+    { "bgtu",   FORMATO_B, 0b1100011, 0b110, 0b0000000, OPERANDOS_RS2_RS1_ROTULO, 0 },    // bltu rt, rs, rotulo
+    { "bleu",   FORMATO_B, 0b1100011, 0b111, 0b0000000, OPERANDOS_RS2_RS1_ROTULO, 0 },    // bgeu rt, rs, rotulo
+    { "j",      FORMATO_J, 0b1101111, 0b000, 0b0000000, OPERANDOS_ROTULO, 0 },            // jal x0, rotulo
+    { "call",   FORMATO_J, 0b1101111, 0b000, 0b0000000, OPERANDOS_ROTULO, 1 },            // jal ra, rotulo
+    { "tail",   FORMATO_J, 0b1101111, 0b000, 0b0000000, OPERANDOS_ROTULO, 0 },            // jal x0, rotulo
+    { "jr",     FORMATO_I, 0b1100111, 0b000, 0b0000000, OPERANDOS_RS1, 0 },               // jalr x0, 0(rs)
+    { "ret",    FORMATO_I, 0b1100111, 0b000, 0b0000000, OPERANDOS_NENHUM, 1 },            // jalr x0, 0(ra)
+};
+
+#define NUMERO_INSTRUCOES (sizeof(tabela_instrucoes) / sizeof(tabela_instrucoes[0]))
+
+// --- Hash perfeito dos mnemônicos ---
+// Na inicialização procuramos uma semente para a qual nenhum mnemônico da tabela colide.
+// A busca de um mnemônico custa então um hash, um acesso e um strcmp, independentemente
+// de quantas instruções existem.
+#define SLOTS_HASH_MNEMONICOS 256 // Potência de 2, bem maior que NUMERO_INSTRUCOES
+
+static uint32_t semente_hash_mnemonicos;
+static uint8_t slots_mnemonicos[SLOTS_HASH_MNEMONICOS]; // Índice na tabela + 1 (0 = vazio)
+
+static uint32_t hash_mnemonico(Token mnemonico, uint32_t semente) {
+    uint32_t hash = semente;
+    for (uint32_t i = 0; i < mnemonico.tamanho; i++) {
+        hash = (hash ^ (uint8_t)mnemonico.texto[i]) * 16777619u;
+    }
+    hash ^= hash >> 15;
+    return hash & (SLOTS_HASH_MNEMONICOS - 1);
+}
+
+// Monta a tabela de slots do hash perfeito. Deve ser chamada antes de qualquer montagem.
+static void inicializar_tabela_instrucoes(void) {
+    _Static_assert(NUMERO_INSTRUCOES < 255, "slots_mnemonicos guarda índices em 8 bits");
+    for (uint32_t semente = 1; semente != 0; semente++) {
+        memset(slots_mnemonicos, 0, sizeof(slots_mnemonicos));
+        size_t i;
+        for (i = 0; i < NUMERO_INSTRUCOES; i++) {
+            const char *mnemonico = tabela_instrucoes[i].mnemonico;
+            uint32_t slot = hash_mnemonico((Token){ mnemonico, (uint32_t)strlen(mnemonico) }, semente);
+            if (slots_mnemonicos[slot] != 0) break; // Colisão: tenta a próxima semente
+            slots_mnemonicos[slot] = (uint8_t)(i + 1);
+        }
+        if (i == NUMERO_INSTRUCOES) {
+            semente_hash_mnemonicos = semente;
+            return;
+        }
+    }
+    fprintf(stderr, "Erro interno: Não foi possível gerar o hash perfeito dos mnemônicos.\n");
+    exit(1);
+}
+
+// Retorna o descritor da instrução ou NULL se o mnemônico não for suportado
+static const DescritorInstrucao *buscar_instrucao_token(Token mnemonico) {
+    uint8_t indice = slots_mnemonicos[hash_mnemonico(mnemonico, semente_hash_mnemonicos)];
+    if (indice == 0) return NULL;
+    const DescritorInstrucao *descritor = &tabela_instrucoes[indice - 1];
+    return token_igual(mnemonico, descritor->mnemonico) ? descritor : NULL;
+}
+
+static const DescritorInstrucao *buscar_instrucao(const char *mnemonico) {
+    return buscar_instrucao_token((Token){ mnemonico, (uint32_t)strlen(mnemonico) });
+}
+
+// --- Codificadores por formato ---
+// Recebem operandos já validados; 'imm' é o imediato (ou deslocamento em bytes) completo.
+static uint32_t codificar_r(const DescritorInstrucao *d, int rd, int rs1, int rs2) {
+    return ((uint32_t)d->funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (d->funct3 << 12) | (rd << 7) | d->opcode;
+}
+
+static uint32_t codificar_i(const DescritorInstrucao *d, int rd, int rs1, int32_t imm) {
+    return ((uint32_t)(imm & 0xFFF) << 20) | (rs1 << 15) | (d->funct3 << 12) | (rd << 7) | d->opcode;
+}
+
+static uint32_t codificar_s(const DescritorInstrucao *d, int rs1, int rs2, int32_t imm) {
+    uint32_t imm_11_5 = (imm >> 5) & 0x7F; // bits 11 a 5 do imediato
+    uint32_t imm_4_0  = imm & 0x1F;        // bits 4 a 0 do imediato
+    return (imm_11_5 << 25) | (rs2 << 20) | (rs1 << 15) | (d->funct3 << 12) | (imm_4_0 << 7) | d->opcode;
+}
+
+static uint32_t codificar_b(const DescritorInstrucao *d, int rs1, int rs2, int32_t deslocamento) {
+    uint32_t imm_12   = (deslocamento >> 12) & 0x1;  // bit 12 do deslocamento
+    uint32_t imm_10_5 = (deslocamento >> 5)  & 0x3F; // bits 10 a 5
+    uint32_t imm_4_1  = (deslocamento >> 1)  & 0xF;  // bits 4 a 1
+    uint32_t imm_11   = (deslocamento >> 11) & 0x1;  // bit 11
+    return (imm_12 << 31) | (imm_10_5 << 25) | (rs2 << 20) | (rs1 << 15) | (d->funct3 << 12) | (imm_4_1 << 8) | (imm_11 << 7) | d->opcode;
+}
+
+static uint32_t codificar_u(const DescritorInstrucao *d, int rd, int32_t imm20) {
+    return ((uint32_t)(imm20 & 0xFFFFF) << 12) | (rd << 7) | d->opcode;
+}
+
+static uint32_t codificar_j(const DescritorInstrucao *d, int rd, int32_t deslocamento) {
+    uint32_t imm20    = (deslocamento >> 20) & 0x1;   // bit 20 do deslocamento
+    uint32_t imm10_1  = (deslocamento >> 1)  & 0x3FF; // bits 10 a 1
+    uint32_t imm11    = (deslocamento >> 11) & 0x1;   // bit 11
+    uint32_t imm19_12 = (deslocamento >> 12) & 0xFF;  // bits 19 a 12
+    return (imm20 << 31) | (imm10_1 << 21) | (imm11 << 20) | (imm19_12 << 12) | (rd << 7) | d->opcode;
+}
+
+// Divide um valor de 32 bits em 20 bits superiores (para lui/auipc) e 12 inferiores com sinal
+// (para addi e afins). A parte alta é arredondada para compensar a extensão de sinal da baixa.
+static int32_t parte_alta(uint32_t valor) {
+    return (int32_t)(((valor + 0x800) >> 12) & 0xFFFFF);
+}
+
+static int32_t parte_baixa(uint32_t valor) {
+    return (int32_t)((valor & 0xFFF) ^ 0x800) - 0x800;
+}
+
+// Operandos de uma instrução após a interpretação da linha
+typedef struct {
+    int rd, rs1, rs2;
+    int32_t imm; // Imediato, shamt ou deslocamento em bytes (branches e jal)
+    Token simbolo; // Rótulo referenciado (destino de branch/jal, %hi ou %lo), resolvido na segunda passagem
+} Operandos;
+
+// Despacha para o codificador do formato da instrução
+static uint32_t codificar_instrucao(const DescritorInstrucao *d, const Operandos *op) {
+    switch (d->formato) {
+        case FORMATO_R: return codificar_r(d, op->rd, op->rs1, op->rs2);
+        case FORMATO_I: return codificar_i(d, op->rd, op->rs1, op->imm);
+        case FORMATO_S: return codificar_s(d, op->rs1, op->rs2, op->imm);
+        case FORMATO_B: return codificar_b(d, op->rs1, op->rs2, op->imm);
+        case FORMATO_U: return codificar_u(d, op->rd, op->imm);
+        case FORMATO_J: return codificar_j(d, op->rd, op->imm);
+    }
+    return 0;
+}
+
+// Estende o sinal de um campo de 'bits' bits
+static int32_t estender_sinal(uint32_t valor, int bits) {
+    return (int32_t)(valor << (32 - bits)) >> (32 - bits);
+}
+
+// Operação inversa de codificar_instrucao: identifica a instrução pelos campos fixos do seu
+// descritor (opcode, funct3 e, quando fazem parte da codificação, funct7 ou o imediato das
+// instruções de sistema) e extrai os operandos na mesma forma que a interpretação produz.
+// As instruções reais vêm antes das pseudoinstruções na tabela, então a primeira que casa é
+// sempre a real. Retorna NULL se a palavra não é uma instrução do RV32IM.
+static const DescritorInstrucao *decodificar_instrucao(uint32_t palavra, Operandos *op) {
+    unsigned opcode = palavra & 0x7F, funct3 = (palavra >> 12) & 0x7, funct7 = palavra >> 25;
+    op->rd = (palavra >> 7) & 0x1F;
+    op->rs1 = (palavra >> 15) & 0x1F;
+    op->rs2 = (palavra >> 20) & 0x1F;
+    op->simbolo = (Token){ NULL, 0 };
+
+    for (size_t i = 0; i < NUMERO_INSTRUCOES; i++) {
+        const DescritorInstrucao *d = &tabela_instrucoes[i];
+        if (d->opcode != opcode) continue;
+        if (d->formato != FORMATO_U && d->formato != FORMATO_J && d->funct3 != funct3) continue; // Em U e J, são bits do imediato
+        switch (d->formato) {
+        case FORMATO_R:
+            if (d->funct7 != funct7) continue;
+            op->imm = 0;
+            return d;
+        case FORMATO_I:
+            op->imm = estender_sinal(palavra >> 20, 12);
+            if (d->operandos == OPERANDOS_RD_RS1_SHAMT) {
+                if (d->funct7 != funct7) continue;
+                op->imm = (int32_t)(palavra >> 20); // shamt com o funct7 em imm[11:5], como na interpretação
+            } else if (d->operandos == OPERANDOS_NENHUM && (op->imm != d->funct7 || op->rd != 0 || op->rs1 != 0)) {
+                continue;
+            }
+            return d;
+        case FORMATO_S:
+            op->imm = estender_sinal((palavra >> 25) << 5 | ((palavra >> 7) & 0x1F), 12);
+            return d;
+        case FORMATO_B:
+            op->imm = estender_sinal((palavra >> 31) << 12 | ((palavra >> 7) & 0x1) << 11 | ((palavra >> 25) & 0x3F) << 5 |
+                                     ((palavra >> 8) & 0xF) << 1, 13);
+            return d;
+        case FORMATO_U:
+            op->imm = (int32_t)(palavra >> 12);
+            return d;
+        case FORMATO_J:
+            op->imm = estender_sinal((palavra >> 31) << 20 | ((palavra >> 12) & 0xFF) << 12 | ((palavra >> 20) & 0x1) << 11 |
+                                     ((palavra >> 21) & 0x3FF) << 1, 21);
+            return d;
+        }
+    }
+    return NULL;
+}
+
+// --- Instruções Comprimidas (RVC) ---
+// Com a extensão C, várias instruções têm uma forma de 16 bits quando os operandos cabem nela:
+// registradores x8-x15 (campos de 3 bits), destino igual à primeira origem, imediatos e
+// deslocamentos curtos. A escolha é feita pela instrução real (opcode, funct3 e funct7), então
+// as pseudoinstruções são comprimidas pelas mesmas regras.
+#define REGISTRADOR_C(r) ((r) >= 8 && (r) <= 15) // Acessível pelos campos de 3 bits (x8-x15)
+#define BIT(valor, n) (((uint32_t)(valor) >> (n)) & 1u)
+#define BITS(valor, alto, baixo) (((uint32_t)(valor) >> (baixo)) & ((1u << ((alto) - (baixo) + 1)) - 1))
+
+// Formato CI: funct3 | imm[5] | rd | imm[4:0] | op
+static uint16_t codificar_ci(unsigned funct3, int rd, int32_t imm, unsigned op) {
+    return (uint16_t)(funct3 << 13 | BIT(imm, 5) << 12 | (unsigned)rd << 7 | BITS(imm, 4, 0) << 2 | op);
+}
+
+// Formato CR: funct4 | rd/rs1 | rs2 | 10
+static uint16_t codificar_cr(unsigned funct4, int rd, int rs2) {
+    return (uint16_t)(funct4 << 12 | (unsigned)rd << 7 | (unsigned)rs2 << 2 | 0b10);
+}
+
+// Formato CA (c.sub, c.xor, c.or, c.and): 100011 | rd' | funct2 | rs2' | 01
+static uint16_t codificar_ca(unsigned funct2, int rd, int rs2) {
+    return (uint16_t)(0b100011u << 10 | (unsigned)(rd - 8) << 7 | funct2 << 5 | (unsigned)(rs2 - 8) << 2 | 0b01);
+}
+
+// Formato CB com imediato (c.srli, c.srai, c.andi): 100 | imm[5] | funct2 | rd' | imm[4:0] | 01
+static uint16_t codificar_cb_imediato(unsigned funct2, int rd, int32_t imm) {
+    return (uint16_t)(0b100u << 13 | BIT(imm, 5) << 12 | funct2 << 10 | (unsigned)(rd - 8) << 7 | BITS(imm, 4, 0) << 2 | 0b01);
+}
+
+// Formatos CL/CS (c.lw, c.sw): funct3 | uimm[5:3] | rs1' | uimm[2|6] | rd'/rs2' | 00
+static uint16_t codificar_cl(unsigned funct3, int rs1, int registrador, int32_t uimm) {
+    return (uint16_t)(funct3 << 13 | BITS(uimm, 5, 3) << 10 | (unsigned)(rs1 - 8) << 7 | BIT(uimm, 2) << 6 | BIT(uimm, 6) << 5 |
+                      (unsigned)(registrador - 8) << 2);
+}
+
+// Formato CB de branch (c.beqz, c.bnez): funct3 | off[8|4:3] | rs1' | off[7:6|2:1|5] | 01
+static uint16_t codificar_cb_branch(unsigned funct3, int rs1, int32_t deslocamento) {
+    return (uint16_t)(funct3 << 13 | BIT(deslocamento, 8) << 12 | BITS(deslocamento, 4, 3) << 10 | (unsigned)(rs1 - 8) << 7 |
+                      BITS(deslocamento, 7, 6) << 5 | BITS(deslocamento, 2, 1) << 3 | BIT(deslocamento, 5) << 2 | 0b01);
+}
+
+// Formato CJ (c.j, c.jal): funct3 | off[11|4|9:8|10|6|7|3:1|5] | 01
+static uint16_t codificar_cj(unsigned funct3, int32_t deslocamento) {
+    return (uint16_t)(funct3 << 13 | BIT(deslocamento, 11) << 12 | BIT(deslocamento, 4) << 11 | BITS(deslocamento, 9, 8) << 9 |
+                      BIT(deslocamento, 10) << 8 | BIT(deslocamento, 6) << 7 | BIT(deslocamento, 7) << 6 |
+                      BITS(deslocamento, 3, 1) << 3 | BIT(deslocamento, 5) << 2 | 0b01);
+}
+
+// Procura a forma de 16 bits da instrução com estes operandos (o deslocamento de branches e jal
+// já resolvido). Retorna 1 e grava a forma em *comprimida, ou 0 se a instrução não tem uma.
+static int comprimir_instrucao(const DescritorInstrucao *d, const Operandos *op, uint16_t *comprimida) {
+    int rd = op->rd, rs1 = op->rs1, rs2 = op->rs2;
+    int32_t imm = op->imm;
+    int imm6 = (imm >= -32 && imm <= 31); // Cabe no imediato de 6 bits com sinal
+
+    switch (d->opcode) {
+    case 0b0010011: // Aritméticas com imediato
+        switch (d->funct3) {
+        case 0b000: // addi
+            if (rd == 0 && rs1 == 0 && imm == 0) { *comprimida = 0x0001; return 1; } // c.nop
+            if (rd == 0) return 0;
+            if (rs1 == 0 && imm6) { *comprimida = codificar_ci(0b010, rd, imm, 0b01); return 1; } // c.li
+            if (imm == 0 && rs1 != 0) { *comprimida = codificar_cr(0b1000, rd, rs1); return 1; } // c.mv
+            if (rd == 2 && rs1 == 2 && imm % 16 == 0 && imm >= -512 && imm <= 496) { // c.addi16sp
+                *comprimida = (uint16_t)(0b011u << 13 | BIT(imm, 9) << 12 | 2u << 7 | BIT(imm, 4) << 6 | BIT(imm, 6) << 5 |
+                                         BITS(imm, 8, 7) << 3 | BIT(imm, 5) << 2 | 0b01);
+                return 1;
+            }
+            if (rd == rs1 && imm6) { *comprimida = codificar_ci(0b000, rd, imm, 0b01); return 1; } // c.addi
+            if (rs1 == 2 && REGISTRADOR_C(rd) && imm > 0 && imm <= 1020 && imm % 4 == 0) { // c.addi4spn
+                *comprimida = (uint16_t)(BITS(imm, 5, 4) << 11 | BITS(imm, 9, 6) << 7 | BIT(imm, 2) << 6 | BIT(imm, 3) << 5 |
+                                         (unsigned)(rd - 8) << 2);
+                return 1;
+            }
+            return 0;
+        case 0b001: // slli
+            if (rd != 0 && rd == rs1 && imm != 0) { *comprimida = codificar_ci(0b000, rd, imm, 0b10); return 1; } // c.slli
+            return 0;
+        case 0b101: // srli, srai
+            if (REGISTRADOR_C(rd) && rd == rs1 && (imm & 0x1F) != 0) { // imm[11:5] traz o funct7 do srai
+                *comprimida = codificar_cb_imediato(d->funct7 ? 0b01 : 0b00, rd, imm & 0x1F); // c.srai ou c.srli
+                return 1;
+            }
+            return 0;
+        case 0b111: // andi
+            if (REGISTRADOR_C(rd) && rd == rs1 && imm6) { *comprimida = codificar_cb_imediato(0b10, rd, imm); return 1; } // c.andi
+            return 0;
+        }
+        return 0;
+    case 0b0110011: // Aritméticas entre registradores
+        if (d->funct7 == 0b0100000) { // sub
+            if (d->funct3 == 0b000 && REGISTRADOR_C(rd) && rd == rs1 && REGISTRADOR_C(rs2)) { *comprimida = codificar_ca(0b00, rd, rs2); return 1; }
+            return 0;
+        }
+        if (d->funct7 != 0) return 0;
+        if (d->funct3 == 0b000) { // add
+            if (rd == 0 || (rs1 == 0 && rs2 == 0)) return 0;
+            if (rs1 == 0) { *comprimida = codificar_cr(0b1000, rd, rs2); return 1; }          // c.mv
+            if (rs2 == 0) { *comprimida = codificar_cr(0b1000, rd, rs1); return 1; }          // c.mv
+            if (rd == rs1) { *comprimida = codificar_cr(0b1001, rd, rs2); return 1; }         // c.add
+            if (rd == rs2) { *comprimida = codificar_cr(0b1001, rd, rs1); return 1; }         // c.add (comutada)
+            return 0;
+        }
+        if (d->funct3 == 0b100 || d->funct3 == 0b110 || d->funct3 == 0b111) { // xor, or, and (comutativas)
+            unsigned funct2 = d->funct3 == 0b100 ? 0b01 : d->funct3 == 0b110 ? 0b10 : 0b11;
+            if (!REGISTRADOR_C(rd) || !REGISTRADOR_C(rs1) || !REGISTRADOR_C(rs2)) return 0;
+            if (rd == rs1) { *comprimida = codificar_ca(funct2, rd, rs2); return 1; }
+            if (rd == rs2) { *comprimida = codificar_ca(funct2, rd, rs1); return 1; }
+        }
+        return 0;
+    case 0b0000011: // lw
+        if (d->funct3 != 0b010 || imm < 0 || imm % 4 != 0) return 0;
+        if (rs1 == 2 && rd != 0 && imm <= 252) { // c.lwsp
+            *comprimida = (uint16_t)(0b010u << 13 | BIT(imm, 5) << 12 | (unsigned)rd << 7 | BITS(imm, 4, 2) << 4 | BITS(imm, 7, 6) << 2 | 0b10);
+            return 1;
+        }
+        if (REGISTRADOR_C(rd) && REGISTRADOR_C(rs1) && imm <= 124) { *comprimida = codificar_cl(0b010, rs1, rd, imm); return 1; } // c.lw
+        return 0;
+    case 0b0100011: // sw
+        if (d->funct3 != 0b010 || imm < 0 || imm % 4 != 0) return 0;
+        if (rs1 == 2 && imm <= 252) { // c.swsp
+            *comprimida = (uint16_t)(0b110u << 13 | BITS(imm, 5, 2) << 9 | BITS(imm, 7, 6) << 7 | (unsigned)rs2 << 2 | 0b10);
+            return 1;
+        }
+        if (REGISTRADOR_C(rs1) && REGISTRADOR_C(rs2) && imm <= 124) { *comprimida = codificar_cl(0b110, rs1, rs2, imm); return 1; } // c.sw
+        return 0;
+    case 0b0110111: // lui
+        if (rd == 0 || rd == 2 || imm == 0) return 0;
+        if (imm <= 31 || imm >= 0xFFFE0) { *comprimida = codificar_ci(0b011, rd, imm, 0b01); return 1; } // c.lui
+        return 0;
+    case 0b1100111: // jalr
+        if (imm != 0 || rs1 == 0 || rd > 1) return 0;
+        *comprimida = codificar_cr(rd == 0 ? 0b1000 : 0b1001, rs1, 0); // c.jr ou c.jalr
+        return 1;
+    case 0b1101111: // jal
+        if (rd > 1 || imm < -2048 || imm > 2046) return 0;
+        *comprimida = codificar_cj(rd == 0 ? 0b101 : 0b001, imm); // c.j ou c.jal
+        return 1;
+    case 0b1100011: // beq, bne contra x0
+        if (d->funct3 > 0b001 || rs2 != 0 || !REGISTRADOR_C(rs1) || imm < -256 || imm > 254) return 0;
+        *comprimida = codificar_cb_branch(d->funct3 == 0b000 ? 0b110 : 0b111, rs1, imm); // c.beqz ou c.bnez
+        return 1;
+    case 0b1110011: // ebreak
+        if (imm != 1) return 0;
+        *comprimida = 0x9002; // c.ebreak
+        return 1;
+    }
+    return 0;
+}
+
+// Operação inversa de comprimir_instrucao: expande a forma de 16 bits na instrução real
+// equivalente, com os operandos como os de decodificar_instrucao. Retorna NULL se a meia
+// palavra não é uma instrução do RV32C (inclusive as formas reservadas, como c.addi4spn com
+// imediato zero e deslocamentos de 6 bits no RV32).
+static const DescritorInstrucao *descomprimir_instrucao(uint16_t c, Operandos *op) {
+    int rd = (int)BITS(c, 11, 7), rs2 = (int)BITS(c, 6, 2);
+    int rd_c = (int)BITS(c, 4, 2) + 8, rs1_c = (int)BITS(c, 9, 7) + 8; // Campos de 3 bits (x8-x15)
+    int32_t imm6 = estender_sinal(BIT(c, 12) << 5 | BITS(c, 6, 2), 6);
+    int32_t deslocamento_cj = estender_sinal(BIT(c, 12) << 11 | BIT(c, 8) << 10 | BITS(c, 10, 9) << 8 | BIT(c, 6) << 7 |
+                                             BIT(c, 7) << 6 | BIT(c, 2) << 5 | BIT(c, 11) << 4 | BITS(c, 5, 3) << 1, 12);
+    const char *mnemonico = NULL;
+    op->rd = op->rs1 = op->rs2 = 0;
+    op->imm = 0;
+    op->simbolo = (Token){ NULL, 0 };
+
+    switch ((c & 0b11) << 3 | BITS(c, 15, 13)) { // Quadrante e funct3
+    case 0b00000: // c.addi4spn
+        op->imm = (int32_t)(BITS(c, 10, 7) << 6 | BITS(c, 12, 11) << 4 | BIT(c, 5) << 3 | BIT(c, 6) << 2);
+        if (op->imm == 0) return NULL;
+        op->rd = rd_c; op->rs1 = 2; mnemonico = "addi";
+        break;
+    case 0b00010: // c.lw
+    case 0b00110: // c.sw
+        op->imm = (int32_t)(BIT(c, 5) << 6 | BITS(c, 12, 10) << 3 | BIT(c, 6) << 2);
+        op->rs1 = rs1_c;
+        if (BIT(c, 15)) { op->rs2 = rd_c; mnemonico = "sw"; }
+        else { op->rd = rd_c; mnemonico = "lw"; }
+        break;
+    case 0b01000: // c.nop, c.addi
+        op->rd = op->rs1 = rd; op->imm = imm6; mnemonico = "addi";
+        break;
+    case 0b01001: // c.jal
+    case 0b01101: // c.j
+        op->rd = BIT(c, 15) ? 0 : 1; op->imm = deslocamento_cj; mnemonico = "jal";
+        break;
+    case 0b01010: // c.li
+        op->rd = rd; op->imm = imm6; mnemonico = "addi";
+        break;
+    case 0b01011: // c.addi16sp, c.lui
+        if (rd == 2) {
+            op->imm = estender_sinal(BIT(c, 12) << 9 | BITS(c, 4, 3) << 7 | BIT(c, 5) << 6 | BIT(c, 2) << 5 | BIT(c, 6) << 4, 10);
+            op->rd = op->rs1 = 2; mnemonico = "addi";
+        } else {
+            op->rd = rd; op->imm = imm6 & 0xFFFFF; mnemonico = "lui";
+        }
+        if (imm6 == 0 && op->imm == 0) return NULL;
+        break;
+    case 0b01100: // c.srli, c.srai, c.andi, c.sub, c.xor, c.or, c.and
+        op->rd = op->rs1 = rs1_c;
+        switch (BITS(c, 11, 10)) {
+        case 0b00: op->imm = (int32_t)BITS(c, 6, 2); mnemonico = "srli"; break;
+        case 0b01: op->imm = (int32_t)(BITS(c, 6, 2) | 0b0100000u << 5); mnemonico = "srai"; break;
+        case 0b10: op->imm = imm6; mnemonico = "andi"; break;
+        case 0b11:
+            op->rs2 = rd_c;
+            mnemonico = (const char *[]){ "sub", "xor", "or", "and" }[BITS(c, 6, 5)];
+            break;
+        }
+        if (BIT(c, 12) && BITS(c, 11, 10) != 0b10) return NULL; // shamt[5] e c.subw/c.addw não existem no RV32
+        break;
+    case 0b01110: // c.beqz
+    case 0b01111: // c.bnez
+        op->rs1 = rs1_c;
+        op->imm = estender_sinal(BIT(c, 12) << 8 | BITS(c, 6, 5) << 6 | BIT(c, 2) << 5 | BITS(c, 11, 10) << 3 | BITS(c, 4, 3) << 1, 9);
+        mnemonico = BIT(c, 13) ? "bne" : "beq";
+        break;
+    case 0b10000: // c.slli
+        if (BIT(c, 12)) return NULL;
+        op->rd = op->rs1 = rd; op->imm = (int32_t)BITS(c, 6, 2); mnemonico = "slli";
+        break;
+    case 0b10010: // c.lwsp
+        if (rd == 0) return NULL;
+        op->rd = rd; op->rs1 = 2; op->imm = (int32_t)(BITS(c, 3, 2) << 6 | BIT(c, 12) << 5 | BITS(c, 6, 4) << 2); mnemonico = "lw";
+        break;
+    case 0b10100: // c.jr, c.mv, c.ebreak, c.jalr, c.add
+        if (rs2 != 0) { // c.mv (add rd, x0, rs2) ou c.add (add rd, rd, rs2)
+            op->rd = rd; op->rs1 = BIT(c, 12) ? rd : 0; op->rs2 = rs2; mnemonico = "add";
+        } else if (rd != 0) { // c.jr ou c.jalr
+            op->rd = (int)BIT(c, 12); op->rs1 = rd; mnemonico = "jalr";
+        } else if (BIT(c, 12)) {
+            op->imm = 1; mnemonico = "ebreak";
+        }
+        break;
+    case 0b10110: // c.swsp
+        op->rs1 = 2; op->rs2 = rs2; op->imm = (int32_t)(BITS(c, 8, 7) << 6 | BITS(c, 12, 9) << 2); mnemonico = "sw";
+        break;
+    }
+    return mnemonico ? buscar_instrucao(mnemonico) : NULL;
+}
+
+// Decide, na primeira passagem, se a instrução ocupará 16 bits. Uma referência a rótulo só
+// pode ser comprimida em branches e jal, e provisoriamente: o deslocamento, ainda
+// desconhecido, é verificado por relaxar_branches.
+static int comprimivel(const DescritorInstrucao *d, const Operandos *op) {
+    uint16_t comprimida;
+    if (op->simbolo.texto == NULL) return comprimir_instrucao(d, op, &comprimida);
+    if (d->formato != FORMATO_B && d->formato != FORMATO_J) return 0;
+    Operandos provisorio = *op;
+    provisorio.imm = 0;
+    return comprimir_instrucao(d, &provisorio, &comprimida);
+}
+
+// --- Diagnósticos ---
+// As mensagens de erro não são impressas no momento em que são detectadas: ficam em uma
+// lista, associadas à linha e ao endereço da instrução. Assim elas podem ser produzidas por
+// várias threads ao mesmo tempo e impressas depois, sempre em ordem de linha. Cada mensagem
+// guarda uma cópia do texto da linha, pois na montagem em fluxo o fonte não fica em memória.
+typedef struct {
+    uint32_t numero_linha;  // Número da linha no fonte
+    uint32_t endereco;      // Endereço (em bytes) da instrução da linha
+    uint32_t sequencia;     // Ordem de criação, usada como desempate na ordenação
+    char *mensagem;
+    char *texto_linha;      // Cópia da linha, sem o fim de linha
+} Diagnostico;
+
+typedef struct {
+    Diagnostico *itens;
+    size_t quantidade;
+    size_t capacidade;
+} ListaDiagnosticos;
+
+// Garante espaço para mais 'quantidade' diagnósticos
+static void diagnosticos_garantir(ListaDiagnosticos *lista, size_t quantidade) {
+    if (lista->quantidade + quantidade <= lista->capacidade) return;
+    size_t capacidade = lista->capacidade ? lista->capacidade * 2 : 16;
+    while (capacidade < lista->quantidade + quantidade) capacidade *= 2;
+    Diagnostico *novos = realloc(lista->itens, capacidade * sizeof(Diagnostico));
+    if (novos == NULL) memoria_insuficiente("as mensagens de erro");
+    lista->itens = novos;
+    lista->capacidade = capacidade;
+}
+
+static Diagnostico *diagnosticos_reservar(ListaDiagnosticos *lista) {
+    diagnosticos_garantir(lista, 1);
+    Diagnostico *diagnostico = &lista->itens[lista->quantidade];
+    diagnostico->sequencia = (uint32_t)lista->quantidade;
+    lista->quantidade++;
+    return diagnostico;
+}
+
+static void diagnosticos_vadicionar(ListaDiagnosticos *lista, uint32_t numero_linha, uint32_t endereco, const char *texto_linha,
+                                    const char *formato, va_list argumentos) {
+    va_list copia;
+    va_copy(copia, argumentos);
+    int tamanho = vsnprintf(NULL, 0, formato, copia);
+    va_end(copia);
+    diagnosticos_garantir(lista, 1); // Antes dos textos, para não perdê-los se faltar memória
+    char *mensagem = malloc(tamanho > 0 ? (size_t)tamanho + 1 : 1);
+    size_t tamanho_linha = strcspn(texto_linha, "\n\r");
+    char *copia_linha = malloc(tamanho_linha + 1);
+    if (mensagem == NULL || copia_linha == NULL) {
+        free(mensagem);
+        free(copia_linha);
+        memoria_insuficiente("as mensagens de erro");
+    }
+    vsnprintf(mensagem, (size_t)tamanho + 1, formato, argumentos);
+    memcpy(copia_linha, texto_linha, tamanho_linha);
+    copia_linha[tamanho_linha] = '\0';
+
+    Diagnostico *diagnostico = diagnosticos_reservar(lista);
+    diagnostico->numero_linha = numero_linha;
+    diagnostico->endereco = endereco;
+    diagnostico->mensagem = mensagem;
+    diagnostico->texto_linha = copia_linha;
+}
+
+// Registra um erro na linha 'numero_linha', cujo texto começa em 'texto_linha' (até o fim de linha)
+static void diagnosticos_adicionar(ListaDiagnosticos *lista, uint32_t numero_linha, uint32_t endereco, const char *texto_linha,
+                            const char *formato, ...) {
+    va_list argumentos;
+    va_start(argumentos, formato);
+    diagnosticos_vadicionar(lista, numero_linha, endereco, texto_linha, formato, argumentos);
+    va_end(argumentos);
+}
+
+// Registra um erro que não pertence a nenhuma linha (ex.: o arquivo não pôde ser aberto), como
+// linha 0; sem lista, imprime o erro em stderr na hora
+static void diagnosticos_erro_arquivo(ListaDiagnosticos *lista, const char *formato, ...) {
+    va_list argumentos;
+    va_start(argumentos, formato);
+    if (lista != NULL) {
+        diagnosticos_vadicionar(lista, 0, 0, "", formato, argumentos);
+    } else {
+        fprintf(stderr, "Erro: ");
+        vfprintf(stderr, formato, argumentos);
+        fprintf(stderr, ".\n");
+    }
+    va_end(argumentos);
+}
+
+// Move os diagnósticos de 'origem' para o fim de 'destino', somando as bases de linha e de
+// endereço (usadas quando 'origem' foi produzida com numeração relativa a um trecho do fonte)
+static void diagnosticos_anexar(ListaDiagnosticos *destino, ListaDiagnosticos *origem, uint32_t base_linha, uint32_t base_endereco) {
+    diagnosticos_garantir(destino, origem->quantidade); // Cada texto fica sempre em uma lista só
+    for (size_t i = 0; i < origem->quantidade; i++) {
+        Diagnostico *item = &origem->itens[i];
+        Diagnostico *novo = diagnosticos_reservar(destino);
+        novo->numero_linha = item->numero_linha + base_linha;
+        novo->endereco = item->endereco + base_endereco;
+        novo->mensagem = item->mensagem;
+        novo->texto_linha = item->texto_linha;
+    }
+    free(origem->itens);
+    memset(origem, 0, sizeof(*origem));
+}
+
+static int comparar_diagnosticos(const void *a, const void *b) {
+    const Diagnostico *x = a, *y = b;
+    if (x->numero_linha != y->numero_linha) return x->numero_linha < y->numero_linha ? -1 : 1;
+    return x->sequencia < y->sequencia ? -1 : (x->sequencia > y->sequencia);
+}
+
+// Ordena os diagnósticos por linha, preservando a ordem de criação dentro de uma mesma linha
+static void diagnosticos_ordenar(ListaDiagnosticos *lista) {
+    if (lista->quantidade > 1) qsort(lista->itens, lista->quantidade, sizeof(Diagnostico), comparar_diagnosticos);
+}
+
+// Imprime os diagnósticos em stderr, junto com o texto da linha correspondente
+static void diagnosticos_imprimir(const ListaDiagnosticos *lista) {
+    for (size_t i = 0; i < lista->quantidade; i++) {
+        const Diagnostico *item = &lista->itens[i];
+        if (item->numero_linha == 0) { // Erro do arquivo, sem linha
+            fprintf(stderr, "Erro: %s.\n", item->mensagem);
+            continue;
+        }
+        fprintf(stderr, "Erro na linha %u (0x%04X): %s. Linha: %s\n", item->numero_linha, item->endereco,
+                item->mensagem, item->texto_linha);
+    }
+}
+
+static void diagnosticos_liberar(ListaDiagnosticos *lista) {
+    for (size_t i = 0; i < lista->quantidade; i++) {
+        free(lista->itens[i].mensagem);
+        free(lista->itens[i].texto_linha);
+    }
+    free(lista->itens);
+    memset(lista, 0, sizeof(*lista));
+}
+
+// --- Interpretação de Operandos ---
+// Estado da linha sendo interpretada. Cada linha (ou trecho do fonte, em paralelo) tem seu
+// próprio léxico, sem estado global.
+typedef struct {
+    Lexico *lexico;                  // Posicionado no próximo token da linha
+    ListaDiagnosticos *diagnosticos; // Onde os erros da linha são registrados
+    uint32_t numero_linha;
+    uint32_t endereco;               // Endereço da instrução da linha
+    const char *texto_linha;         // Texto original da linha (para as mensagens de erro)
+} LinhaAtual;
+
+static Token proximo_token(LinhaAtual *atual) {
+    return lexico_proximo(atual->lexico);
+}
+
+// Registra um erro associado à linha atual
+static void erro_linha(LinhaAtual *atual, const char *formato, ...) {
+    va_list argumentos;
+    va_start(argumentos, formato);
+    diagnosticos_vadicionar(atual->diagnosticos, atual->numero_linha, atual->endereco, atual->texto_linha, formato, argumentos);
+    va_end(argumentos);
+}
+
+// Reconhece um operando "%hi(rotulo)" ou "%lo(rotulo)" (conforme 'modificador') e devolve o
+// nome do rótulo. Retorna um token com texto NULL se o operando não tiver essa forma.
+static Token extrair_referencia(Token texto, const char *modificador) {
+    size_t tamanho_modificador = strlen(modificador);
+    if (texto.texto == NULL || texto.tamanho < tamanho_modificador + 3 || memcmp(texto.texto, modificador, tamanho_modificador) != 0 ||
+        texto.texto[tamanho_modificador] != '(' || texto.texto[texto.tamanho - 1] != ')') {
+        return (Token){ NULL, 0 };
+    }
+    return (Token){ texto.texto + tamanho_modificador + 1, texto.tamanho - (uint32_t)tamanho_modificador - 2 };
+}
+
+// Lê os operandos da instrução (continuando a tokenização da linha) conforme a forma descrita
+// na tabela e os valida. Rótulos referenciados (destinos de branch/jal, %hi e %lo) são apenas
+// anotados em op->simbolo; o tipo da referência decorre do formato da instrução e o valor é
+// calculado na segunda passagem. Retorna 1 se os operandos forem válidos ou 0 caso contrário.
+static int interpretar_operandos(const DescritorInstrucao *d, Operandos *op, LinhaAtual *atual) {
+    const char *mnemonico = d->mnemonico;
+    long valor;
+
+    switch (d->operandos) {
+    case OPERANDOS_RD_RS1_RS2: {
+        Token rd_txt = proximo_token(atual); Token rs1_txt = proximo_token(atual); Token rs2_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || rs1_txt.texto == NULL || rs2_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt); op->rs1 = obter_numero_registrador(rs1_txt); op->rs2 = obter_numero_registrador(rs2_txt);
+        if (op->rd == -1 || op->rs1 == -1 || op->rs2 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        return 1;
+    }
+    case OPERANDOS_RD_RS1_IMM:
+    case OPERANDOS_RD_RS1_SHAMT: {
+        Token rd_txt = proximo_token(atual); Token rs1_txt = proximo_token(atual); Token imm_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || rs1_txt.texto == NULL || imm_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt); op->rs1 = obter_numero_registrador(rs1_txt);
+        int shift = (d->operandos == OPERANDOS_RD_RS1_SHAMT);
+        if (!shift && (op->simbolo = extrair_referencia(imm_txt, "%lo")).texto != NULL) {
+            if (op->rd == -1 || op->rs1 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+            return 1;
+        }
+        long minimo = shift ? 0 : -2048, maximo = shift ? 31 : 2047; // RV32I: shamt de 5 bits [24:20]
+        if (op->rd == -1 || op->rs1 == -1 || converter_imediato(imm_txt, &valor) != 0 || valor < minimo || valor > maximo) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", mnemonico); return 0;
+        }
+        op->imm = shift ? (int32_t)(valor | (d->funct7 << 5)) : (int32_t)valor;
+        return 1;
+    }
+    case OPERANDOS_RD_OFFSET_RS1:
+    case OPERANDOS_RS2_OFFSET_RS1: {
+        int store = (d->operandos == OPERANDOS_RS2_OFFSET_RS1);
+        Token reg_txt = proximo_token(atual); Token offset_rs1_txt = proximo_token(atual); // Pega "offset(rs1)"
+        Token offset_txt, rs1_txt;
+        if (reg_txt.texto == NULL || separar_deslocamento_registrador(offset_rs1_txt, &offset_txt, &rs1_txt) != 0) {
+            erro_linha(atual, "Formato inválido para '%s'. Use '%s %s, offset(rs1)'", mnemonico, mnemonico, store ? "rs2" : "rd");
+            return 0;
+        }
+        int reg = obter_numero_registrador(reg_txt);
+        op->rs1 = obter_numero_registrador(rs1_txt);
+        if (store) op->rs2 = reg; else op->rd = reg;
+        // O offset "0" padrão é constante, então só um offset do texto pode ser "%lo(rotulo)"
+        if (offset_txt.texto[0] == '%' && (op->simbolo = extrair_referencia(offset_txt, "%lo")).texto != NULL) {
+            if (reg == -1 || op->rs1 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+            return 1;
+        }
+        if (reg == -1 || op->rs1 == -1 || converter_imediato(offset_txt, &valor) != 0 || valor < -2048 || valor > 2047) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", mnemonico); return 0;
+        }
+        op->imm = (int32_t)valor;
+        return 1;
+    }
+    case OPERANDOS_JALR: { // Formato: jalr rd, rs1, offset  ou jalr rd, offset(rs1)  ou jalr rd, rs1  ou jalr rs1
+        Token rd_txt = proximo_token(atual);
+        Token arg2_txt = proximo_token(atual); // Pode ser rs1 ou offset(rs1)
+        Token arg3_txt = proximo_token(atual); // Pode ser offset ou NULL
+        Token offset_txt = TOKEN_LITERAL("0"), rs1_txt = arg2_txt;
+        if (rd_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        if (arg2_txt.texto == NULL) { // "jalr rs1": pseudoinstrução, com ra como destino
+            arg2_txt = rs1_txt = rd_txt;
+            rd_txt = TOKEN_LITERAL("ra");
+        }
+        if (arg3_txt.texto != NULL) {
+            offset_txt = arg3_txt;
+        } else if (memchr(arg2_txt.texto, '(', arg2_txt.tamanho) != NULL && separar_deslocamento_registrador(arg2_txt, &offset_txt, &rs1_txt) != 0) {
+            erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0;
+        }
+        op->rd = obter_numero_registrador(rd_txt); op->rs1 = obter_numero_registrador(rs1_txt);
+        if (offset_txt.texto[0] == '%' && (op->simbolo = extrair_referencia(offset_txt, "%lo")).texto != NULL) {
+            if (op->rd == -1 || op->rs1 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+            return 1;
+        }
+        if (op->rd == -1 || op->rs1 == -1 || converter_imediato(offset_txt, &valor) != 0 || valor < -2048 || valor > 2047) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", mnemonico); return 0;
+        }
+        op->imm = (int32_t)valor;
+        return 1;
+    }
+    case OPERANDOS_RS1_RS2_ROTULO: {
+        Token rs1_txt = proximo_token(atual); Token rs2_txt = proximo_token(atual); Token rotulo_destino_txt = proximo_token(atual);
+        if (rs1_txt.texto == NULL || rs2_txt.texto == NULL || rotulo_destino_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rs1 = obter_numero_registrador(rs1_txt); op->rs2 = obter_numero_registrador(rs2_txt);
+        if (op->rs1 == -1 || op->rs2 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        op->simbolo = rotulo_destino_txt;
+        return 1;
+    }
+    case OPERANDOS_RD_IMM20: {
+        Token rd_txt = proximo_token(atual); Token imm_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || imm_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt);
+        if (op->rd == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        if ((op->simbolo = extrair_referencia(imm_txt, "%hi")).texto != NULL) return 1;
+        // O valor fornecido é o valor exato dos 20 bits superiores (31 a 12) de rd.
+        // Aceita tanto a forma sem sinal (até 0xFFFFF) quanto a forma com sinal.
+        if (converter_imediato(imm_txt, &valor) != 0 || valor < -(1L << 19) || valor > 0xFFFFF) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", mnemonico); return 0;
+        }
+        op->imm = (int32_t)valor;
+        return 1;
+    }
+    case OPERANDOS_RD_ROTULO: {
+        Token rd_txt = proximo_token(atual); Token rotulo_destino_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        if (rotulo_destino_txt.texto == NULL) { // "jal rotulo": pseudoinstrução, com ra como destino
+            rotulo_destino_txt = rd_txt;
+            rd_txt = TOKEN_LITERAL("ra");
+        }
+        op->rd = obter_numero_registrador(rd_txt);
+        if (op->rd == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        op->simbolo = rotulo_destino_txt;
+        return 1;
+    }
+    case OPERANDOS_NENHUM:
+        op->imm = d->funct7; // Imediato fixo (funct12) de ecall/ebreak
+        op->rs1 = d->fixo;   // ra em "ret"
+        return 1;
+    case OPERANDOS_RD_RS1_FIXO:
+    case OPERANDOS_RD_RS2: {
+        Token rd_txt = proximo_token(atual); Token rs_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || rs_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt);
+        int rs = obter_numero_registrador(rs_txt);
+        if (op->rd == -1 || rs == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        if (d->operandos == OPERANDOS_RD_RS2) {
+            op->rs2 = rs;
+        } else {
+            op->rs1 = rs;
+            if (d->formato == FORMATO_R) op->rs2 = d->fixo; else op->imm = d->fixo;
+        }
+        return 1;
+    }
+    case OPERANDOS_RS1_ROTULO:
+    case OPERANDOS_RS2_ROTULO: {
+        Token rs_txt = proximo_token(atual); Token rotulo_destino_txt = proximo_token(atual);
+        if (rs_txt.texto == NULL || rotulo_destino_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        int rs = obter_numero_registrador(rs_txt);
+        if (rs == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        if (d->operandos == OPERANDOS_RS1_ROTULO) op->rs1 = rs; else op->rs2 = rs;
+        op->simbolo = rotulo_destino_txt;
+        return 1;
+    }
+    case OPERANDOS_RS2_RS1_ROTULO: {
+        Token rs_txt = proximo_token(atual); Token rt_txt = proximo_token(atual); Token rotulo_destino_txt = proximo_token(atual);
+        if (rs_txt.texto == NULL || rt_txt.texto == NULL || rotulo_destino_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rs2 = obter_numero_registrador(rs_txt); op->rs1 = obter_numero_registrador(rt_txt);
+        if (op->rs1 == -1 || op->rs2 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        op->simbolo = rotulo_destino_txt;
+        return 1;
+    }
+    case OPERANDOS_ROTULO: {
+        Token rotulo_destino_txt = proximo_token(atual);
+        if (rotulo_destino_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'. Use '%s rotulo'", mnemonico, mnemonico); return 0; }
+        op->rd = d->fixo;
+        op->simbolo = rotulo_destino_txt;
+        return 1;
+    }
+    case OPERANDOS_RS1: {
+        Token rs_txt = proximo_token(atual);
+        if (rs_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = d->fixo;
+        op->rs1 = obter_numero_registrador(rs_txt);
+        if (op->rs1 == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        return 1;
+    }
+    case OPERANDOS_RD_IMM32: {
+        Token rd_txt = proximo_token(atual); Token imm_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || imm_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt);
+        if (op->rd == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        // Aceita qualquer valor de 32 bits, com ou sem sinal
+        if (converter_imediato(imm_txt, &valor) != 0 || valor < INT32_MIN || valor > (long)UINT32_MAX) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", mnemonico); return 0;
+        }
+        op->imm = (int32_t)(uint32_t)valor;
+        return 1;
+    }
+    case OPERANDOS_RD_SIMBOLO: {
+        Token rd_txt = proximo_token(atual); Token rotulo_txt = proximo_token(atual);
+        if (rd_txt.texto == NULL || rotulo_txt.texto == NULL) { erro_linha(atual, "Formato inválido para '%s'", mnemonico); return 0; }
+        op->rd = obter_numero_registrador(rd_txt);
+        if (op->rd == -1) { erro_linha(atual, "Registrador inválido para '%s'", mnemonico); return 0; }
+        op->simbolo = rotulo_txt;
+        return 1;
+    }
+    }
+    return 0;
+}
+
+// --- Seção de Dados ---
+// O fonte tem duas seções, cada uma com seu próprio contador de posição: .text, com as
+// instruções, e .data, com as diretivas de dados (.word, .half, .byte, .space, .align e
+// .incbin). Cada diretiva de dados vira um item. Os valores de .word, .half e .byte ficam em
+// um vetor de bytes à parte; o conteúdo de um .incbin fica no próprio arquivo, mapeado em
+// memória, e só é lido quando a saída é escrita, sem passar por nenhum buffer intermediário.
+// A posição de cada item depende dos alinhamentos anteriores, então é calculada depois
+// (dados_posicionar), com a seção inteira já em ordem. Sem --base-dados, a seção fica logo
+// após o código, alinhada ao maior .align usado (no mínimo uma palavra).
+#define MAXIMO_EXPOENTE_ALINHAMENTO 16 // .align 16 = 64 KiB
+#define TAMANHO_MAXIMO_DADOS INT32_MAX // Os endereços dos rótulos são int
+
+typedef enum {
+    SECAO_INDEFINIDA, // Início de um trecho do fonte, que depende dos anteriores (ver primeira_passagem)
+    SECAO_TEXTO,
+    SECAO_DADOS
+} Secao;
+
+typedef enum {
+    DADO_BYTES,       // .word, .half e .byte: valores guardados em 'bytes'
+    DADO_REPETIDO,    // .space: um mesmo byte repetido
+    DADO_ALINHAMENTO, // .align: zeros até a próxima posição múltipla do alinhamento
+    DADO_INCLUIDO     // .incbin: parte de um arquivo mapeado em memória
+} TipoDado;
+
+typedef struct {
+    uint8_t tipo;            // TipoDado
+    uint8_t valor;           // Byte repetido (DADO_REPETIDO)
+    uint32_t deslocamento;   // Posição do item na seção, definida por dados_posicionar (antes disso,
+                             // o endereço de código da linha, para as mensagens de erro)
+    uint32_t tamanho;        // Bytes ocupados (em DADO_ALINHAMENTO, definido por dados_posicionar)
+    uint32_t origem;         // Posição em 'bytes' (DADO_BYTES), índice em 'incluidos' (DADO_INCLUIDO)
+                             // ou alinhamento em bytes (DADO_ALINHAMENTO)
+    uint32_t numero_linha;
+    const char *texto_linha; // Início da linha no fonte (só na montagem em duas passagens)
+} ItemDados;
+
+// Rótulo usado como valor de .word: o endereço só é gravado depois que todos são conhecidos
+typedef struct {
+    const char *simbolo;     // Nome do rótulo (não terminado em '\0')
+    const char *texto_linha; // Texto da linha, para as mensagens de erro
+    uint32_t tamanho_simbolo;
+    uint32_t numero_linha;
+    uint32_t item;           // Item de dados que contém a palavra
+    uint32_t posicao;        // Posição da palavra em 'bytes'
+} ReferenciaDados;
+
+typedef struct {
+    void *mapa;              // Arquivo inteiro, mapeado (NULL se vazio)
+    size_t tamanho_mapa;
+    const uint8_t *inicio;   // Primeiro byte incluído
+} ArquivoIncluido;
+
+typedef struct {
+    ItemDados *itens;
+    size_t quantidade_itens, capacidade_itens;
+    uint8_t *bytes;
+    size_t quantidade_bytes, capacidade_bytes;
+    ReferenciaDados *referencias;
+    size_t quantidade_referencias, capacidade_referencias;
+    ArquivoIncluido *incluidos;
+    size_t quantidade_incluidos, capacidade_incluidos;
+    uint32_t tamanho;        // Bytes da seção (definido por dados_posicionar)
+    uint32_t alinhamento;    // Maior alinhamento pedido por .align (0 = nenhum)
+    uint32_t base;           // Endereço do primeiro byte da seção
+    int base_fixa;           // 1 = 'base' veio de --base-dados; senão, a seção fica logo após o código
+    int separada;            // 1 = a seção vai para um arquivo próprio (--dados), então pode sobrepor o código
+    int sem_arquivos;        // 1 = .incbin é recusado (montador_montar não lê arquivos)
+} SecaoDados;
+
+// Garante espaço para mais 'quantidade' elementos no fim de um dos vetores da seção
+static void *dados_reservar(void *vetor, size_t usados, size_t *capacidade, size_t quantidade, size_t tamanho_elemento) {
+    if (usados + quantidade <= *capacidade) return vetor;
+    size_t nova = *capacidade ? *capacidade * 2 : 256;
+    while (nova < usados + quantidade) nova *= 2;
+    void *novo = realloc(vetor, nova * tamanho_elemento);
+    if (novo == NULL) memoria_insuficiente("a seção de dados");
+    *capacidade = nova;
+    return novo;
+}
+
+static ItemDados *dados_adicionar_item(SecaoDados *dados, TipoDado tipo, uint32_t tamanho, uint32_t origem, const LinhaAtual *atual) {
+    dados->itens = dados_reservar(dados->itens, dados->quantidade_itens, &dados->capacidade_itens, 1, sizeof(ItemDados));
+    ItemDados *item = &dados->itens[dados->quantidade_itens++];
+    *item = (ItemDados){ (uint8_t)tipo, 0, atual->endereco, tamanho, origem, atual->numero_linha, atual->texto_linha };
+    return item;
+}
+
+// Desfaz os mapeamentos e esvazia a seção, mantendo a memória dos vetores e a configuração
+// (base fixa, seção separada e .incbin recusado) para a próxima montagem
+static void dados_limpar(SecaoDados *dados) {
+    for (size_t i = 0; i < dados->quantidade_incluidos; i++) {
+        if (dados->incluidos[i].mapa != NULL) munmap(dados->incluidos[i].mapa, dados->incluidos[i].tamanho_mapa);
+    }
+    dados->quantidade_itens = dados->quantidade_bytes = dados->quantidade_referencias = dados->quantidade_incluidos = 0;
+    dados->tamanho = dados->alinhamento = 0;
+    if (!dados->base_fixa) dados->base = 0;
+}
+
+static void dados_liberar(SecaoDados *dados) {
+    dados_limpar(dados);
+    free(dados->itens);
+    free(dados->bytes);
+    free(dados->referencias);
+    free(dados->incluidos);
+    memset(dados, 0, sizeof(*dados));
+}
+
+// Calcula a posição dos itens a partir de 'inicio', continuando do fim atual da seção. Retorna o
+// índice do primeiro item que não cabe em TAMANHO_MAXIMO_DADOS, ou a quantidade de itens.
+static size_t dados_posicionar(SecaoDados *dados, size_t inicio) {
+    uint64_t posicao = dados->tamanho;
+    for (size_t i = inicio; i < dados->quantidade_itens; i++) {
+        ItemDados *item = &dados->itens[i];
+        if (item->tipo == DADO_ALINHAMENTO) item->tamanho = (uint32_t)(-posicao & (item->origem - 1));
+        if (posicao + item->tamanho > TAMANHO_MAXIMO_DADOS) return i;
+        item->deslocamento = (uint32_t)posicao;
+        posicao += item->tamanho;
+        dados->tamanho = (uint32_t)posicao;
+    }
+    return dados->quantidade_itens;
+}
+
+// Define a base da seção: a de --base-dados ou, sem ela, o fim do código arredondado para o
+// maior alinhamento da seção (no mínimo uma palavra)
+static void dados_definir_base(SecaoDados *dados, uint32_t fim_codigo) {
+    if (dados->base_fixa) return;
+    uint32_t alinhamento = dados->alinhamento > 4 ? dados->alinhamento : 4;
+    dados->base = (uint32_t)(((uint64_t)fim_codigo + alinhamento - 1) & ~(uint64_t)(alinhamento - 1));
+}
+
+// Endereço de um rótulo da seção: o do item que o segue ('item'), ou o fim da seção
+static int endereco_rotulo_dados(const SecaoDados *dados, uint32_t item) {
+    return (int)(dados->base + (item < dados->quantidade_itens ? dados->itens[item].deslocamento : dados->tamanho));
+}
+
+// Tamanho da imagem do programa: o código e, se a seção de dados não for separada e não
+// estiver vazia, os zeros até a sua base e os dados
+static uint64_t tamanho_imagem(uint32_t tamanho_codigo, const SecaoDados *dados) {
+    if (dados == NULL || dados->separada || dados->tamanho == 0) return tamanho_codigo;
+    return (uint64_t)dados->base + dados->tamanho;
+}
+
+// Copia a seção inteira (dados->tamanho bytes) para 'destino'
+static void dados_copiar(const SecaoDados *dados, uint8_t *destino) {
+    for (size_t i = 0; i < dados->quantidade_itens; i++) {
+        const ItemDados *item = &dados->itens[i];
+        if (item->tamanho == 0) continue; // Um .incbin de arquivo vazio não tem mapeamento
+        uint8_t *posicao = destino + item->deslocamento;
+        switch (item->tipo) {
+        case DADO_BYTES:       memcpy(posicao, dados->bytes + item->origem, item->tamanho); break;
+        case DADO_REPETIDO:    memset(posicao, item->valor, item->tamanho); break;
+        case DADO_ALINHAMENTO: memset(posicao, 0, item->tamanho); break;
+        case DADO_INCLUIDO:    memcpy(posicao, dados->incluidos[item->origem].inicio, item->tamanho); break;
+        }
+    }
+}
+
+// Move os itens de 'origem' (interpretada com linhas relativas) para o fim de 'destino',
+// ajustando as posições em 'bytes' e 'incluidos' e somando 'base_linha' aos números de linha.
+// Os mapeamentos passam a pertencer a 'destino'.
+static void dados_anexar(SecaoDados *destino, SecaoDados *origem, uint32_t base_linha) {
+    uint32_t base_item = (uint32_t)destino->quantidade_itens, base_byte = (uint32_t)destino->quantidade_bytes;
+    uint32_t base_incluido = (uint32_t)destino->quantidade_incluidos;
+    destino->itens = dados_reservar(destino->itens, destino->quantidade_itens, &destino->capacidade_itens, origem->quantidade_itens, sizeof(ItemDados));
+    for (size_t i = 0; i < origem->quantidade_itens; i++) {
+        ItemDados *item = &destino->itens[destino->quantidade_itens++];
+        *item = origem->itens[i];
+        item->numero_linha += base_linha;
+        if (item->tipo == DADO_BYTES) item->origem += base_byte;
+        else if (item->tipo == DADO_INCLUIDO) item->origem += base_incluido;
+    }
+    if (origem->quantidade_bytes > 0) {
+        destino->bytes = dados_reservar(destino->bytes, destino->quantidade_bytes, &destino->capacidade_bytes, origem->quantidade_bytes, 1);
+        memcpy(destino->bytes + destino->quantidade_bytes, origem->bytes, origem->quantidade_bytes);
+        destino->quantidade_bytes += origem->quantidade_bytes;
+    }
+    destino->referencias = dados_reservar(destino->referencias, destino->quantidade_referencias, &destino->capacidade_referencias,
+                                          origem->quantidade_referencias, sizeof(ReferenciaDados));
+    for (size_t i = 0; i < origem->quantidade_referencias; i++) {
+        ReferenciaDados *referencia = &destino->referencias[destino->quantidade_referencias++];
+        *referencia = origem->referencias[i];
+        referencia->numero_linha += base_linha;
+        referencia->item += base_item;
+        referencia->posicao += base_byte;
+    }
+    destino->incluidos = dados_reservar(destino->incluidos, destino->quantidade_incluidos, &destino->capacidade_incluidos,
+                                        origem->quantidade_incluidos, sizeof(ArquivoIncluido));
+    if (origem->quantidade_incluidos > 0) memcpy(destino->incluidos + destino->quantidade_incluidos, origem->incluidos,
+                                                 origem->quantidade_incluidos * sizeof(ArquivoIncluido));
+    destino->quantidade_incluidos += origem->quantidade_incluidos;
+    if (origem->alinhamento > destino->alinhamento) destino->alinhamento = origem->alinhamento;
+    origem->quantidade_incluidos = 0; // Não desfaz os mapeamentos, que agora são do destino
+    dados_liberar(origem);
+}
+
+// Mapeia o arquivo de .incbin e acrescenta o item com 'tamanho' bytes a partir de 'desvio'
+// (tamanho -1 = até o fim do arquivo). Retorna 0 ou -1 (com o erro registrado).
+static int dados_incluir_arquivo(SecaoDados *dados, const char *nome, long desvio, long tamanho, LinhaAtual *atual) {
+    char motivo[128];
+    int descritor = open(nome, O_RDONLY);
+    struct stat informacoes;
+    if (descritor < 0 || fstat(descritor, &informacoes) != 0) {
+        strerror_r(errno, motivo, sizeof(motivo));
+        erro_linha(atual, "Não foi possível abrir '%s': %s", nome, motivo);
+        if (descritor >= 0) close(descritor);
+        return -1;
+    }
+    if (!S_ISREG(informacoes.st_mode)) { // Só arquivos comuns podem ser mapeados
+        erro_linha(atual, "'%s' não é um arquivo comum", nome);
+        close(descritor);
+        return -1;
+    }
+    uint64_t tamanho_arquivo = (uint64_t)informacoes.st_size;
+    if ((uint64_t)desvio > tamanho_arquivo || (tamanho >= 0 && (uint64_t)tamanho > tamanho_arquivo - (uint64_t)desvio)) {
+        erro_linha(atual, "Trecho além do fim de '%s' (%llu bytes)", nome, (unsigned long long)tamanho_arquivo);
+        close(descritor);
+        return -1;
+    }
+    uint64_t incluido = tamanho >= 0 ? (uint64_t)tamanho : tamanho_arquivo - (uint64_t)desvio;
+    if (incluido > TAMANHO_MAXIMO_DADOS) {
+        erro_linha(atual, "O arquivo '%s' excede 2 GiB", nome);
+        close(descritor);
+        return -1;
+    }
+    void *mapa = NULL;
+    if (tamanho_arquivo > 0) {
+        mapa = mmap(NULL, (size_t)tamanho_arquivo, PROT_READ, MAP_PRIVATE, descritor, 0);
+        if (mapa == MAP_FAILED) {
+            strerror_r(errno, motivo, sizeof(motivo));
+            erro_linha(atual, "Não foi possível mapear '%s': %s", nome, motivo);
+            close(descritor);
+            return -1;
+        }
+        posix_madvise(mapa, (size_t)tamanho_arquivo, POSIX_MADV_SEQUENTIAL); // Lido uma vez, do início ao fim
+    }
+    close(descritor); // O mapeamento continua válido
+
+    dados->incluidos = dados_reservar(dados->incluidos, dados->quantidade_incluidos, &dados->capacidade_incluidos, 1, sizeof(ArquivoIncluido));
+    dados->incluidos[dados->quantidade_incluidos] = (ArquivoIncluido){ mapa, (size_t)tamanho_arquivo,
+                                                                       mapa != NULL ? (const uint8_t *)mapa + desvio : NULL };
+    dados_adicionar_item(dados, DADO_INCLUIDO, (uint32_t)incluido, (uint32_t)dados->quantidade_incluidos++, atual);
+    return 0;
+}
+
+// Diretivas de dados e o item que cada uma produz
+static const struct {
+    const char *nome;
+    uint8_t tipo;    // TipoDado
+    uint8_t largura; // Bytes por valor (DADO_BYTES)
+} diretivas_dados[] = {
+    { ".word",   DADO_BYTES,       4 },
+    { ".half",   DADO_BYTES,       2 },
+    { ".byte",   DADO_BYTES,       1 },
+    { ".space",  DADO_REPETIDO,    0 },
+    { ".align",  DADO_ALINHAMENTO, 0 },
+    { ".incbin", DADO_INCLUIDO,    0 },
+};
+
+#define NUMERO_DIRETIVAS_DADOS (sizeof(diretivas_dados) / sizeof(diretivas_dados[0]))
+
+// Retorna o índice da diretiva de dados em diretivas_dados, ou -1 se não for uma
+static int buscar_diretiva_dados(Token diretiva) {
+    for (size_t i = 0; i < NUMERO_DIRETIVAS_DADOS; i++) {
+        if (token_igual(diretiva, diretivas_dados[i].nome)) return (int)i;
+    }
+    return -1;
+}
+
+// Interpreta os argumentos da diretiva de dados 'indice' (continuando a tokenização da linha)
+// e acrescenta o item a 'dados':
+//   .word v1, v2, ...        valores de 32 bits, com ou sem sinal, ou rótulos (o endereço)
+//   .half v1, ... / .byte    valores de 16 / 8 bits
+//   .space tamanho[, valor]  'tamanho' bytes iguais a 'valor' (padrão 0)
+//   .align n                 alinha a posição em 2^n bytes, com zeros
+//   .incbin arquivo[, desvio[, tamanho]]  o conteúdo do arquivo (relativo ao diretório atual)
+// Os nomes dos rótulos de .word apontam para o texto da linha, como os tokens.
+static void interpretar_dados(int indice, LinhaAtual *atual, SecaoDados *dados) {
+    const char *diretiva = diretivas_dados[indice].nome;
+    Token argumentos[3];
+    int quantidade = 0;
+    long valores[3];
+
+    switch (diretivas_dados[indice].tipo) {
+    case DADO_BYTES: {
+        unsigned largura = diretivas_dados[indice].largura;
+        long minimo = largura == 4 ? INT32_MIN : -(1L << (8 * largura - 1));
+        long maximo = largura == 4 ? (long)UINT32_MAX : (1L << (8 * largura)) - 1;
+        size_t inicio = dados->quantidade_bytes, referencias = dados->quantidade_referencias;
+        for (Token valor_txt; (valor_txt = proximo_token(atual)).texto != NULL; ) {
+            long valor = 0;
+            if (converter_imediato(valor_txt, &valor) != 0) {
+                // Um valor que não é número só pode ser um rótulo, e só em .word
+                char primeiro = valor_txt.texto[0];
+                if (largura != 4 || (primeiro >= '0' && primeiro <= '9') || primeiro == '-' || primeiro == '+') {
+                    erro_linha(atual, "Valor inválido '%.*s' para '%s'", (int)valor_txt.tamanho, valor_txt.texto, diretiva);
+                    dados->quantidade_bytes = inicio;
+                    dados->quantidade_referencias = referencias;
+                    return;
+                }
+                dados->referencias = dados_reservar(dados->referencias, dados->quantidade_referencias, &dados->capacidade_referencias,
+                                                    1, sizeof(ReferenciaDados));
+                dados->referencias[dados->quantidade_referencias++] = (ReferenciaDados){
+                    valor_txt.texto, atual->texto_linha, valor_txt.tamanho, atual->numero_linha,
+                    (uint32_t)dados->quantidade_itens, (uint32_t)dados->quantidade_bytes };
+            } else if (valor < minimo || valor > maximo) {
+                erro_linha(atual, "Valor fora do alcance de '%s': %.*s", diretiva, (int)valor_txt.tamanho, valor_txt.texto);
+                dados->quantidade_bytes = inicio;
+                dados->quantidade_referencias = referencias;
+                return;
+            }
+            dados->bytes = dados_reservar(dados->bytes, dados->quantidade_bytes, &dados->capacidade_bytes, largura, 1);
+            for (unsigned k = 0; k < largura; k++) dados->bytes[dados->quantidade_bytes++] = (uint8_t)((uint64_t)valor >> (8 * k)); // Little-endian
+        }
+        if (dados->quantidade_bytes == inicio) {
+            erro_linha(atual, "Formato inválido para '%s'. Use '%s valor[, valor...]'", diretiva, diretiva);
+            return;
+        }
+        dados_adicionar_item(dados, DADO_BYTES, (uint32_t)(dados->quantidade_bytes - inicio), (uint32_t)inicio, atual);
+        return;
+    }
+    case DADO_REPETIDO:
+        while (quantidade < 3 && (argumentos[quantidade] = proximo_token(atual)).texto != NULL) quantidade++;
+        if (quantidade < 1 || quantidade > 2 || converter_imediato(argumentos[0], &valores[0]) != 0 ||
+            (quantidade == 2 && converter_imediato(argumentos[1], &valores[1]) != 0)) {
+            erro_linha(atual, "Formato inválido para '%s'. Use '%s tamanho[, valor]'", diretiva, diretiva);
+            return;
+        }
+        if (quantidade == 1) valores[1] = 0;
+        if (valores[0] < 0 || valores[0] > TAMANHO_MAXIMO_DADOS || valores[1] < -128 || valores[1] > 255) {
+            erro_linha(atual, "Parâmetro inválido para '%s'", diretiva);
+            return;
+        }
+        dados_adicionar_item(dados, DADO_REPETIDO, (uint32_t)valores[0], 0, atual)->valor = (uint8_t)valores[1];
+        return;
+    case DADO_ALINHAMENTO:
+        while (quantidade < 2 && (argumentos[quantidade] = proximo_token(atual)).texto != NULL) quantidade++;
+        if (quantidade != 1 || converter_imediato(argumentos[0], &valores[0]) != 0 ||
+            valores[0] < 0 || valores[0] > MAXIMO_EXPOENTE_ALINHAMENTO) {
+            erro_linha(atual, "Formato inválido para '%s'. Use '%s n', com n de 0 a %d (alinhamento de 2^n bytes)",
+                       diretiva, diretiva, MAXIMO_EXPOENTE_ALINHAMENTO);
+            return;
+        }
+        dados_adicionar_item(dados, DADO_ALINHAMENTO, 0, 1u << valores[0], atual);
+        if ((1u << valores[0]) > dados->alinhamento) dados->alinhamento = 1u << valores[0];
+        return;
+    case DADO_INCLUIDO: {
+        if (dados->sem_arquivos) {
+            erro_linha(atual, "'%s' não é suportado na montagem em memória (montador_montar), que não lê arquivos", diretiva);
+            return;
+        }
+        while (quantidade < 3 && (argumentos[quantidade] = proximo_token(atual)).texto != NULL) quantidade++;
+        valores[1] = 0;
+        valores[2] = -1;
+        int valido = quantidade >= 1 && proximo_token(atual).texto == NULL;
+        for (int i = 1; i < quantidade && valido; i++) valido = converter_imediato(argumentos[i], &valores[i]) == 0 && valores[i] >= 0;
+        Token nome = valido ? argumentos[0] : (Token){ NULL, 0 };
+        if (nome.tamanho >= 2 && nome.texto[0] == '"' && nome.texto[nome.tamanho - 1] == '"') { // Aspas são opcionais
+            nome.texto++;
+            nome.tamanho -= 2;
+        }
+        if (nome.texto == NULL || nome.tamanho == 0) {
+            erro_linha(atual, "Formato inválido para '%s'. Use '%s arquivo[, desvio[, tamanho]]'", diretiva, diretiva);
+            return;
+        }
+        char *caminho = strndup(nome.texto, nome.tamanho); // open precisa do nome terminado em '\0'
+        if (caminho == NULL) memoria_insuficiente("a seção de dados");
+        dados_incluir_arquivo(dados, caminho, valores[1], valores[2], atual);
+        free(caminho);
+        return;
+    }
+    }
+}
+
+// --- Interpretação de uma Linha ---
+// Comum à montagem em duas passagens e à montagem em fluxo.
+#define MAXIMO_INSTRUCOES_LINHA 2 // li e la podem virar duas instruções
+
+typedef struct {
+    Token rotulo;                        // Rótulo definido na linha (texto NULL = nenhum)
+    Token global;                        // Rótulo declarado por .globl na linha (texto NULL = nenhum)
+    const DescritorInstrucao *descritores[MAXIMO_INSTRUCOES_LINHA]; // Instruções da linha, já expandidas
+    Operandos operandos[MAXIMO_INSTRUCOES_LINHA];
+    int quantidade;                      // Instruções válidas (0 = nenhuma ou com erro)
+    uint32_t tamanho;                    // Bytes de código ocupados pela linha (uma instrução inválida ocupa 4)
+    Secao secao;                         // Seção escolhida por .text ou .data na linha (SECAO_INDEFINIDA = nenhuma)
+} LinhaInterpretada;
+
+// Interpreta uma diretiva (token iniciado por '.'). ".globl rotulo" (ou ".global") torna o
+// rótulo visível para a ligação; ".text" e ".data" escolhem a seção das linhas seguintes; as
+// diretivas de dados, só aceitas na seção .data, acrescentam um item a 'dados'.
+// Nenhuma diretiva ocupa espaço no código.
+static void interpretar_diretiva(Token diretiva, LinhaAtual *atual, Secao secao, SecaoDados *dados, LinhaInterpretada *resultado) {
+    int indice;
+    if (token_igual(diretiva, ".globl") || token_igual(diretiva, ".global")) {
+        Token nome = proximo_token(atual);
+        if (nome.texto == NULL || proximo_token(atual).texto != NULL) {
+            erro_linha(atual, "Formato inválido para '%.*s'. Use '%.*s rotulo'", (int)diretiva.tamanho, diretiva.texto,
+                       (int)diretiva.tamanho, diretiva.texto);
+            return;
+        }
+        resultado->global = nome;
+    } else if (token_igual(diretiva, ".text") || token_igual(diretiva, ".data")) {
+        if (proximo_token(atual).texto != NULL) {
+            erro_linha(atual, "Formato inválido para '%.*s'", (int)diretiva.tamanho, diretiva.texto);
+            return;
+        }
+        resultado->secao = diretiva.texto[1] == 't' ? SECAO_TEXTO : SECAO_DADOS;
+    } else if ((indice = buscar_diretiva_dados(diretiva)) >= 0) {
+        if (secao == SECAO_TEXTO) erro_linha(atual, "Diretiva de dados fora da seção .data");
+        else interpretar_dados(indice, atual, dados);
+    } else {
+        erro_linha(atual, "Diretiva desconhecida: '%.*s'", (int)diretiva.tamanho, diretiva.texto);
+    }
+}
+
+// Expande li e la, as pseudoinstruções cujo tamanho depende do operando, nas instruções reais.
+// li usa a menor sequência para o valor: addi (12 bits com sinal), lui (12 bits inferiores
+// zerados) ou lui + addi. la sempre usa lui + addi com %hi/%lo do rótulo, pois o endereço só
+// é conhecido na segunda passagem (ou na ligação). As demais ocupam uma única instrução.
+static void expandir_pseudoinstrucao(const DescritorInstrucao *d, LinhaInterpretada *resultado) {
+    Operandos *op = resultado->operandos;
+    resultado->descritores[0] = d;
+    resultado->quantidade = 1;
+    if (d->operandos == OPERANDOS_RD_IMM32) {
+        int32_t valor = op[0].imm;
+        if (valor >= -2048 && valor <= 2047) return; // addi rd, x0, valor
+        int32_t baixa = parte_baixa((uint32_t)valor);
+        resultado->descritores[0] = buscar_instrucao("lui");
+        op[0].imm = parte_alta((uint32_t)valor);
+        if (baixa == 0) return;
+        resultado->descritores[1] = buscar_instrucao("addi");
+        op[1] = (Operandos){ op[0].rd, op[0].rd, 0, baixa, { NULL, 0 } };
+        resultado->quantidade = 2;
+    } else if (d->operandos == OPERANDOS_RD_SIMBOLO) {
+        resultado->descritores[1] = buscar_instrucao("addi"); // lui rd, %hi(rotulo); addi rd, rd, %lo(rotulo)
+        op[1] = (Operandos){ op[0].rd, op[0].rd, 0, 0, op[0].simbolo };
+        resultado->quantidade = 2;
+    }
+}
+
+// Separa o rótulo e a instrução (ou diretiva) da linha, a partir da posição do léxico de
+// 'atual', e interpreta os operandos. Os tokens delimitam-se por espaços, tabulações e
+// vírgulas. 'secao' é a seção atual: instruções só são aceitas na .text e diretivas de dados,
+// que vão para 'dados', só na .data (SECAO_INDEFINIDA aceita as duas; ver primeira_passagem).
+static void interpretar_linha(LinhaAtual *atual, Secao secao, SecaoDados *dados, LinhaInterpretada *resultado) {
+    memset(resultado, 0, sizeof(*resultado));
+
+    // Um ':' no primeiro token define um rótulo; a instrução, se houver, vem a seguir
+    resultado->rotulo = lexico_rotulo(atual->lexico);
+    Token token = proximo_token(atual);
+    if (token.texto == NULL) return; // Linha vazia ou rótulo em uma linha própria
+    if (token.texto[0] == '.') {
+        interpretar_diretiva(token, atual, secao, dados, resultado);
+        return;
+    }
+    if (secao == SECAO_DADOS) {
+        erro_linha(atual, "Instrução fora da seção .text");
+        return;
+    }
+
+    // Se não era um rótulo ou se havia uma instrução após o rótulo, esta linha contém uma
+    // instrução. Uma instrução inválida ocupa 4 bytes, para que os endereços das mensagens de
+    // erro seguintes continuem coerentes.
+    resultado->tamanho = 4;
+    const DescritorInstrucao *descritor = buscar_instrucao_token(token);
+    if (descritor == NULL) {
+        erro_linha(atual, "Instrução desconhecida: '%.*s'", (int)token.tamanho, token.texto);
+    } else if (interpretar_operandos(descritor, &resultado->operandos[0], atual)) {
+        expandir_pseudoinstrucao(descritor, resultado);
+        resultado->tamanho = 4 * (uint32_t)resultado->quantidade;
+        ESTAT_CONTAR(instrucoes[descritor - tabela_instrucoes], 1);
+    }
+}
+
+// Calcula o deslocamento de um branch ou JAL da instrução atual até 'endereco_destino',
+// verificando paridade e alcance. Retorna 0 em caso de sucesso ou -1 (com o erro registrado).
+static int calcular_deslocamento(const DescritorInstrucao *d, int endereco_destino, LinhaAtual *atual,
+                                 const char *rotulo, int tamanho_rotulo, int32_t *deslocamento) {
+    int valor = endereco_destino - (int)atual->endereco;
+    if (d->formato == FORMATO_B) {
+        // O deslocamento para branches é em múltiplos de 2 bytes (1 bit implícito 0 à direita)
+        // O campo imediato de 13 bits (incluindo o implícito) pode representar de -4096 a +4094 bytes.
+        if (valor % 2 != 0) { erro_linha(atual, "Deslocamento do branch '%.*s' não é múltiplo de 2", tamanho_rotulo, rotulo); return -1; }
+        if (valor < -4096 || valor > 4094) { erro_linha(atual, "Deslocamento do branch '%.*s' fora do alcance", tamanho_rotulo, rotulo); return -1; }
+    } else {
+        // O deslocamento para JAL é em múltiplos de 2 bytes.
+        // O campo imediato de 21 bits (incluindo o implícito 0 à direita) pode representar +/- 1MB.
+        if (valor % 2 != 0) { erro_linha(atual, "Deslocamento do JAL '%.*s' não é múltiplo de 2", tamanho_rotulo, rotulo); return -1; }
+        if (valor < -(1 << 20) || valor >= (1 << 20)) { erro_linha(atual, "Deslocamento JAL '%.*s' fora do alcance", tamanho_rotulo, rotulo); return -1; }
+    }
+    *deslocamento = valor;
+    return 0;
+}
+
+// Calcula o imediato de uma instrução que referencia o rótulo em 'endereco_destino': o
+// deslocamento relativo ao PC para branches e jal, os 20 bits superiores do endereço para
+// "%hi(rotulo)" (formato U) e os 12 bits inferiores, com sinal, para "%lo(rotulo)" (formatos I e S).
+// Retorna 0 ou -1 (com o erro registrado).
+static int resolver_referencia(const DescritorInstrucao *d, int endereco_destino, LinhaAtual *atual,
+                               const char *rotulo, int tamanho_rotulo, int32_t *imm) {
+    switch (d->formato) {
+    case FORMATO_B:
+    case FORMATO_J:
+        return calcular_deslocamento(d, endereco_destino, atual, rotulo, tamanho_rotulo, imm);
+    case FORMATO_U:
+        *imm = parte_alta((uint32_t)endereco_destino);
+        return 0;
+    default:
+        *imm = parte_baixa((uint32_t)endereco_destino);
+        return 0;
+    }
+}
+
+// Codifica um branch relaxado (ver relaxar_branches): o branch de condição inversa, que pula
+// a instrução seguinte, e um "jal x0" até o rótulo. Retorna 0 ou -1 (com o erro registrado).
+static int codificar_branch_relaxado(const DescritorInstrucao *d, const Operandos *op, int endereco_destino, LinhaAtual *atual,
+                                     const char *rotulo, int tamanho_rotulo, uint32_t palavras[2]) {
+    const DescritorInstrucao *jal = buscar_instrucao("jal");
+    LinhaAtual salto = *atual; // O jal fica na palavra seguinte
+    salto.endereco += 4;
+    int32_t deslocamento;
+    if (calcular_deslocamento(jal, endereco_destino, &salto, rotulo, tamanho_rotulo, &deslocamento) != 0) return -1;
+    DescritorInstrucao inverso = *d;
+    inverso.funct3 ^= 1; // beq <-> bne, blt <-> bge, bltu <-> bgeu
+    palavras[0] = codificar_b(&inverso, op->rs1, op->rs2, 8);
+    palavras[1] = codificar_j(jal, 0, deslocamento);
+    return 0;
+}
+
+// --- Fonte em memória ---
+// O arquivo de entrada é lido uma única vez; as passagens e a impressão inicial trabalham
+// sobre este buffer. Um arquivo comum é mapeado em memória (mapear_fonte), sem cópia.
+typedef struct {
+    char *texto;         // Conteúdo do arquivo, terminado em '\0'
+    size_t tamanho;      // Tamanho em bytes (sem o terminador)
+    size_t tamanho_mapa; // Bytes mapeados com mmap (0 = texto alocado com malloc)
+} Fonte;
+
+// Lê o arquivo inteiro para a memória. Retorna 0 em caso de sucesso ou -1 em caso de erro,
+// registrado em 'diagnosticos' (ou impresso em stderr, se for NULL).
+static int carregar_fonte(const char *nome_arquivo_entrada, Fonte *fonte, ListaDiagnosticos *diagnosticos) {
+    char motivo[128];
+    FILE *arquivo_entrada = fopen(nome_arquivo_entrada, "rb");
+    if (arquivo_entrada == NULL) {
+        strerror_r(errno, motivo, sizeof(motivo));
+        diagnosticos_erro_arquivo(diagnosticos, "Não foi possível abrir o arquivo de entrada '%s': %s", nome_arquivo_entrada, motivo);
+        return -1;
+    }
+
+    size_t capacidade = 64 * 1024, tamanho = 0;
+    char *texto = malloc(capacidade);
+    while (texto != NULL) {
+        tamanho += fread(texto + tamanho, 1, capacidade - tamanho - 1, arquivo_entrada);
+        if (tamanho < capacidade - 1) break; // Fim do arquivo (ou erro, verificado abaixo)
+        capacidade *= 2;
+        char *maior = realloc(texto, capacidade);
+        if (maior == NULL) free(texto);
+        texto = maior;
+    }
+    if (texto == NULL || ferror(arquivo_entrada)) {
+        if (texto == NULL) snprintf(motivo, sizeof(motivo), "memória insuficiente");
+        else strerror_r(errno, motivo, sizeof(motivo));
+        diagnosticos_erro_arquivo(diagnosticos, "Não foi possível ler o arquivo de entrada '%s': %s", nome_arquivo_entrada, motivo);
+        free(texto);
+        fclose(arquivo_entrada);
+        return -1;
+    }
+    fclose(arquivo_entrada);
+
+    // Os registros da representação intermediária guardam posições de 32 bits no fonte
+    if (tamanho > UINT32_MAX) {
+        diagnosticos_erro_arquivo(diagnosticos, "O arquivo de entrada '%s' excede 4 GiB", nome_arquivo_entrada);
+        free(texto);
+        return -1;
+    }
+    texto[tamanho] = '\0';
+    fonte->texto = texto;
+    fonte->tamanho = tamanho;
+    fonte->tamanho_mapa = 0;
+    return 0;
+}
+
+// Mapeia o arquivo na memória, para que as passagens leiam as páginas do próprio arquivo. O
+// '\0' final vem do resto da última página, que o sistema completa com zeros; quando o
+// tamanho é múltiplo da página (ou o arquivo não é comum, como um pipe), o arquivo é lido
+// com carregar_fonte. O arquivo não deve ser alterado enquanto estiver mapeado.
+// Retorna 0 em caso de sucesso ou -1 em caso de erro, registrado como em carregar_fonte.
+static int mapear_fonte(const char *nome_arquivo_entrada, Fonte *fonte, ListaDiagnosticos *diagnosticos) {
+    int descritor = open(nome_arquivo_entrada, O_RDONLY);
+    if (descritor < 0) {
+        char motivo[128];
+        strerror_r(errno, motivo, sizeof(motivo));
+        diagnosticos_erro_arquivo(diagnosticos, "Não foi possível abrir o arquivo de entrada '%s': %s", nome_arquivo_entrada, motivo);
+        return -1;
+    }
+    struct stat informacoes;
+    long pagina = sysconf(_SC_PAGESIZE);
+    if (fstat(descritor, &informacoes) != 0 || !S_ISREG(informacoes.st_mode) || informacoes.st_size == 0 || pagina <= 0 ||
+        (uint64_t)informacoes.st_size % (uint64_t)pagina == 0) {
+        close(descritor);
+        return carregar_fonte(nome_arquivo_entrada, fonte, diagnosticos);
+    }
+    // Os registros da representação intermediária guardam posições de 32 bits no fonte
+    if ((uint64_t)informacoes.st_size > UINT32_MAX) {
+        diagnosticos_erro_arquivo(diagnosticos, "O arquivo de entrada '%s' excede 4 GiB", nome_arquivo_entrada);
+        close(descritor);
+        return -1;
+    }
+    size_t tamanho = (size_t)informacoes.st_size;
+    char *texto = mmap(NULL, tamanho + 1, PROT_READ, MAP_PRIVATE, descritor, 0);
+    close(descritor); // O mapeamento continua válido
+    if (texto == MAP_FAILED) return carregar_fonte(nome_arquivo_entrada, fonte, diagnosticos);
+    posix_madvise(texto, tamanho, POSIX_MADV_SEQUENTIAL); // Cada trecho é lido do início ao fim
+    fonte->texto = texto;
+    fonte->tamanho = tamanho;
+    fonte->tamanho_mapa = tamanho + 1;
+    return 0;
+}
+
+static void fonte_liberar(Fonte *fonte) {
+    if (fonte->tamanho_mapa != 0) munmap(fonte->texto, fonte->tamanho_mapa);
+    else free(fonte->texto);
+    fonte->texto = NULL;
+}
+
+// --- Representação Intermediária ---
+// A primeira passagem produz um registro de tamanho fixo por instrução, com os operandos
+// já interpretados e validados. A segunda passagem apenas resolve rótulos e codifica.
+typedef struct {
+    uint8_t instrucao;         // Índice do descritor em tabela_instrucoes
+    uint8_t rd, rs1, rs2;
+    uint8_t tamanho;           // Bytes ocupados: 2 (comprimida), 4, ou 8 para um branch relaxado
+    uint32_t endereco;         // Endereço da instrução em bytes
+    int32_t imm;               // Imediato já validado (branches e jal recebem o deslocamento na segunda passagem)
+    uint32_t simbolo;          // Posição, no fonte, do nome do rótulo referenciado
+    uint32_t tamanho_simbolo;  // Comprimento desse nome (0 = a instrução não referencia rótulo)
+    uint32_t linha;            // Posição, no fonte, do início da linha (para mensagens de erro)
+    uint32_t numero_linha;     // Número da linha no fonte
+} InstrucaoIR;
+
+typedef struct {
+    InstrucaoIR *instrucoes;
+    size_t quantidade;
+    size_t capacidade;
+    uint32_t tamanho;          // Bytes de código do programa
+    SecaoDados dados;          // Seção .data
+} ProgramaIR;
+
+// Reserva um novo registro no final do programa
+static InstrucaoIR *programa_ir_adicionar(ProgramaIR *programa) {
+    if (programa->quantidade == programa->capacidade) {
+        size_t capacidade = programa->capacidade ? programa->capacidade * 2 : 1024;
+        InstrucaoIR *novas = realloc(programa->instrucoes, capacidade * sizeof(InstrucaoIR));
+        if (novas == NULL) memoria_insuficiente("a representação intermediária");
+        programa->instrucoes = novas;
+        programa->capacidade = capacidade;
+    }
+    return &programa->instrucoes[programa->quantidade++];
+}
+
+static void programa_ir_liberar(ProgramaIR *programa) {
+    free(programa->instrucoes);
+    dados_liberar(&programa->dados);
+    memset(programa, 0, sizeof(*programa));
+}
+
+// --- Execução Paralela ---
+// Um conjunto de threads executa tarefas numeradas com roubo de trabalho: cada thread recebe
+// um intervalo contíguo de tarefas (sua fila) e o consome pelo início; quando ele acaba,
+// rouba a metade final da fila de outra thread. Cada fila é uma única palavra atômica
+// (início nos 32 bits altos, fim nos baixos), alterada sempre por compare-and-swap, então
+// nenhuma trava é necessária. A thread que chama também trabalha, então com 1 thread nada é criado.
+typedef struct {
+    _Alignas(64) atomic_uint_least64_t intervalo; // Uma fila por linha de cache
+} FilaTarefas;
+
+typedef struct {
+    void (*tarefa)(void *contexto, size_t indice);
+    void *contexto;
+    FilaTarefas *filas;
+    size_t numero_filas;
+    atomic_int sem_memoria; // 1 = faltou memória em alguma tarefa (biblioteca); as demais param
+} ConjuntoTrabalho;
+
+typedef struct {
+    ConjuntoTrabalho *conjunto;
+    size_t indice; // Fila própria desta thread
+} Trabalhador;
+
+static uint64_t intervalo_tarefas(uint32_t inicio, uint32_t fim) {
+    return ((uint64_t)inicio << 32) | fim;
+}
+
+// Retira a próxima tarefa do início da fila. Retorna 0 se a fila estiver vazia.
+static int fila_retirar(FilaTarefas *fila, size_t *tarefa) {
+    uint64_t atual = atomic_load(&fila->intervalo);
+    for (;;) {
+        uint32_t inicio = (uint32_t)(atual >> 32), fim = (uint32_t)atual;
+        if (inicio >= fim) return 0;
+        if (atomic_compare_exchange_weak(&fila->intervalo, &atual, intervalo_tarefas(inicio + 1, fim))) {
+            *tarefa = inicio;
+            return 1;
+        }
+    }
+}
+
+// Rouba a metade final da fila (pelo menos uma tarefa). Retorna 0 se a fila estiver vazia.
+static int fila_roubar(FilaTarefas *fila, uint32_t *inicio_roubado, uint32_t *fim_roubado) {
+    uint64_t atual = atomic_load(&fila->intervalo);
+    for (;;) {
+        uint32_t inicio = (uint32_t)(atual >> 32), fim = (uint32_t)atual;
+        if (inicio >= fim) return 0;
+        uint32_t metade = (fim - inicio + 1) / 2;
+        if (atomic_compare_exchange_weak(&fila->intervalo, &atual, intervalo_tarefas(inicio, fim - metade))) {
+            *inicio_roubado = fim - metade;
+            *fim_roubado = fim;
+            return 1;
+        }
+    }
+}
+
+static void *trabalhador_executar(void *argumento) {
+    Trabalhador *trabalhador = argumento;
+    ConjuntoTrabalho *conjunto = trabalhador->conjunto;
+    FilaTarefas *propria = &conjunto->filas[trabalhador->indice];
+    for (;;) {
+        size_t tarefa;
+        while (!atomic_load_explicit(&conjunto->sem_memoria, memory_order_relaxed) && fila_retirar(propria, &tarefa))
+            conjunto->tarefa(conjunto->contexto, tarefa);
+        if (atomic_load_explicit(&conjunto->sem_memoria, memory_order_relaxed)) return NULL;
+
+        // Fila vazia: procura trabalho nas outras. Tarefas nunca são criadas, só movidas, então
+        // se todas as filas estão vazias o restante já está nas mãos de alguma thread.
+        int roubou = 0;
+        for (size_t k = 1; k < conjunto->numero_filas && !roubou; k++) {
+            uint32_t inicio, fim;
+            if (fila_roubar(&conjunto->filas[(trabalhador->indice + k) % conjunto->numero_filas], &inicio, &fim)) {
+                atomic_store(&propria->intervalo, intervalo_tarefas(inicio, fim));
+                roubou = 1;
+            }
+        }
+        if (!roubou) return NULL;
+    }
+}
+
+// Na biblioteca, cada thread tem seu próprio ponto de retorno: a falta de memória em uma
+// tarefa só marca o conjunto, e quem chamou executar_em_paralelo a repassa depois de juntar
+// as threads
+static void *trabalhador_executar_protegido(void *argumento) {
+    Trabalhador *trabalhador = argumento;
+    RetornoMemoria *anterior = retorno_memoria;
+    RetornoMemoria retorno = { .liberar = NULL };
+    retorno_memoria = &retorno;
+    if (setjmp(retorno.ponto) == 0) trabalhador_executar(trabalhador);
+    else atomic_store(&trabalhador->conjunto->sem_memoria, 1);
+    retorno_memoria = anterior;
+    return NULL;
+}
+
+// Executa tarefa(contexto, i) para cada i em [0, quantidade), usando até 'threads' threads
+static void executar_em_paralelo(size_t quantidade, int threads, void (*tarefa)(void *, size_t), void *contexto) {
+    size_t numero_filas = (threads > 1 && quantidade > 1) ? (size_t)threads : 1;
+    if (numero_filas > quantidade) numero_filas = quantidade;
+    if (numero_filas <= 1 || quantidade > UINT32_MAX) { // Sem paralelismo, ou mais tarefas do que a fila comporta
+        for (size_t i = 0; i < quantidade; i++) tarefa(contexto, i);
+        return;
+    }
+
+    FilaTarefas *filas = aligned_alloc(_Alignof(FilaTarefas), numero_filas * sizeof(FilaTarefas));
+    Trabalhador *trabalhadores = malloc(numero_filas * sizeof(Trabalhador));
+    pthread_t *ids = malloc(numero_filas * sizeof(pthread_t));
+    if (filas == NULL || trabalhadores == NULL || ids == NULL) {
+        free(filas);
+        free(trabalhadores);
+        free(ids);
+        memoria_insuficiente("as threads");
+    }
+    ConjuntoTrabalho conjunto = { tarefa, contexto, filas, numero_filas, 0 };
+    for (size_t i = 0; i < numero_filas; i++) {
+        atomic_init(&filas[i].intervalo, intervalo_tarefas((uint32_t)(quantidade * i / numero_filas),
+                                                           (uint32_t)(quantidade * (i + 1) / numero_filas)));
+        trabalhadores[i].conjunto = &conjunto;
+        trabalhadores[i].indice = i;
+    }
+
+    void *(*executar)(void *) = retorno_memoria != NULL ? trabalhador_executar_protegido : trabalhador_executar;
+    size_t criadas = 0;
+    for (size_t i = 1; i < numero_filas; i++) {
+        // Se a criação falhar, a fila dessa thread é roubada pelas demais
+        if (pthread_create(&ids[criadas], NULL, executar, &trabalhadores[i]) == 0) criadas++;
+    }
+    executar(&trabalhadores[0]);
+    for (size_t i = 0; i < criadas; i++) pthread_join(ids[i], NULL);
+    free(ids);
+    free(trabalhadores);
+    free(filas);
+    if (atomic_load(&conjunto.sem_memoria)) memoria_insuficiente("as threads");
+}
+
+// --- Função da Primeira Passagem (Coleta de Rótulos e Interpretação) ---
+// O fonte é dividido em trechos que terminam em fim de linha. Cada trecho é interpretado
+// de forma independente (possivelmente em paralelo), com números de linha e endereços
+// relativos ao seu início; depois os trechos são costurados em ordem, o que define os
+// endereços finais dos rótulos e numera as linhas de forma global.
+#define TAMANHO_MINIMO_TRECHO (256 * 1024) // Fontes menores que isso não são divididos
+#define TRECHOS_POR_THREAD 4               // Mais trechos que threads equilibra a carga
+
+// Rótulo encontrado em um trecho, ainda com endereço relativo
+typedef struct {
+    uint32_t nome;          // Posição do nome no fonte
+    uint32_t tamanho;       // Comprimento do nome
+    uint32_t endereco;      // Endereço relativo ao início do trecho
+    uint32_t numero_linha;  // Linha relativa ao início do trecho
+    uint32_t linha;         // Posição, no fonte, do início da linha
+    uint32_t global;        // 1 = declaração .globl (não define o rótulo)
+    uint32_t instrucao;     // Índice, relativo ao trecho, da instrução que segue o rótulo
+    uint32_t item;          // Índice, relativo ao trecho, do item de dados que segue o rótulo
+    uint32_t secao;         // Secao da linha (SECAO_INDEFINIDA = a do fim do trecho anterior)
+} DefinicaoRotulo;
+
+typedef struct {
+    const char *inicio, *fim;       // Parte do fonte coberta pelo trecho
+    ProgramaIR programa;            // Instruções do trecho (linhas relativas)
+    DefinicaoRotulo *rotulos;
+    size_t quantidade_rotulos, capacidade_rotulos;
+    ListaDiagnosticos diagnosticos; // Erros do trecho (linhas e endereços relativos)
+    SecaoDados dados;               // Itens de dados do trecho (linhas relativas)
+    uint32_t linhas;                // Linhas contidas no trecho
+    uint32_t tamanho;               // Bytes de código ocupados pelo trecho
+    Secao secao_inicial;            // Seção no início do trecho (SECAO_INDEFINIDA: a do fim do anterior)
+    Secao secao_final;              // Seção no fim do trecho (SECAO_INDEFINIDA: nenhuma diretiva de seção)
+    size_t instrucoes_iniciais;     // Instruções e itens de dados antes da primeira diretiva de seção,
+    size_t itens_iniciais;          // verificados na costura quando a seção inicial é indefinida
+} TrechoFonte;
+
+static void trecho_adicionar_rotulo(TrechoFonte *trecho, const DefinicaoRotulo *definicao) {
+    if (trecho->quantidade_rotulos == trecho->capacidade_rotulos) {
+        size_t capacidade = trecho->capacidade_rotulos ? trecho->capacidade_rotulos * 2 : 64;
+        DefinicaoRotulo *novos = realloc(trecho->rotulos, capacidade * sizeof(DefinicaoRotulo));
+        if (novos == NULL) memoria_insuficiente("a tabela de rótulos");
+        trecho->rotulos = novos;
+        trecho->capacidade_rotulos = capacidade;
+    }
+    trecho->rotulos[trecho->quantidade_rotulos++] = *definicao;
+}
+
+// Acrescenta a 'programa' as instruções de uma linha já interpretada, que começa em 'linha',
+// na posição 'posicao_linha' do fonte, e no endereço 'endereco'. Com 'comprimir', as instruções
+// que têm forma de 16 bits já ocupam 2 bytes. Retorna os bytes de código ocupados pela linha.
+static uint32_t adicionar_instrucoes(ProgramaIR *programa, const LinhaInterpretada *interpretada, const char *linha,
+                                     uint32_t posicao_linha, uint32_t numero_linha, uint32_t endereco, int comprimir) {
+    uint32_t tamanho_linha = interpretada->tamanho;
+    if (interpretada->quantidade > 0) tamanho_linha = 0;
+    for (int k = 0; k < interpretada->quantidade; k++) {
+        const Operandos *operandos = &interpretada->operandos[k];
+        InstrucaoIR *ir = programa_ir_adicionar(programa);
+        ir->instrucao = (uint8_t)(interpretada->descritores[k] - tabela_instrucoes);
+        ir->tamanho = (comprimir && comprimivel(interpretada->descritores[k], operandos)) ? 2 : 4;
+        ir->endereco = endereco + tamanho_linha;
+        tamanho_linha += ir->tamanho;
+        ir->rd = (uint8_t)operandos->rd;
+        ir->rs1 = (uint8_t)operandos->rs1;
+        ir->rs2 = (uint8_t)operandos->rs2;
+        ir->imm = operandos->imm;
+        // O símbolo é um token da própria linha; guardamos sua posição no fonte
+        ir->simbolo = operandos->simbolo.texto ? posicao_linha + (uint32_t)(operandos->simbolo.texto - linha) : 0;
+        ir->tamanho_simbolo = operandos->simbolo.texto ? operandos->simbolo.tamanho : 0;
+        ir->linha = posicao_linha;
+        ir->numero_linha = numero_linha;
+    }
+    return tamanho_linha;
+}
+
+// Interpreta as linhas de um trecho, produzindo suas instruções, itens de dados, rótulos e erros.
+// Com 'comprimir', as instruções que têm forma de 16 bits já ocupam 2 bytes.
+static void analisar_trecho(const Fonte *fonte, TrechoFonte *trecho, int comprimir) {
+    uint32_t endereco_atual = 0; // Endereço da instrução atual em bytes (relativo ao trecho)
+    uint32_t numero_linha = 0;
+    Secao secao = trecho->secao_inicial;
+    Lexico lexico;
+    lexico_iniciar(&lexico, trecho->inicio, trecho->fim);
+
+    for (; lexico.posicao < trecho->fim; lexico_proxima_linha(&lexico)) {
+        numero_linha++;
+        const char *inicio_linha = lexico_linha(&lexico);
+        if (inicio_linha == NULL) continue; // Linha vazia ou só com comentário
+
+        uint32_t posicao_linha = (uint32_t)(inicio_linha - fonte->texto);
+        LinhaAtual atual = { &lexico, &trecho->diagnosticos, numero_linha, endereco_atual, inicio_linha };
+        LinhaInterpretada interpretada;
+        uint32_t item = (uint32_t)trecho->dados.quantidade_itens; // Item que começa nesta linha, se houver
+        interpretar_linha(&atual, secao, &trecho->dados, &interpretada);
+
+        if (interpretada.rotulo.texto != NULL) {
+            DefinicaoRotulo definicao = { (uint32_t)(interpretada.rotulo.texto - fonte->texto), interpretada.rotulo.tamanho,
+                                          endereco_atual, numero_linha, posicao_linha, 0, (uint32_t)trecho->programa.quantidade, item, secao };
+            trecho_adicionar_rotulo(trecho, &definicao);
+        }
+        if (interpretada.global.texto != NULL) {
+            DefinicaoRotulo declaracao = { (uint32_t)(interpretada.global.texto - fonte->texto), interpretada.global.tamanho,
+                                           endereco_atual, numero_linha, posicao_linha, 1, 0, 0, secao };
+            trecho_adicionar_rotulo(trecho, &declaracao);
+        }
+        endereco_atual += adicionar_instrucoes(&trecho->programa, &interpretada, inicio_linha, posicao_linha, numero_linha, endereco_atual, comprimir);
+
+        if (secao == SECAO_INDEFINIDA) {
+            trecho->instrucoes_iniciais = trecho->programa.quantidade;
+            trecho->itens_iniciais = trecho->dados.quantidade_itens;
+        }
+        if (interpretada.secao != SECAO_INDEFINIDA) secao = interpretada.secao;
+    }
+    trecho->linhas = numero_linha;
+    trecho->tamanho = endereco_atual;
+    trecho->secao_final = secao;
+}
+
+typedef struct {
+    const Fonte *fonte;
+    TrechoFonte *trechos;
+    size_t quantidade_trechos;
+    int comprimir;
+} ContextoAnalise;
+
+static void tarefa_analisar_trecho(void *contexto, size_t indice) {
+    ContextoAnalise *analise = contexto;
+    analisar_trecho(analise->fonte, &analise->trechos[indice], analise->comprimir);
+}
+
+// Libera os trechos, inclusive o que ainda não foi costurado (usada quando falta memória)
+static void liberar_trechos(void *contexto) {
+    ContextoAnalise *analise = contexto;
+    for (size_t t = 0; t < analise->quantidade_trechos; t++) {
+        TrechoFonte *trecho = &analise->trechos[t];
+        programa_ir_liberar(&trecho->programa);
+        free(trecho->rotulos);
+        diagnosticos_liberar(&trecho->diagnosticos);
+        dados_liberar(&trecho->dados);
+    }
+    free(analise->trechos);
+}
+
+// Divide o fonte em até 'maximo' trechos de tamanhos parecidos, sempre terminando em '\n'.
+// Retorna o número de trechos criados.
+static size_t dividir_fonte(const Fonte *fonte, TrechoFonte *trechos, size_t maximo) {
+    size_t quantidade = fonte->tamanho / TAMANHO_MINIMO_TRECHO;
+    if (quantidade > maximo) quantidade = maximo;
+    if (quantidade == 0) quantidade = 1;
+
+    const char *inicio = fonte->texto;
+    const char *fim_fonte = fonte->texto + fonte->tamanho;
+    size_t criados = 0;
+    for (size_t i = 0; i < quantidade && inicio < fim_fonte; i++) {
+        const char *fim = (i + 1 == quantidade) ? fim_fonte : fonte->texto + (fonte->tamanho / quantidade) * (i + 1);
+        if (fim < inicio) fim = inicio;
+        if (fim < fim_fonte) {
+            const char *nova_linha = memchr(fim, '\n', fim_fonte - fim);
+            fim = nova_linha ? nova_linha + 1 : fim_fonte;
+        }
+        memset(&trechos[criados], 0, sizeof(TrechoFonte));
+        trechos[criados].inicio = inicio;
+        trechos[criados].fim = fim;
+        criados++;
+        inicio = fim;
+    }
+    return criados;
+}
+
+// Define a base da seção de dados, que sem --base-dados depende do tamanho do código, e o
+// endereço de cada rótulo da seção
+static void posicionar_rotulos_dados(TabelaRotulos *rotulos, ProgramaIR *programa) {
+    dados_definir_base(&programa->dados, programa->tamanho);
+    for (uint32_t r = 0; r < rotulos->quantidade; r++) {
+        Rotulo *rotulo = &rotulos->rotulos[r];
+        if (rotulo->dados) rotulo->endereco = endereco_rotulo_dados(&programa->dados, rotulo->instrucao);
+    }
+}
+
+// Verifica a posição final da seção de dados (depois do relaxamento, que define o tamanho do
+// código): a seção precisa caber no espaço de endereçamento, uma base dada por --base-dados
+// precisa respeitar os .align e, se código e dados vão para a mesma imagem, o código não pode
+// alcançar essa base. Retorna o número de erros registrados.
+static int verificar_secao_dados(const Fonte *fonte, const ProgramaIR *programa, ListaDiagnosticos *diagnosticos) {
+    const SecaoDados *dados = &programa->dados;
+    size_t erros_anteriores = diagnosticos->quantidade;
+    if (dados->base_fixa && !dados->separada && programa->tamanho > dados->base) {
+        for (size_t i = 0; i < programa->quantidade; i++) {
+            const InstrucaoIR *ir = &programa->instrucoes[i];
+            if (ir->endereco + ir->tamanho <= dados->base) continue;
+            diagnosticos_adicionar(diagnosticos, ir->numero_linha, ir->endereco, fonte->texto + ir->linha,
+                                   "O código ultrapassa o início da seção .data (0x%08X)", dados->base);
+            break;
+        }
+    }
+    for (size_t i = 0; i < dados->quantidade_itens; i++) {
+        const ItemDados *item = &dados->itens[i];
+        uint64_t endereco = (uint64_t)dados->base + item->deslocamento;
+        if (endereco + item->tamanho > TAMANHO_MAXIMO_DADOS) {
+            diagnosticos_adicionar(diagnosticos, item->numero_linha, (uint32_t)endereco, item->texto_linha,
+                                   "O programa excede o espaço de endereçamento");
+            break;
+        }
+        if (dados->base_fixa && item->tipo == DADO_ALINHAMENTO && dados->base % item->origem != 0) {
+            diagnosticos_adicionar(diagnosticos, item->numero_linha, (uint32_t)endereco, item->texto_linha,
+                                   "A base da seção .data (0x%08X) não é múltipla do alinhamento de %u bytes", dados->base, item->origem);
+        }
+    }
+    return (int)(diagnosticos->quantidade - erros_anteriores);
+}
+
+// --- Relaxamento de Branches ---
+// Um branch alcança apenas -4096 a +4094 bytes. Quando o rótulo fica mais longe, o branch é
+// trocado pelo branch de condição inversa, que pula a instrução seguinte, e um jal (+/- 1 MiB):
+//   beq a0, a1, longe   =>   bne a0, a1, 8
+//                            jal x0, longe
+// Com instruções comprimidas, os branches e jal candidatos começam com 2 bytes e crescem
+// para 4 se o destino ficar fora do alcance da forma curta (c.beqz/c.bnez: +/- 256 bytes;
+// c.j/c.jal: +/- 2 KiB) ou for um rótulo externo.
+// Cada instrução que cresce afasta outros destinos, então os endereços são recalculados e as
+// referências verificadas de novo até nenhuma precisar crescer. Como os tamanhos nunca
+// diminuem, o processo termina. Rótulos indefinidos (objeto relocável) não são relaxados.
+static void relaxar_branches(const Fonte *fonte, TabelaRotulos *rotulos, ProgramaIR *programa, int comprimir) {
+    posicionar_rotulos_dados(rotulos, programa);
+    if (!comprimir && programa->tamanho <= 4094) return; // Todo destino está ao alcance de qualquer branch
+
+    for (int mudou = 1; mudou; ) {
+        mudou = 0;
+        for (size_t i = 0; i < programa->quantidade; i++) {
+            InstrucaoIR *ir = &programa->instrucoes[i];
+            const DescritorInstrucao *descritor = &tabela_instrucoes[ir->instrucao];
+            if (ir->tamanho_simbolo == 0 || ir->tamanho == 8) continue;
+            if (ir->tamanho == 4 && descritor->formato != FORMATO_B) continue;
+            int destino = tabela_rotulos_buscar(rotulos, fonte->texto + ir->simbolo, ir->tamanho_simbolo);
+            int deslocamento = destino - (int)ir->endereco;
+            if (ir->tamanho == 2) { // Comprimida: o destino precisa estar definido e ao alcance da forma curta
+                Operandos operandos = { ir->rd, ir->rs1, ir->rs2, deslocamento, { NULL, 0 } };
+                uint16_t comprimida;
+                if (destino == -1 || !comprimir_instrucao(descritor, &operandos, &comprimida)) {
+                    ir->tamanho = 4;
+                    mudou = 1;
+                }
+            } else if (destino != -1 && (deslocamento < -4096 || deslocamento > 4094)) {
+                ir->tamanho = 8;
+                mudou = 1;
+            }
+        }
+        if (!mudou) break;
+
+        uint32_t endereco = 0;
+        for (size_t i = 0; i < programa->quantidade; i++) {
+            programa->instrucoes[i].endereco = endereco;
+            endereco += programa->instrucoes[i].tamanho;
+        }
+        programa->tamanho = endereco;
+        for (uint32_t r = 0; r < rotulos->quantidade; r++) {
+            Rotulo *rotulo = &rotulos->rotulos[r];
+            if (rotulo->endereco == -1 || rotulo->dados) continue;
+            rotulo->endereco = rotulo->instrucao < programa->quantidade ? (int)programa->instrucoes[rotulo->instrucao].endereco : (int)endereco;
+        }
+        posicionar_rotulos_dados(rotulos, programa); // Sem --base-dados, os dados seguem o código
+    }
+}
+
+// Percorre o fonte em memória, armazena os rótulos com seus endereços e converte cada
+// instrução em um registro da representação intermediária, usando até 'threads' threads.
+// Endereços são contados em bytes; sem erros, os tamanhos dos branches e jal (comprimidos
+// com 'comprimir', ou relaxados) são ajustados aos destinos ao final.
+// Os erros são acrescentados a 'diagnosticos', em ordem de linha; retorna quantos foram encontrados.
+static int primeira_passagem(const Fonte *fonte, TabelaRotulos *rotulos, ProgramaIR *programa, ListaDiagnosticos *diagnosticos,
+                      int comprimir, int threads) {
+    size_t maximo_trechos = threads > 1 ? (size_t)threads * TRECHOS_POR_THREAD : 1;
+    TrechoFonte *trechos = malloc(maximo_trechos * sizeof(TrechoFonte));
+    if (trechos == NULL) memoria_insuficiente("dividir o fonte");
+    MarcaTempo inicio = estatisticas_marcar();
+    size_t quantidade_trechos = dividir_fonte(fonte, trechos, maximo_trechos);
+    trechos[0].secao_inicial = SECAO_TEXTO;
+    for (size_t t = 0; t < quantidade_trechos; t++) trechos[t].dados.sem_arquivos = programa->dados.sem_arquivos;
+    ContextoAnalise analise = { fonte, trechos, quantidade_trechos, comprimir };
+    temporarios_registrar(liberar_trechos, &analise);
+    executar_em_paralelo(quantidade_trechos, threads, tarefa_analisar_trecho, &analise);
+    estatisticas_fase("primeira_passagem.analise", inicio);
+    inicio = estatisticas_marcar();
+
+    // Costura os trechos em ordem
+    size_t total_instrucoes = 0;
+    for (size_t t = 0; t < quantidade_trechos; t++) total_instrucoes += trechos[t].programa.quantidade;
+    if (total_instrucoes > programa->capacidade) {
+        InstrucaoIR *instrucoes = realloc(programa->instrucoes, total_instrucoes * sizeof(InstrucaoIR));
+        if (instrucoes == NULL) memoria_insuficiente("a representação intermediária");
+        programa->instrucoes = instrucoes;
+        programa->capacidade = total_instrucoes;
+    }
+
+    size_t erros_anteriores = diagnosticos->quantidade;
+    uint32_t base_linha = 0, base_endereco = 0;
+    Secao secao = SECAO_TEXTO; // O fonte começa na seção .text
+    for (size_t t = 0; t < quantidade_trechos; t++) {
+        TrechoFonte *trecho = &trechos[t];
+        // As linhas antes da primeira diretiva de seção do trecho foram aceitas nas duas seções;
+        // agora que a seção é conhecida, as que não pertencem a ela viram erro
+        if (trecho->secao_inicial == SECAO_INDEFINIDA) {
+            if (secao == SECAO_DADOS) {
+                for (size_t i = 0; i < trecho->instrucoes_iniciais; i++) {
+                    const InstrucaoIR *ir = &trecho->programa.instrucoes[i];
+                    if (i > 0 && ir->numero_linha == ir[-1].numero_linha) continue; // li/la de duas instruções
+                    diagnosticos_adicionar(&trecho->diagnosticos, ir->numero_linha, ir->endereco, fonte->texto + ir->linha,
+                                           "Instrução fora da seção .text");
+                }
+            } else {
+                for (size_t i = 0; i < trecho->itens_iniciais; i++) {
+                    const ItemDados *item = &trecho->dados.itens[i];
+                    diagnosticos_adicionar(&trecho->diagnosticos, item->numero_linha, item->deslocamento, item->texto_linha,
+                                           "Diretiva de dados fora da seção .data");
+                }
+            }
+        }
+
+        uint32_t base_item = (uint32_t)programa->dados.quantidade_itens;
+        for (size_t r = 0; r < trecho->quantidade_rotulos; r++) {
+            const DefinicaoRotulo *definicao = &trecho->rotulos[r];
+            const char *nome = fonte->texto + definicao->nome;
+            if (definicao->global) {
+                uint32_t posicao = tabela_rotulos_obter(rotulos, nome, definicao->tamanho); // Pode realocar o vetor
+                rotulos->rotulos[posicao].global = 1;
+                continue;
+            }
+            // Um rótulo já criado por .globl, mas ainda indefinido, recebe aqui o endereço
+            uint32_t posicao = tabela_rotulos_obter(rotulos, nome, definicao->tamanho); // Pode realocar o vetor
+            Rotulo *rotulo = &rotulos->rotulos[posicao];
+            if (rotulo->endereco != -1) {
+                diagnosticos_adicionar(diagnosticos, base_linha + definicao->numero_linha, base_endereco + definicao->endereco,
+                                       fonte->texto + definicao->linha, "Rótulo '%.*s' definido mais de uma vez", (int)definicao->tamanho, nome);
+                continue;
+            }
+            if ((definicao->secao == SECAO_INDEFINIDA ? secao : (Secao)definicao->secao) == SECAO_DADOS) {
+                rotulo->endereco = 0; // Definido; o endereço sai de posicionar_rotulos_dados
+                rotulo->dados = 1;
+                rotulo->instrucao = base_item + definicao->item;
+                continue;
+            }
+            rotulo->endereco = (int)(base_endereco + definicao->endereco);
+            rotulo->instrucao = (uint32_t)programa->quantidade + definicao->instrucao;
+        }
+
+        InstrucaoIR *destino = programa->instrucoes + programa->quantidade;
+        if (trecho->programa.quantidade > 0) memcpy(destino, trecho->programa.instrucoes, trecho->programa.quantidade * sizeof(InstrucaoIR));
+        for (size_t i = 0; i < trecho->programa.quantidade; i++) {
+            destino[i].numero_linha += base_linha;
+            destino[i].endereco += base_endereco;
+        }
+        programa->quantidade += trecho->programa.quantidade;
+        dados_anexar(&programa->dados, &trecho->dados, base_linha);
+
+        diagnosticos_anexar(diagnosticos, &trecho->diagnosticos, base_linha, base_endereco);
+        base_linha += trecho->linhas;
+        base_endereco += trecho->tamanho;
+        if (trecho->secao_final != SECAO_INDEFINIDA) secao = trecho->secao_final;
+        programa_ir_liberar(&trecho->programa);
+        free(trecho->rotulos);
+        trecho->rotulos = NULL;
+    }
+    free(trechos);
+    temporarios_registrar(NULL, NULL);
+    programa->tamanho = base_endereco;
+    ESTAT_CONTAR(linhas, base_linha);
+
+    size_t excedente = dados_posicionar(&programa->dados, 0);
+    if (excedente < programa->dados.quantidade_itens) {
+        const ItemDados *item = &programa->dados.itens[excedente];
+        diagnosticos_adicionar(diagnosticos, item->numero_linha, item->deslocamento, item->texto_linha, "A seção .data excede 2 GiB");
+    }
+
+    diagnosticos_ordenar(diagnosticos);
+    estatisticas_fase("primeira_passagem.rotulos", inicio);
+    if (diagnosticos->quantidade != erros_anteriores) return (int)(diagnosticos->quantidade - erros_anteriores);
+
+    inicio = estatisticas_marcar();
+    relaxar_branches(fonte, rotulos, programa, comprimir);
+    estatisticas_fase("primeira_passagem.relaxamento", inicio);
+    int erros = verificar_secao_dados(fonte, programa, diagnosticos);
+    if (erros > 0) diagnosticos_ordenar(diagnosticos);
+    return erros;
+}
+
+// Grava uma palavra de 32 bits em little-endian (byte menos significativo primeiro)
+static void gravar_palavra_le(uint8_t *destino, uint32_t palavra) {
+    destino[0] = (uint8_t)(palavra >> 0);  // Byte 0: bits 7-0 da instrução
+    destino[1] = (uint8_t)(palavra >> 8);  // Byte 1: bits 15-8 da instrução
+    destino[2] = (uint8_t)(palavra >> 16); // Byte 2: bits 23-16 da instrução
+    destino[3] = (uint8_t)(palavra >> 24); // Byte 3: bits 31-24 da instrução
+}
+
+// Lê uma palavra de 32 bits em little-endian
+static uint32_t ler_palavra_le(const uint8_t *origem) {
+    return (uint32_t)origem[0] | ((uint32_t)origem[1] << 8) | ((uint32_t)origem[2] << 16) | ((uint32_t)origem[3] << 24);
+}
+
+// Grava uma instrução comprimida de 16 bits em little-endian
+static void gravar_meia_palavra_le(uint8_t *destino, uint16_t meia_palavra) {
+    destino[0] = (uint8_t)(meia_palavra >> 0);
+    destino[1] = (uint8_t)(meia_palavra >> 8);
+}
+
+// --- Relocações ---
+// Ao gerar um objeto relocável (-c), as referências que só podem ser resolvidas na ligação
+// viram relocações: as feitas a rótulos que não estão definidos no arquivo (externos) e todo
+// %hi/%lo, que depende do endereço final do objeto. Branches e jal para rótulos do próprio
+// arquivo são relativos ao PC e já saem resolvidos. O tipo da relocação é o formato da instrução.
+typedef enum {
+    RELOCACAO_BRANCH = 1, // Deslocamento de 13 bits do formato B
+    RELOCACAO_JAL,        // Deslocamento de 21 bits do formato J
+    RELOCACAO_HI20,       // %hi(rotulo) no formato U
+    RELOCACAO_LO12_I,     // %lo(rotulo) no formato I
+    RELOCACAO_LO12_S,     // %lo(rotulo) no formato S
+    NUMERO_TIPOS_RELOCACAO
+} TipoRelocacao;
+
+typedef struct {
+    uint32_t endereco;  // Endereço da instrução a corrigir, relativo ao início do objeto
+    uint32_t tipo;      // TipoRelocacao
+    const char *nome;   // Nome do rótulo referenciado (não terminado em '\0')
+    uint32_t tamanho;   // Comprimento do nome
+} Relocacao;
+
+typedef struct {
+    Relocacao *itens;
+    size_t quantidade;
+    size_t capacidade;
+} ListaRelocacoes;
+
+static TipoRelocacao tipo_relocacao(const DescritorInstrucao *d) {
+    switch (d->formato) {
+        case FORMATO_B: return RELOCACAO_BRANCH;
+        case FORMATO_J: return RELOCACAO_JAL;
+        case FORMATO_U: return RELOCACAO_HI20;
+        case FORMATO_S: return RELOCACAO_LO12_S;
+        default:        return RELOCACAO_LO12_I;
+    }
+}
+
+static void relocacoes_adicionar(ListaRelocacoes *lista, uint32_t endereco, TipoRelocacao tipo, const char *nome, uint32_t tamanho) {
+    if (lista->quantidade == lista->capacidade) {
+        size_t capacidade = lista->capacidade ? lista->capacidade * 2 : 64;
+        Relocacao *novas = realloc(lista->itens, capacidade * sizeof(Relocacao));
+        if (novas == NULL) memoria_insuficiente("as relocações");
+        lista->itens = novas;
+        lista->capacidade = capacidade;
+    }
+    Relocacao *relocacao = &lista->itens[lista->quantidade++];
+    relocacao->endereco = endereco;
+    relocacao->tipo = tipo;
+    relocacao->nome = nome;
+    relocacao->tamanho = tamanho;
+}
+
+// Move as relocações de 'origem' para o fim de 'destino'
+static void relocacoes_anexar(ListaRelocacoes *destino, ListaRelocacoes *origem) {
+    for (size_t i = 0; i < origem->quantidade; i++) {
+        const Relocacao *r = &origem->itens[i];
+        relocacoes_adicionar(destino, r->endereco, (TipoRelocacao)r->tipo, r->nome, r->tamanho);
+    }
+    free(origem->itens);
+    memset(origem, 0, sizeof(*origem));
+}
+
+static void relocacoes_liberar(ListaRelocacoes *lista) {
+    free(lista->itens);
+    memset(lista, 0, sizeof(*lista));
+}
+
+// --- Listagem e Mapa de Símbolos ---
+// A segunda passagem também pode gerar três textos para depuração, a partir da IR e do código
+// que acabou de codificar, sem reler o fonte nem a saída: a listagem (endereço, código e
+// número de cada linha do fonte), o mapa de símbolos (os rótulos em ordem de endereço) e um
+// filtro de tradução do GTKWave, que troca cada valor do PC pelo rótulo mais próximo e a
+// instrução, para anotar as formas de onda do processador. A listagem e o filtro são gerados
+// por bloco de instruções, em paralelo como a codificação, e concatenados em ordem.
+#define INSTRUCOES_POR_BLOCO_LISTAGEM 16384
+
+typedef struct {
+    char *dados;
+    size_t tamanho, capacidade;
+} Texto;
+
+typedef struct {
+    int gerar_listagem, gerar_mapa, gerar_filtro; // Textos pedidos
+    Texto listagem;  // Uma linha por linha do fonte, mais uma por instrução adicional da linha
+    Texto mapa;      // "endereço tipo nome", como o nm: T/t na .text, D/d na .data, U se indefinido
+    Texto filtro;    // "endereço rótulo+deslocamento: instrução", para o valor do PC em hexadecimal
+} Listagem;
+
+// Acrescenta um texto formatado, crescendo o buffer por duplicação
+static void texto_formatar(Texto *texto, const char *formato, ...) {
+    for (;;) {
+        size_t livre = texto->capacidade - texto->tamanho;
+        va_list argumentos;
+        va_start(argumentos, formato);
+        int tamanho = vsnprintf(texto->dados ? texto->dados + texto->tamanho : NULL, livre, formato, argumentos);
+        va_end(argumentos);
+        if (tamanho < 0) return;
+        if ((size_t)tamanho < livre) {
+            texto->tamanho += (size_t)tamanho;
+            return;
+        }
+        size_t capacidade = texto->capacidade ? texto->capacidade * 2 : 64 * 1024;
+        while (capacidade - texto->tamanho <= (size_t)tamanho) capacidade *= 2;
+        char *maior = realloc(texto->dados, capacidade);
+        if (maior == NULL) memoria_insuficiente("a listagem");
+        texto->dados = maior;
+        texto->capacidade = capacidade;
+    }
+}
+
+// Move o conteúdo de 'origem' para o final de 'destino'
+static void texto_anexar(Texto *destino, Texto *origem) {
+    if (destino->tamanho == 0) {
+        free(destino->dados);
+        *destino = *origem;
+    } else if (origem->tamanho > 0) {
+        if (destino->capacidade - destino->tamanho < origem->tamanho + 1) {
+            char *maior = realloc(destino->dados, destino->tamanho + origem->tamanho + 1);
+            if (maior == NULL) memoria_insuficiente("a listagem");
+            destino->dados = maior;
+            destino->capacidade = destino->tamanho + origem->tamanho + 1;
+        }
+        memcpy(destino->dados + destino->tamanho, origem->dados, origem->tamanho);
+        destino->tamanho += origem->tamanho;
+        free(origem->dados);
+    } else {
+        free(origem->dados);
+    }
+    memset(origem, 0, sizeof(*origem));
+}
+
+// Grava o texto em um arquivo. Retorna 0 em caso de sucesso ou -1 em caso de erro.
+SOMENTE_LINHA_COMANDO int texto_gravar(const char *nome_arquivo, const Texto *texto) {
+    FILE *arquivo = fopen(nome_arquivo, "wb");
+    if (arquivo == NULL) {
+        perror("Erro ao abrir o arquivo da listagem");
+        return -1;
+    }
+    int erro = texto->tamanho > 0 && fwrite(texto->dados, 1, texto->tamanho, arquivo) != texto->tamanho;
+    if (fclose(arquivo) != 0 || erro) {
+        fprintf(stderr, "Erro ao escrever o arquivo '%s'.\n", nome_arquivo);
+        return -1;
+    }
+    return 0;
+}
+
+SOMENTE_LINHA_COMANDO void listagem_liberar(Listagem *listagem) {
+    free(listagem->listagem.dados);
+    free(listagem->mapa.dados);
+    free(listagem->filtro.dados);
+    memset(&listagem->listagem, 0, sizeof(Texto));
+    memset(&listagem->mapa, 0, sizeof(Texto));
+    memset(&listagem->filtro, 0, sizeof(Texto));
+}
+
+// Rótulos em ordem de endereço; os definidos no mesmo endereço ficam na ordem de definição, e
+// os indefinidos (só referenciados) no final
+static int comparar_rotulos(const void *a, const void *b) {
+    const Rotulo *x = *(const Rotulo *const *)a, *y = *(const Rotulo *const *)b;
+    uint32_t ex = (uint32_t)x->endereco, ey = (uint32_t)y->endereco; // -1 vira o maior endereço
+    if (ex != ey) return ex < ey ? -1 : 1;
+    return x < y ? -1 : (x > y);
+}
+
+typedef struct {
+    const Fonte *fonte;
+    const ProgramaIR *programa;
+    const uint8_t *imagem;
+    const Listagem *pedido;
+    const Rotulo **rotulos_codigo;   // Rótulos definidos na .text, em ordem de endereço
+    size_t quantidade_rotulos_codigo;
+    Texto *listagens, *filtros;      // Um texto por bloco
+} ContextoListagem;
+
+// Lista as linhas do fonte cuja primeira instrução está em [inicio, fim), além das linhas sem
+// instruções que as seguem. Uma linha com várias instruções (li, la, branch relaxado) é
+// listada inteira pelo bloco em que começa, mesmo que termine no bloco seguinte.
+static void listar_intervalo(const ContextoListagem *contexto, size_t inicio, size_t fim, Texto *listagem, Texto *filtro) {
+    const ProgramaIR *programa = contexto->programa;
+    const InstrucaoIR *instrucoes = programa->instrucoes;
+    const SecaoDados *dados = &programa->dados;
+    const char *texto = contexto->fonte->texto, *fim_fonte = texto + contexto->fonte->tamanho;
+    const char *cursor = texto, *fim_trecho = fim_fonte;
+    uint32_t numero_linha = 1;
+    size_t i = inicio;
+    if (inicio > 0) { // A linha da instrução anterior é do bloco anterior
+        const char *fim_linha = memchr(texto + instrucoes[inicio - 1].linha, '\n', fim_fonte - (texto + instrucoes[inicio - 1].linha));
+        cursor = fim_linha ? fim_linha + 1 : fim_fonte;
+        numero_linha = instrucoes[inicio - 1].numero_linha + 1;
+        while (i < programa->quantidade && instrucoes[i].linha == instrucoes[inicio - 1].linha) i++;
+    }
+    if (fim < programa->quantidade) {
+        const char *fim_linha = memchr(texto + instrucoes[fim - 1].linha, '\n', fim_fonte - (texto + instrucoes[fim - 1].linha));
+        fim_trecho = fim_linha ? fim_linha + 1 : fim_fonte;
+    }
+
+    size_t item = 0; // Primeiro item de dados a partir de 'cursor'
+    for (size_t de = 0, ate = dados->quantidade_itens; de < ate; ) {
+        size_t meio = de + (ate - de) / 2;
+        if (dados->itens[meio].texto_linha < cursor) de = item = meio + 1;
+        else ate = meio;
+    }
+    size_t rotulo = 0; // Primeiro rótulo de código depois do endereço atual
+    if (contexto->pedido->gerar_filtro && i < programa->quantidade) {
+        for (size_t de = 0, ate = contexto->quantidade_rotulos_codigo; de < ate; ) {
+            size_t meio = de + (ate - de) / 2;
+            if ((uint32_t)contexto->rotulos_codigo[meio]->endereco <= instrucoes[i].endereco) de = rotulo = meio + 1;
+            else ate = meio;
+        }
+    }
+
+    for (; cursor < fim_trecho; numero_linha++) {
+        const char *fim_linha = memchr(cursor, '\n', fim_trecho - cursor);
+        if (fim_linha == NULL) fim_linha = fim_trecho;
+        int largura = (int)(fim_linha - cursor);
+        if (largura > 0 && cursor[largura - 1] == '\r') largura--;
+        uint32_t proxima_linha = (uint32_t)(fim_linha - texto) + 1;
+
+        // Para o filtro: a instrução sem o rótulo da linha, os comentários e os espaços
+        const char *instrucao = cursor, *fim_instrucao = cursor + strcspn(cursor, "#;\n");
+        if (fim_instrucao > fim_linha) fim_instrucao = fim_linha;
+        const char *dois_pontos = memchr(instrucao, ':', fim_instrucao - instrucao);
+        if (dois_pontos != NULL) instrucao = dois_pontos + 1;
+        while (instrucao < fim_instrucao && (*instrucao == ' ' || *instrucao == '\t')) instrucao++;
+        while (fim_instrucao > instrucao && (fim_instrucao[-1] == ' ' || fim_instrucao[-1] == '\t' || fim_instrucao[-1] == '\r')) fim_instrucao--;
+
+        int primeira = 1;
+        for (; i < programa->quantidade && instrucoes[i].linha < proxima_linha; i++) {
+            const InstrucaoIR *ir = &instrucoes[i];
+            for (uint32_t parte = 0; parte < ir->tamanho; parte += 4) { // Um branch relaxado ocupa duas palavras
+                uint32_t endereco = ir->endereco + parte;
+                char codigo[16];
+                if (ir->tamanho == 2) snprintf(codigo, sizeof(codigo), "%04X", (unsigned)(contexto->imagem[endereco] | contexto->imagem[endereco + 1] << 8));
+                else snprintf(codigo, sizeof(codigo), "%08X", ler_palavra_le(contexto->imagem + endereco));
+                if (contexto->pedido->gerar_listagem) {
+                    if (primeira) texto_formatar(listagem, "%08X  %-8s  %6u  %.*s\n", endereco, codigo, numero_linha, largura, cursor);
+                    else texto_formatar(listagem, "%08X  %s\n", endereco, codigo);
+                }
+                if (contexto->pedido->gerar_filtro) {
+                    while (rotulo < contexto->quantidade_rotulos_codigo && (uint32_t)contexto->rotulos_codigo[rotulo]->endereco <= endereco) rotulo++;
+                    int largura_instrucao = (int)(fim_instrucao - instrucao);
+                    if (rotulo == 0) {
+                        texto_formatar(filtro, "%08X %.*s\n", endereco, largura_instrucao, instrucao);
+                    } else {
+                        const Rotulo *anterior = contexto->rotulos_codigo[rotulo - 1];
+                        uint32_t deslocamento = endereco - (uint32_t)anterior->endereco;
+                        if (deslocamento == 0) texto_formatar(filtro, "%08X %s: %.*s\n", endereco, anterior->nome, largura_instrucao, instrucao);
+                        else texto_formatar(filtro, "%08X %s+0x%X: %.*s\n", endereco, anterior->nome, deslocamento, largura_instrucao, instrucao);
+                    }
+                }
+                primeira = 0;
+            }
+        }
+        if (primeira && contexto->pedido->gerar_listagem) { // Linha sem código: só os dados têm endereço
+            while (item < dados->quantidade_itens && dados->itens[item].texto_linha < cursor) item++;
+            if (item < dados->quantidade_itens && dados->itens[item].texto_linha < fim_linha) {
+                texto_formatar(listagem, "%08X  %8s  %6u  %.*s\n", dados->base + dados->itens[item].deslocamento, "", numero_linha, largura, cursor);
+            } else {
+                texto_formatar(listagem, "%8s  %8s  %6u  %.*s\n", "", "", numero_linha, largura, cursor);
+            }
+        }
+        cursor = fim_linha + 1;
+    }
+}
+
+static void tarefa_listar_bloco(void *contexto, size_t indice) {
+    ContextoListagem *listagem = contexto;
+    size_t inicio = indice * INSTRUCOES_POR_BLOCO_LISTAGEM;
+    size_t fim = inicio + INSTRUCOES_POR_BLOCO_LISTAGEM;
+    if (fim > listagem->programa->quantidade) fim = listagem->programa->quantidade;
+    listar_intervalo(listagem, inicio, fim, &listagem->listagens[indice], &listagem->filtros[indice]);
+}
+
+// Gera os textos pedidos em 'listagem' para o programa já codificado em 'imagem'
+static void gerar_listagem(const Fonte *fonte, const TabelaRotulos *rotulos, const ProgramaIR *programa, const uint8_t *imagem,
+                           Listagem *listagem, int threads) {
+    listagem->listagem.tamanho = listagem->mapa.tamanho = listagem->filtro.tamanho = 0;
+    const Rotulo **ordenados = malloc((rotulos->quantidade ? rotulos->quantidade : 1) * sizeof(Rotulo *));
+    if (ordenados == NULL) memoria_insuficiente("a listagem");
+    for (uint32_t r = 0; r < rotulos->quantidade; r++) ordenados[r] = &rotulos->rotulos[r];
+    qsort(ordenados, rotulos->quantidade, sizeof(Rotulo *), comparar_rotulos);
+
+    if (listagem->gerar_mapa) {
+        for (uint32_t r = 0; r < rotulos->quantidade; r++) {
+            const Rotulo *rotulo = ordenados[r];
+            char tipo = rotulo->dados ? 'D' : 'T';
+            if (rotulo->endereco == -1) texto_formatar(&listagem->mapa, "%8s U %s\n", "", rotulo->nome);
+            else texto_formatar(&listagem->mapa, "%08X %c %s\n", (uint32_t)rotulo->endereco, rotulo->global ? tipo : tipo + ('a' - 'A'), rotulo->nome);
+        }
+    }
+
+    // O filtro só usa os rótulos da .text; 'ordenados' é reaproveitado para eles
+    size_t quantidade_codigo = 0;
+    for (uint32_t r = 0; r < rotulos->quantidade; r++) {
+        if (!ordenados[r]->dados && ordenados[r]->endereco != -1) ordenados[quantidade_codigo++] = ordenados[r];
+    }
+    if (listagem->gerar_listagem || listagem->gerar_filtro) {
+        size_t blocos = programa->quantidade > INSTRUCOES_POR_BLOCO_LISTAGEM ? (programa->quantidade + INSTRUCOES_POR_BLOCO_LISTAGEM - 1) / INSTRUCOES_POR_BLOCO_LISTAGEM : 1;
+        Texto *textos = calloc(2 * blocos, sizeof(Texto));
+        if (textos == NULL) memoria_insuficiente("a listagem");
+        ContextoListagem contexto = { fonte, programa, imagem, listagem, ordenados, quantidade_codigo, textos, textos + blocos };
+        if (blocos == 1) listar_intervalo(&contexto, 0, programa->quantidade, &textos[0], &textos[1]);
+        else executar_em_paralelo(blocos, threads, tarefa_listar_bloco, &contexto);
+        for (size_t b = 0; b < blocos; b++) {
+            texto_anexar(&listagem->listagem, &contexto.listagens[b]);
+            texto_anexar(&listagem->filtro, &contexto.filtros[b]);
+        }
+        free(textos);
+    }
+    free(ordenados);
+}
+
+// --- Função da Segunda Passagem (Geração do Código Binário) ---
+// Percorre a representação intermediária, resolve os rótulos referenciados e codifica
+// cada instrução em 'imagem', no seu endereço (little-endian). Cada instrução depende
+// apenas dos seus operandos e da tabela de rótulos (somente leitura aqui), então blocos de
+// instruções são codificados em paralelo; os erros de cada bloco são reunidos em ordem.
+#define INSTRUCOES_POR_BLOCO 16384
+
+// Codifica as instruções [inicio, fim) do programa. Com 'relocacoes', as referências que
+// dependem da ligação são registradas lá e seus campos ficam zerados.
+static void codificar_intervalo(const Fonte *fonte, const TabelaRotulos *rotulos, const ProgramaIR *programa, size_t inicio, size_t fim,
+                                uint8_t *imagem, ListaDiagnosticos *diagnosticos, ListaRelocacoes *relocacoes) {
+    for (size_t i = inicio; i < fim; i++) {
+        const InstrucaoIR *ir = &programa->instrucoes[i];
+        const DescritorInstrucao *descritor = &tabela_instrucoes[ir->instrucao];
+        int endereco_atual = (int)ir->endereco; // Endereço da instrução atual em bytes
+        Operandos operandos = { ir->rd, ir->rs1, ir->rs2, ir->imm, { NULL, 0 } };
+
+        if (ir->tamanho_simbolo != 0) {
+            const char *rotulo = fonte->texto + ir->simbolo;
+            int tamanho_rotulo = (int)ir->tamanho_simbolo;
+            LinhaAtual atual = { NULL, diagnosticos, ir->numero_linha, (uint32_t)endereco_atual, fonte->texto + ir->linha };
+            int endereco_destino = tabela_rotulos_buscar(rotulos, rotulo, ir->tamanho_simbolo);
+            int relativo_pc = (descritor->formato == FORMATO_B || descritor->formato == FORMATO_J);
+            if (relocacoes != NULL && (endereco_destino == -1 || !relativo_pc)) {
+                relocacoes_adicionar(relocacoes, (uint32_t)endereco_atual, tipo_relocacao(descritor), rotulo, ir->tamanho_simbolo);
+            } else if (endereco_destino == -1) {
+                erro_linha(&atual, "Rótulo '%.*s' não encontrado", tamanho_rotulo, rotulo);
+                continue;
+            } else if (ir->tamanho == 8) {
+                uint32_t palavras[2];
+                if (codificar_branch_relaxado(descritor, &operandos, endereco_destino, &atual, rotulo, tamanho_rotulo, palavras) == 0) {
+                    gravar_palavra_le(imagem + ir->endereco, palavras[0]);
+                    gravar_palavra_le(imagem + ir->endereco + 4, palavras[1]);
+                }
+                continue;
+            } else if (resolver_referencia(descritor, endereco_destino, &atual, rotulo, tamanho_rotulo, &operandos.imm) != 0) {
+                continue;
+            }
+        }
+
+        uint16_t comprimida;
+        if (ir->tamanho == 2 && comprimir_instrucao(descritor, &operandos, &comprimida)) {
+            gravar_meia_palavra_le(imagem + ir->endereco, comprimida);
+        } else {
+            gravar_palavra_le(imagem + ir->endereco, codificar_instrucao(descritor, &operandos));
+        }
+    }
+}
+
+typedef struct {
+    const Fonte *fonte;
+    const TabelaRotulos *rotulos;
+    const ProgramaIR *programa;
+    uint8_t *imagem;
+    ListaDiagnosticos *diagnosticos; // Uma lista por bloco
+    ListaRelocacoes *relocacoes;     // Uma lista por bloco (NULL = imagem final, sem relocações)
+    size_t blocos;
+} ContextoCodificacao;
+
+// Libera as listas de cada bloco, inclusive as que ainda não foram anexadas (usada quando falta memória)
+static void liberar_blocos(void *contexto) {
+    ContextoCodificacao *codificacao = contexto;
+    for (size_t b = 0; b < codificacao->blocos; b++) {
+        diagnosticos_liberar(&codificacao->diagnosticos[b]);
+        if (codificacao->relocacoes != NULL) relocacoes_liberar(&codificacao->relocacoes[b]);
+    }
+    free(codificacao->diagnosticos);
+    free(codificacao->relocacoes);
+}
+
+static void tarefa_codificar_bloco(void *contexto, size_t indice) {
+    ContextoCodificacao *codificacao = contexto;
+    size_t inicio = indice * INSTRUCOES_POR_BLOCO;
+    size_t fim = inicio + INSTRUCOES_POR_BLOCO;
+    if (fim > codificacao->programa->quantidade) fim = codificacao->programa->quantidade;
+    codificar_intervalo(codificacao->fonte, codificacao->rotulos, codificacao->programa, inicio, fim, codificacao->imagem,
+                        &codificacao->diagnosticos[indice], codificacao->relocacoes ? &codificacao->relocacoes[indice] : NULL);
+}
+
+// Grava, em little-endian, o endereço de cada rótulo usado como valor de .word. Comum à
+// montagem em duas passagens e à montagem em fluxo. Retorna o número de erros registrados.
+static int resolver_referencias_dados(const TabelaRotulos *rotulos, SecaoDados *dados, ListaDiagnosticos *diagnosticos) {
+    int erros = 0;
+    for (size_t i = 0; i < dados->quantidade_referencias; i++) {
+        const ReferenciaDados *referencia = &dados->referencias[i];
+        const ItemDados *item = &dados->itens[referencia->item];
+        uint32_t endereco = dados->base + item->deslocamento + (referencia->posicao - item->origem);
+        int destino = tabela_rotulos_buscar(rotulos, referencia->simbolo, referencia->tamanho_simbolo);
+        if (destino == -1) {
+            diagnosticos_adicionar(diagnosticos, referencia->numero_linha, endereco, referencia->texto_linha,
+                                   "Rótulo '%.*s' não encontrado", (int)referencia->tamanho_simbolo, referencia->simbolo);
+            erros++;
+            continue;
+        }
+        gravar_palavra_le(dados->bytes + referencia->posicao, (uint32_t)destino);
+    }
+    return erros;
+}
+
+// Com 'relocacoes' (objeto relocável), rótulos não definidos não são erros: viram relocações,
+// acrescentadas em ordem de endereço. Ao final, completa os .word que usam rótulos na seção
+// de dados do programa e, sem erros, gera os textos pedidos em 'listagem' (se não for NULL).
+// Retorna o número de erros encontrados, acrescentados a 'diagnosticos' em ordem de linha.
+static int segunda_passagem(const Fonte *fonte, const TabelaRotulos *rotulos, ProgramaIR *programa, uint8_t *imagem,
+                     ListaDiagnosticos *diagnosticos, ListaRelocacoes *relocacoes, Listagem *listagem, int threads) {
+    MarcaTempo inicio = estatisticas_marcar();
+    if (threads <= 1 || programa->quantidade <= INSTRUCOES_POR_BLOCO) {
+        size_t erros_anteriores = diagnosticos->quantidade;
+        codificar_intervalo(fonte, rotulos, programa, 0, programa->quantidade, imagem, diagnosticos, relocacoes);
+        estatisticas_fase("segunda_passagem.codificacao", inicio);
+        if (resolver_referencias_dados(rotulos, &programa->dados, diagnosticos) > 0) diagnosticos_ordenar(diagnosticos);
+        int erros = (int)(diagnosticos->quantidade - erros_anteriores);
+        if (erros == 0 && listagem != NULL) {
+            inicio = estatisticas_marcar();
+            gerar_listagem(fonte, rotulos, programa, imagem, listagem, threads);
+            estatisticas_fase("segunda_passagem.listagem", inicio);
+        }
+        return erros;
+    }
+
+    size_t blocos = (programa->quantidade + INSTRUCOES_POR_BLOCO - 1) / INSTRUCOES_POR_BLOCO;
+    ListaDiagnosticos *por_bloco = calloc(blocos, sizeof(ListaDiagnosticos));
+    ListaRelocacoes *relocacoes_por_bloco = relocacoes ? calloc(blocos, sizeof(ListaRelocacoes)) : NULL;
+    if (por_bloco == NULL || (relocacoes != NULL && relocacoes_por_bloco == NULL)) {
+        free(por_bloco);
+        free(relocacoes_por_bloco);
+        memoria_insuficiente("a segunda passagem");
+    }
+    ContextoCodificacao codificacao = { fonte, rotulos, programa, imagem, por_bloco, relocacoes_por_bloco, blocos };
+    temporarios_registrar(liberar_blocos, &codificacao);
+    executar_em_paralelo(blocos, threads, tarefa_codificar_bloco, &codificacao);
+    estatisticas_fase("segunda_passagem.codificacao", inicio);
+
+    inicio = estatisticas_marcar();
+    int erros = 0;
+    for (size_t b = 0; b < blocos; b++) {
+        erros += (int)por_bloco[b].quantidade;
+        diagnosticos_anexar(diagnosticos, &por_bloco[b], 0, 0);
+        if (relocacoes != NULL) relocacoes_anexar(relocacoes, &relocacoes_por_bloco[b]);
+    }
+    free(por_bloco);
+    free(relocacoes_por_bloco);
+    temporarios_registrar(NULL, NULL);
+    int erros_dados = resolver_referencias_dados(rotulos, &programa->dados, diagnosticos);
+    if (erros_dados > 0) diagnosticos_ordenar(diagnosticos);
+    erros += erros_dados;
+    estatisticas_fase("segunda_passagem.diagnosticos", inicio);
+    if (erros == 0 && listagem != NULL) {
+        inicio = estatisticas_marcar();
+        gerar_listagem(fonte, rotulos, programa, imagem, listagem, threads);
+        estatisticas_fase("segunda_passagem.listagem", inicio);
+    }
+    return erros;
+}
+
+// --- Escrita do Arquivo de Saída ---
+// A saída passa por um escritor com buffer grande (poucas chamadas de sistema) e por um
+// formato plugável. Os formatos recebem a imagem como uma sequência de bytes, que pode
+// chegar em vários pedaços; os formatos baseados em palavras de memória (MIF, $readmemh)
+// agrupam os bytes em little-endian antes de formatá-los.
+#define TAMANHO_BUFFER_SAIDA (1 << 20)
+
+struct FormatoSaida;
+
+typedef struct {
+    FILE *arquivo;
+    const struct FormatoSaida *formato;
+    char *buffer;
+    size_t usado;
+    int erro;                   // Diferente de 0 se alguma escrita falhou
+    uint64_t endereco;          // Endereço (em bytes) do próximo byte recebido; nos formatos
+                                // por palavra, do primeiro byte da palavra em construção
+    uint32_t palavra_parcial;   // Bytes acumulados da palavra de memória atual
+    unsigned bytes_parciais;    // Quantos bytes já estão em 'palavra_parcial' (ou em 'registro_ihex')
+    uint8_t registro_ihex[16];  // Dados do registro Intel HEX em construção
+    uint32_t segmento_ihex;     // Bits 31-16 do último endereço linear estendido emitido
+    uint64_t inicio_sequencia;  // MIF: primeira palavra da sequência de valores repetidos
+    uint64_t tamanho_sequencia; // MIF: quantidade de palavras na sequência (0 = nenhuma)
+    uint32_t valor_sequencia;   // MIF: valor repetido
+} EscritorSaida;
+
+typedef struct FormatoSaida {
+    const char *nome;          // Nome usado na opção -f
+    const char *descricao;
+    const char *extensao;       // Extensão usada quando o nome da saída é derivado da entrada
+    unsigned bytes_por_palavra; // Largura da palavra de memória (formatos por palavra); 0 = formato por bytes
+    int requer_tamanho_total;   // 1 se o cabeçalho precisa do tamanho da imagem
+    unsigned largura_fixa;      // Caracteres por byte (por palavra, nos formatos por palavra) quando não há
+                                // cabeçalho e cada unidade sempre ocupa o mesmo espaço; 0 = largura variável
+    void (*iniciar)(EscritorSaida *escritor, uint64_t tamanho_total);
+    void (*escrever_bytes)(EscritorSaida *escritor, const uint8_t *dados, size_t quantidade);
+    void (*escrever_palavra)(EscritorSaida *escritor, uint32_t palavra); // Formatos por palavra
+    void (*finalizar)(EscritorSaida *escritor);
+} FormatoSaida;
+
+// Tabelas pré-calculadas: representação binária ("01010101\n") e hexadecimal de cada byte
+static char tabela_bits[256][9];
+static char tabela_hex[256][2];
+
+static void inicializar_tabelas_saida(void) {
+    static const char digitos[] = "0123456789ABCDEF";
+    char byte_binario_txt[9]; // 8 bits + terminador nulo
+    for (int i = 0; i < 256; i++) {
+        dec_para_bin_n_bits(8, i, byte_binario_txt);
+        memcpy(tabela_bits[i], byte_binario_txt, 8);
+        tabela_bits[i][8] = '\n';
+        tabela_hex[i][0] = digitos[i >> 4];
+        tabela_hex[i][1] = digitos[i & 0xF];
+    }
+}
+
+static void escritor_descarregar(EscritorSaida *escritor) {
+    if (escritor->usado > 0 && fwrite(escritor->buffer, 1, escritor->usado, escritor->arquivo) != escritor->usado) {
+        escritor->erro = 1;
+    }
+    ESTAT_CONTAR(bytes_escritos, escritor->usado);
+    escritor->usado = 0;
+}
+
+// Garante espaço contíguo para 'quantidade' bytes no buffer e retorna onde escrevê-los
+static char *escritor_reservar(EscritorSaida *escritor, size_t quantidade) {
+    if (TAMANHO_BUFFER_SAIDA - escritor->usado < quantidade) escritor_descarregar(escritor);
+    char *destino = escritor->buffer + escritor->usado;
+    escritor->usado += quantidade;
+    return destino;
+}
+
+static void escritor_texto(EscritorSaida *escritor, const char *texto) {
+    size_t tamanho = strlen(texto);
+    memcpy(escritor_reservar(escritor, tamanho), texto, tamanho);
+}
+
+// Escreve 'valor' em hexadecimal, com pelo menos 'digitos_minimos' dígitos
+static void escritor_hex(EscritorSaida *escritor, uint64_t valor, int digitos_minimos) {
+    char digitos[16];
+    int n = 0;
+    do {
+        digitos[n++] = tabela_hex[valor & 0xF][1];
+        valor >>= 4;
+    } while (valor != 0 || n < digitos_minimos);
+    char *destino = escritor_reservar(escritor, n);
+    for (int i = 0; i < n; i++) destino[i] = digitos[n - 1 - i];
+}
+
+// --- Formato texto: uma linha de 8 bits por byte (formato original do montador) ---
+static void texto_escrever_bytes(EscritorSaida *escritor, const uint8_t *dados, size_t quantidade) {
+    while (quantidade > 0) {
+        size_t lote = quantidade < TAMANHO_BUFFER_SAIDA / 9 ? quantidade : TAMANHO_BUFFER_SAIDA / 9;
+        char *destino = escritor_reservar(escritor, lote * 9);
+        for (size_t i = 0; i < lote; i++) memcpy(destino + 9 * i, tabela_bits[dados[i]], 9);
+        dados += lote;
+        quantidade -= lote;
+    }
+}
+
+// --- Formato binário: bytes crus, little-endian ---
+static void bin_escrever_bytes(EscritorSaida *escritor, const uint8_t *dados, size_t quantidade) {
+    if (quantidade >= TAMANHO_BUFFER_SAIDA / 2) { // Blocos grandes vão direto para o arquivo
+        escritor_descarregar(escritor);
+        if (fwrite(dados, 1, quantidade, escritor->arquivo) != quantidade) escritor->erro = 1;
+        ESTAT_CONTAR(bytes_escritos, quantidade);
+        return;
+    }
+    memcpy(escritor_reservar(escritor, quantidade), dados, quantidade);
+}
+
+// --- Formato Intel HEX: registros de 16 bytes com endereço linear estendido ---
+static void ihex_registro(EscritorSaida *escritor, uint8_t tipo, uint16_t endereco, const uint8_t *dados, unsigned quantidade) {
+    char *destino = escritor_reservar(escritor, 1 + 2 * (4 + quantidade + 1) + 1);
+    uint8_t soma = (uint8_t)(quantidade + (endereco >> 8) + (endereco & 0xFF) + tipo);
+    uint8_t cabecalho[4] = { (uint8_t)quantidade, (uint8_t)(endereco >> 8), (uint8_t)endereco, tipo };
+    *destino++ = ':';
+    for (int i = 0; i < 4; i++) { memcpy(destino, tabela_hex[cabecalho[i]], 2); destino += 2; }
+    for (unsigned i = 0; i < quantidade; i++) {
+        memcpy(destino, tabela_hex[dados[i]], 2);
+        destino += 2;
+        soma += dados[i];
+    }
+    memcpy(destino, tabela_hex[(uint8_t)-soma], 2);
+    destino[2] = '\n';
+}
+
+static void ihex_emitir_registro_dados(EscritorSaida *escritor, uint64_t inicio) {
+    if (escritor->bytes_parciais == 0) return;
+    uint32_t segmento = (uint32_t)(inicio >> 16);
+    if (segmento != escritor->segmento_ihex) {
+        uint8_t dados_segmento[2] = { (uint8_t)(segmento >> 8), (uint8_t)segmento };
+        ihex_registro(escritor, 0x04, 0, dados_segmento, 2); // Endereço linear estendido
+        escritor->segmento_ihex = segmento;
+    }
+    ihex_registro(escritor, 0x00, (uint16_t)inicio, escritor->registro_ihex, escritor->bytes_parciais);
+    escritor->bytes_parciais = 0;
+}
+
+static void ihex_escrever_bytes(EscritorSaida *escritor, const uint8_t *dados, size_t quantidade) {
+    for (size_t i = 0; i < quantidade; i++) {
+        escritor->registro_ihex[escritor->bytes_parciais++] = dados[i];
+        uint64_t proximo = escritor->endereco + i + 1;
+        // Fecha o registro ao completar 16 bytes ou ao chegar a uma fronteira de 64 KiB
+        if (escritor->bytes_parciais == 16 || (proximo & 0xFFFF) == 0) {
+            ihex_emitir_registro_dados(escritor, proximo - escritor->bytes_parciais);
+        }
+    }
+}
+
+static void ihex_finalizar(EscritorSaida *escritor) {
+    ihex_emitir_registro_dados(escritor, escritor->endereco - escritor->bytes_parciais);
+    ihex_registro(escritor, 0x01, 0, NULL, 0); // Fim de arquivo
+}
+
+// --- Formato Verilog $readmemh: uma palavra de 32 bits por linha ---
+static void vmem_escrever_palavra(EscritorSaida *escritor, uint32_t palavra) {
+    char *destino = escritor_reservar(escritor, 9);
+    memcpy(destino + 0, tabela_hex[(palavra >> 24) & 0xFF], 2);
+    memcpy(destino + 2, tabela_hex[(palavra >> 16) & 0xFF], 2);
+    memcpy(destino + 4, tabela_hex[(palavra >> 8) & 0xFF], 2);
+    memcpy(destino + 6, tabela_hex[palavra & 0xFF], 2);
+    destino[8] = '\n';
+}
+
+// --- Formato MIF (Quartus): cabeçalho WIDTH/DEPTH e conteúdo com sequências colapsadas ---
+// O Quartus rejeita DEPTH=0: um programa vazio vira uma memória de uma palavra zerada.
+static void mif_iniciar(EscritorSaida *escritor, uint64_t tamanho_total) {
+    unsigned largura = escritor->formato->bytes_por_palavra;
+    uint64_t palavras = (tamanho_total + largura - 1) / largura;
+    escritor_texto(escritor, "-- Gerado pelo montador RISC-V\n");
+    escritor_texto(escritor, largura == 1 ? "WIDTH=8;\nDEPTH=" : "WIDTH=32;\nDEPTH=");
+    char profundidade[24];
+    snprintf(profundidade, sizeof(profundidade), "%llu", (unsigned long long)(palavras > 0 ? palavras : 1));
+    escritor_texto(escritor, profundidade);
+    escritor_texto(escritor, largura == 1 ? ";\n\nADDRESS_RADIX=HEX;\nDATA_RADIX=BIN;\n\nCONTENT BEGIN\n"
+                                          : ";\n\nADDRESS_RADIX=HEX;\nDATA_RADIX=HEX;\n\nCONTENT BEGIN\n");
+}
+
+static void mif_emitir_sequencia(EscritorSaida *escritor) {
+    if (escritor->tamanho_sequencia == 0) return;
+    uint64_t inicio = escritor->inicio_sequencia;
+    escritor_texto(escritor, "\t");
+    if (escritor->tamanho_sequencia == 1) {
+        escritor_hex(escritor, inicio, 1);
+    } else {
+        escritor_texto(escritor, "[");
+        escritor_hex(escritor, inicio, 1);
+        escritor_texto(escritor, "..");
+        escritor_hex(escritor, inicio + escritor->tamanho_sequencia - 1, 1);
+        escritor_texto(escritor, "]");
+    }
+    escritor_texto(escritor, " : ");
+    if (escritor->formato->bytes_por_palavra == 1) {
+        memcpy(escritor_reservar(escritor, 8), tabela_bits[escritor->valor_sequencia & 0xFF], 8);
+    } else {
+        escritor_hex(escritor, escritor->valor_sequencia, 8);
+    }
+    escritor_texto(escritor, ";\n");
+    escritor->tamanho_sequencia = 0;
+}
+
+static void mif_escrever_palavra(EscritorSaida *escritor, uint32_t palavra) {
+    if (escritor->tamanho_sequencia > 0 && palavra == escritor->valor_sequencia) {
+        escritor->tamanho_sequencia++;
+        return;
+    }
+    mif_emitir_sequencia(escritor);
+    escritor->inicio_sequencia = escritor->endereco / escritor->formato->bytes_por_palavra;
+    escritor->valor_sequencia = palavra;
+    escritor->tamanho_sequencia = 1;
+}
+
+static void mif_finalizar(EscritorSaida *escritor) {
+    if (escritor->endereco == 0) mif_escrever_palavra(escritor, 0); // Programa vazio (ver mif_iniciar)
+    mif_emitir_sequencia(escritor);
+    escritor_texto(escritor, "END;\n");
+}
+
+static const FormatoSaida formatos_saida[] = {
+    { "mif",   "MIF do Quartus, palavras de 8 bits",           ".mif",  1, 1, 0, mif_iniciar, NULL, mif_escrever_palavra, mif_finalizar },
+    { "mif32", "MIF do Quartus, palavras de 32 bits",          ".mif",  4, 1, 0, mif_iniciar, NULL, mif_escrever_palavra, mif_finalizar },
+    { "bin",   "binário cru, little-endian",                   ".bin",  0, 0, 1, NULL, bin_escrever_bytes, NULL, NULL },
+    { "ihex",  "Intel HEX",                                    ".hex",  0, 0, 0, NULL, ihex_escrever_bytes, NULL, ihex_finalizar },
+    { "vmem",  "Verilog $readmemh, palavras de 32 bits",       ".vmem", 4, 0, 9, NULL, NULL, vmem_escrever_palavra, NULL },
+    { "texto", "uma linha de 8 bits por byte (formato antigo)", ".txt",  0, 0, 9, NULL, texto_escrever_bytes, NULL, NULL },
+};
+
+#define NUMERO_FORMATOS_SAIDA (sizeof(formatos_saida) / sizeof(formatos_saida[0]))
+
+// Retorna o formato com o nome dado, ou NULL se não existir
+static const FormatoSaida *buscar_formato_saida(const char *nome) {
+    for (size_t i = 0; i < NUMERO_FORMATOS_SAIDA; i++) {
+        if (strcmp(formatos_saida[i].nome, nome) == 0) return &formatos_saida[i];
+    }
+    return NULL;
+}
+
+// Escolhe o formato pela extensão do arquivo de saída quando a opção -f não é usada
+static const FormatoSaida *formato_pela_extensao(const char *nome_arquivo_saida) {
+    const char *extensao = strrchr(nome_arquivo_saida, '.');
+    if (extensao != NULL) {
+        if (strcmp(extensao, ".mif") == 0) return buscar_formato_saida("mif");
+        if (strcmp(extensao, ".bin") == 0) return buscar_formato_saida("bin");
+        if (strcmp(extensao, ".hex") == 0 || strcmp(extensao, ".ihex") == 0) return buscar_formato_saida("ihex");
+        if (strcmp(extensao, ".vmem") == 0 || strcmp(extensao, ".mem") == 0) return buscar_formato_saida("vmem");
+    }
+    return buscar_formato_saida("texto");
+}
+
+// Abre o arquivo de saída ("-" para a saída padrão) e inicia o formato. 'tamanho_total' é o tamanho da imagem em bytes.
+// Retorna 0 em caso de sucesso ou -1 em caso de erro.
+static int saida_abrir(EscritorSaida *escritor, const char *nome_arquivo_saida, const FormatoSaida *formato, uint64_t tamanho_total) {
+    memset(escritor, 0, sizeof(*escritor));
+    escritor->formato = formato;
+    escritor->buffer = malloc(TAMANHO_BUFFER_SAIDA);
+    if (escritor->buffer == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o buffer de saída.\n");
+        return -1;
+    }
+    escritor->arquivo = strcmp(nome_arquivo_saida, "-") == 0 ? stdout : fopen(nome_arquivo_saida, "wb"); // "-" = saída padrão
+    if (escritor->arquivo == NULL) {
+        perror("Erro ao abrir o arquivo de saída");
+        free(escritor->buffer);
+        return -1;
+    }
+    if (formato->iniciar) formato->iniciar(escritor, tamanho_total);
+    return 0;
+}
+
+// Entrega os próximos bytes da imagem ao formato
+static void saida_escrever(EscritorSaida *escritor, const uint8_t *dados, size_t quantidade) {
+    const FormatoSaida *formato = escritor->formato;
+    if (formato->escrever_bytes) {
+        formato->escrever_bytes(escritor, dados, quantidade);
+        escritor->endereco += quantidade;
+        return;
+    }
+
+    // Formatos por palavra: agrupa os bytes em little-endian
+    // ('endereco' aponta para o primeiro byte da palavra em construção)
+    unsigned largura = formato->bytes_por_palavra;
+    for (size_t i = 0; i < quantidade; i++) {
+        escritor->palavra_parcial |= (uint32_t)dados[i] << (8 * escritor->bytes_parciais);
+        if (++escritor->bytes_parciais < largura) continue;
+        formato->escrever_palavra(escritor, escritor->palavra_parcial);
+        escritor->endereco += largura;
+        escritor->palavra_parcial = 0;
+        escritor->bytes_parciais = 0;
+    }
+}
+
+// Completa a última palavra com zeros, finaliza o formato e fecha o arquivo.
+// Retorna 0 em caso de sucesso ou -1 se alguma escrita falhou.
+static int saida_fechar(EscritorSaida *escritor) {
+    const FormatoSaida *formato = escritor->formato;
+    if (formato->escrever_palavra && escritor->bytes_parciais > 0) {
+        static const uint8_t zeros[4] = { 0, 0, 0, 0 };
+        saida_escrever(escritor, zeros, formato->bytes_por_palavra - escritor->bytes_parciais);
+    }
+    if (formato->finalizar) formato->finalizar(escritor);
+    escritor_descarregar(escritor);
+    if ((escritor->arquivo == stdout ? fflush(stdout) : fclose(escritor->arquivo)) != 0) escritor->erro = 1;
+    free(escritor->buffer);
+    if (escritor->erro) {
+        fprintf(stderr, "Erro ao escrever o arquivo de saída.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Escreve a imagem completa no arquivo de saída, no formato escolhido
+static int escrever_saida(const char *nome_arquivo_saida, const FormatoSaida *formato, const uint8_t *imagem, size_t tamanho) {
+    EscritorSaida escritor;
+    if (saida_abrir(&escritor, nome_arquivo_saida, formato, tamanho) != 0) return -1;
+    saida_escrever(&escritor, imagem, tamanho);
+    return saida_fechar(&escritor);
+}
+
+// Regrava, em um arquivo de saída já escrito com a imagem inteira, só os bytes [inicio, fim)
+// de 'imagem' ('tamanho' bytes). Vale apenas para os formatos de largura fixa, em que a posição
+// de cada byte no arquivo é conhecida; nos formatos por palavra, o trecho é estendido às
+// palavras inteiras. Retorna 0 em caso de sucesso ou -1 em caso de erro.
+static int saida_regravar(const char *nome_arquivo_saida, const FormatoSaida *formato, const uint8_t *imagem, size_t tamanho,
+                   size_t inicio, size_t fim) {
+    EscritorSaida escritor;
+    unsigned unidade = formato->bytes_por_palavra ? formato->bytes_por_palavra : 1;
+    inicio -= inicio % unidade;
+    if (fim % unidade != 0) fim += unidade - fim % unidade;
+    if (fim > tamanho) fim = tamanho; // A última palavra é completada com zeros por saida_fechar
+
+    memset(&escritor, 0, sizeof(escritor));
+    escritor.formato = formato;
+    escritor.buffer = malloc(TAMANHO_BUFFER_SAIDA);
+    if (escritor.buffer == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o buffer de saída.\n");
+        return -1;
+    }
+    escritor.arquivo = fopen(nome_arquivo_saida, "r+b");
+    if (escritor.arquivo == NULL || fseek(escritor.arquivo, (long)(inicio / unidade * formato->largura_fixa), SEEK_SET) != 0) {
+        perror("Erro ao regravar o arquivo de saída");
+        if (escritor.arquivo != NULL) fclose(escritor.arquivo);
+        free(escritor.buffer);
+        return -1;
+    }
+    escritor.endereco = inicio;
+    saida_escrever(&escritor, imagem + inicio, fim - inicio);
+    return saida_fechar(&escritor);
+}
+
+// Entrega 'quantidade' cópias do byte 'valor' ao formato
+static void saida_escrever_repetido(EscritorSaida *escritor, uint8_t valor, uint64_t quantidade) {
+    uint8_t bloco[4096];
+    memset(bloco, valor, sizeof(bloco));
+    while (quantidade > 0) {
+        size_t n = quantidade < sizeof(bloco) ? (size_t)quantidade : sizeof(bloco);
+        saida_escrever(escritor, bloco, n);
+        quantidade -= n;
+    }
+}
+
+// Entrega a seção de dados ao formato. Itens de .word/.half/.byte seguidos são contíguos em
+// 'bytes' e saem em um único bloco; o conteúdo de um .incbin sai direto do arquivo mapeado.
+static void dados_escrever(EscritorSaida *escritor, const SecaoDados *dados) {
+    for (size_t i = 0; i < dados->quantidade_itens; i++) {
+        const ItemDados *item = &dados->itens[i];
+        if (item->tamanho == 0) continue; // Nada a escrever (ver dados_copiar)
+        switch (item->tipo) {
+        case DADO_BYTES: {
+            uint32_t fim = item->origem + item->tamanho;
+            while (i + 1 < dados->quantidade_itens && dados->itens[i + 1].tipo == DADO_BYTES) fim += dados->itens[++i].tamanho;
+            saida_escrever(escritor, dados->bytes + item->origem, fim - item->origem);
+            break;
+        }
+        case DADO_REPETIDO:    saida_escrever_repetido(escritor, item->valor, item->tamanho); break;
+        case DADO_ALINHAMENTO: saida_escrever_repetido(escritor, 0, item->tamanho); break;
+        case DADO_INCLUIDO:    saida_escrever(escritor, dados->incluidos[item->origem].inicio, item->tamanho); break;
+        }
+    }
+}
+
+// Escreve a imagem do programa: o código e, se a seção de dados não for separada nem vazia,
+// zeros até a base da seção e os dados
+static int escrever_programa(const char *nome_arquivo_saida, const FormatoSaida *formato, const uint8_t *codigo, uint32_t tamanho_codigo,
+                      const SecaoDados *dados) {
+    EscritorSaida escritor;
+    uint64_t tamanho_total = tamanho_imagem(tamanho_codigo, dados);
+    if (saida_abrir(&escritor, nome_arquivo_saida, formato, tamanho_total) != 0) return -1;
+    saida_escrever(&escritor, codigo, tamanho_codigo);
+    if (tamanho_total > tamanho_codigo) {
+        saida_escrever_repetido(&escritor, 0, dados->base - tamanho_codigo);
+        dados_escrever(&escritor, dados);
+    }
+    return saida_fechar(&escritor);
+}
+
+// Escreve só a seção de dados, a partir do endereço 0 do arquivo (--dados)
+static int escrever_dados(const char *nome_arquivo_saida, const FormatoSaida *formato, const SecaoDados *dados) {
+    EscritorSaida escritor;
+    if (saida_abrir(&escritor, nome_arquivo_saida, formato, dados->tamanho) != 0) return -1;
+    dados_escrever(&escritor, dados);
+    return saida_fechar(&escritor);
+}
+
+// --- Montagem em Fluxo (passagem única) ---
+// Lê o fonte linha a linha (de um arquivo ou de um pipe) e codifica cada instrução assim que
+// ela é lida. Rótulos já definidos são resolvidos na hora; uma referência a um rótulo ainda
+// não definido vira uma pendência, encadeada no próprio rótulo e corrigida quando ele aparece.
+// O código fica em uma janela que começa na pendência mais antiga: tudo o que vem antes dela
+// já está definitivo e é entregue ao formato de saída. Assim a memória usada depende da
+// distância das referências para frente, e não do tamanho do programa.
+#define TAMANHO_MINIMO_DESCARGA (64 * 1024) // Bytes definitivos acumulados antes de descarregar a janela
+
+typedef struct {
+    uint32_t endereco;      // Endereço da instrução a corrigir
+    uint32_t numero_linha;
+    uint32_t rotulo;        // Posição do rótulo referenciado na tabela
+    uint32_t anterior;      // Pendência anterior do mesmo rótulo (índice + 1; 0 = nenhuma)
+    uint8_t instrucao, rd, rs1, rs2;
+    char *texto_linha;      // Cópia da linha para as mensagens de erro (NULL = já resolvida)
+} Pendencia;
+
+typedef struct {
+    ListaDiagnosticos *diagnosticos;
+    EscritorSaida *saida;   // NULL enquanto a saída não foi aberta (formatos que exigem o tamanho total)
+    uint8_t *janela;        // Código ainda não entregue à saída
+    size_t usado, capacidade;
+    uint32_t inicio_janela; // Endereço do primeiro byte da janela
+    Pendencia *pendencias;  // Em ordem de endereço
+    size_t quantidade_pendencias, capacidade_pendencias;
+    size_t primeira_pendente; // Pendências anteriores a esta já foram resolvidas
+} MontagemFluxo;
+
+// Reserva 'quantidade' bytes no fim da janela e retorna onde gravá-los
+static uint8_t *fluxo_reservar(MontagemFluxo *fluxo, size_t quantidade) {
+    if (fluxo->usado + quantidade > fluxo->capacidade) {
+        size_t capacidade = fluxo->capacidade ? fluxo->capacidade * 2 : 2 * TAMANHO_MINIMO_DESCARGA;
+        uint8_t *nova = realloc(fluxo->janela, capacidade);
+        if (nova == NULL) memoria_insuficiente("o código montado");
+        fluxo->janela = nova;
+        fluxo->capacidade = capacidade;
+    }
+    uint8_t *destino = fluxo->janela + fluxo->usado;
+    fluxo->usado += quantidade;
+    return destino;
+}
+
+static void fluxo_acrescentar_palavra(MontagemFluxo *fluxo, uint32_t palavra) {
+    gravar_palavra_le(fluxo_reservar(fluxo, 4), palavra);
+}
+
+// Codifica a instrução de uma pendência com o endereço (já conhecido) do seu rótulo
+static void fluxo_resolver(MontagemFluxo *fluxo, Pendencia *pendencia, const Rotulo *rotulo) {
+    const DescritorInstrucao *descritor = &tabela_instrucoes[pendencia->instrucao];
+    Operandos operandos = { pendencia->rd, pendencia->rs1, pendencia->rs2, 0, { NULL, 0 } };
+    LinhaAtual atual = { NULL, fluxo->diagnosticos, pendencia->numero_linha, pendencia->endereco, pendencia->texto_linha };
+    if (resolver_referencia(descritor, rotulo->endereco, &atual, rotulo->nome, (int)rotulo->tamanho, &operandos.imm) == 0) {
+        gravar_palavra_le(fluxo->janela + (pendencia->endereco - fluxo->inicio_janela), codificar_instrucao(descritor, &operandos));
+    }
+    free(pendencia->texto_linha);
+    pendencia->texto_linha = NULL;
+}
+
+// Entrega à saída a parte da janela que não tem mais pendências ('tudo' força a entrega completa)
+static void fluxo_descarregar(MontagemFluxo *fluxo, int tudo) {
+    while (fluxo->primeira_pendente < fluxo->quantidade_pendencias && fluxo->pendencias[fluxo->primeira_pendente].texto_linha == NULL) {
+        fluxo->primeira_pendente++;
+    }
+    if (fluxo->primeira_pendente == fluxo->quantidade_pendencias) { // Todas resolvidas: a lista recomeça
+        fluxo->quantidade_pendencias = 0;
+        fluxo->primeira_pendente = 0;
+    }
+    if (fluxo->saida == NULL || fluxo->diagnosticos->quantidade > 0) return;
+
+    size_t definitivos = fluxo->usado;
+    if (fluxo->quantidade_pendencias > 0) definitivos = fluxo->pendencias[fluxo->primeira_pendente].endereco - fluxo->inicio_janela;
+    // Só descarrega quando compensa o deslocamento do restante da janela
+    if (!tudo && (definitivos < TAMANHO_MINIMO_DESCARGA || definitivos < fluxo->usado / 2)) return;
+
+    saida_escrever(fluxo->saida, fluxo->janela, definitivos);
+    memmove(fluxo->janela, fluxo->janela + definitivos, fluxo->usado - definitivos);
+    fluxo->usado -= definitivos;
+    fluxo->inicio_janela += (uint32_t)definitivos;
+}
+
+// Define o endereço de um rótulo da seção de dados e corrige as instruções que o aguardavam
+static void fluxo_definir_rotulo_dados(MontagemFluxo *fluxo, Rotulo *rotulo, const SecaoDados *dados) {
+    rotulo->endereco = endereco_rotulo_dados(dados, rotulo->instrucao);
+    for (uint32_t p = rotulo->pendencias; p != 0; p = fluxo->pendencias[p - 1].anterior) {
+        fluxo_resolver(fluxo, &fluxo->pendencias[p - 1], rotulo);
+    }
+    rotulo->pendencias = 0;
+}
+
+// Monta o fonte lido de 'entrada' em uma única passagem, escrevendo em 'nome_arquivo_saida'.
+// Formatos cujo cabeçalho exige o tamanho total (MIF) só são escritos ao final, com a janela
+// guardando o programa inteiro. Os erros são acrescentados a 'diagnosticos' em ordem de linha
+// e, se houver algum, o arquivo de saída é removido. Com 'comprimir', usa a forma de 16 bits
+// das instruções que não dependem de rótulos e das que referenciam rótulos já definidos; as
+// referências para frente ficam com 4 bytes, pois o deslocamento ainda é desconhecido.
+// A seção .data fica em memória e é escrita depois do código (ou em 'nome_arquivo_dados', se
+// não for NULL). Sem base fixa ('base_dados' -1), o endereço dos rótulos de dados só é
+// conhecido no fim do fonte, e as instruções que os referenciam ficam pendentes até lá.
+// Retorna 0 em caso de sucesso ou -1.
+SOMENTE_LINHA_COMANDO int montar_fluxo(FILE *entrada, TabelaRotulos *rotulos, const char *nome_arquivo_saida, const FormatoSaida *formato,
+                 ListaDiagnosticos *diagnosticos, int comprimir, int64_t base_dados, const char *nome_arquivo_dados) {
+    EscritorSaida escritor;
+    MontagemFluxo fluxo;
+    memset(&fluxo, 0, sizeof(fluxo));
+    fluxo.diagnosticos = diagnosticos;
+    SecaoDados dados;
+    memset(&dados, 0, sizeof(dados));
+    dados.base_fixa = base_dados >= 0;
+    dados.base = dados.base_fixa ? (uint32_t)base_dados : 0;
+    dados.separada = nome_arquivo_dados != NULL;
+    Arena textos = { NULL }; // Cópias das linhas da seção .data, para as mensagens de erro
+    uint32_t *aguardando = NULL; // Rótulos de dados à espera do próximo item (com base fixa)
+    size_t quantidade_aguardando = 0, capacidade_aguardando = 0;
+    Secao secao = SECAO_TEXTO;
+    int codigo_sobreposto = 0; // Já avisou que o código alcançou a base fixa da seção .data
+    if (!formato->requer_tamanho_total) {
+        if (saida_abrir(&escritor, nome_arquivo_saida, formato, 0) != 0) return -1;
+        fluxo.saida = &escritor;
+    }
+
+    char *linha_lida = NULL;
+    size_t capacidade_lida = 0;
+    uint32_t endereco_atual = 0;
+    uint32_t numero_linha = 0;
+    ssize_t tamanho_lido;
+    int resultado = 0;
+
+    while ((tamanho_lido = getline(&linha_lida, &capacidade_lida, entrada)) != -1) {
+        numero_linha++;
+        Lexico lexico;
+        lexico_iniciar(&lexico, linha_lida, linha_lida + tamanho_lido);
+        const char *inicio_linha = lexico_linha(&lexico);
+        if (inicio_linha == NULL) continue;
+
+        LinhaAtual atual = { &lexico, diagnosticos, numero_linha, endereco_atual, inicio_linha };
+        LinhaInterpretada interpretada;
+        size_t item_inicial = dados.quantidade_itens, referencia_inicial = dados.quantidade_referencias;
+        interpretar_linha(&atual, secao, &dados, &interpretada);
+
+        if (dados.quantidade_itens > item_inicial) {
+            // O buffer da linha é reaproveitado: os itens e referências passam a apontar para uma cópia
+            size_t tamanho_texto = strcspn(inicio_linha, "\n\r");
+            const char *copia = arena_copiar_texto(&textos, inicio_linha, tamanho_texto);
+            for (size_t i = item_inicial; i < dados.quantidade_itens; i++) dados.itens[i].texto_linha = copia;
+            for (size_t i = referencia_inicial; i < dados.quantidade_referencias; i++) {
+                ReferenciaDados *referencia = &dados.referencias[i];
+                referencia->simbolo = copia + (referencia->simbolo - inicio_linha);
+                referencia->texto_linha = copia;
+            }
+            if (dados_posicionar(&dados, item_inicial) < dados.quantidade_itens) {
+                erro_linha(&atual, "A seção .data excede 2 GiB");
+                resultado = -1;
+                break;
+            }
+            if (dados.base_fixa) {
+                const ItemDados *item = &dados.itens[item_inicial];
+                if (item->tipo == DADO_ALINHAMENTO && dados.base % item->origem != 0) {
+                    erro_linha(&atual, "A base da seção .data (0x%08X) não é múltipla do alinhamento de %u bytes", dados.base, item->origem);
+                }
+                if ((uint64_t)dados.base + dados.tamanho > TAMANHO_MAXIMO_DADOS) {
+                    erro_linha(&atual, "O programa excede o espaço de endereçamento");
+                    resultado = -1;
+                    break;
+                }
+                for (size_t r = 0; r < quantidade_aguardando; r++) fluxo_definir_rotulo_dados(&fluxo, &rotulos->rotulos[aguardando[r]], &dados);
+                quantidade_aguardando = 0;
+            }
+        }
+
+        if (interpretada.rotulo.texto != NULL) {
+            uint32_t posicao = tabela_rotulos_obter(rotulos, interpretada.rotulo.texto, interpretada.rotulo.tamanho);
+            Rotulo *rotulo = &rotulos->rotulos[posicao];
+            if (rotulo->endereco != -1 || rotulo->dados) {
+                erro_linha(&atual, "Rótulo '%.*s' definido mais de uma vez", (int)interpretada.rotulo.tamanho, interpretada.rotulo.texto);
+            } else if (secao == SECAO_DADOS) {
+                rotulo->dados = 1;
+                rotulo->instrucao = (uint32_t)item_inicial;
+                if (dados.base_fixa && dados.quantidade_itens > item_inicial) {
+                    fluxo_definir_rotulo_dados(&fluxo, rotulo, &dados);
+                } else if (dados.base_fixa) {
+                    aguardando = dados_reservar(aguardando, quantidade_aguardando, &capacidade_aguardando, 1, sizeof(uint32_t));
+                    aguardando[quantidade_aguardando++] = posicao;
+                }
+            } else {
+                rotulo->endereco = (int)endereco_atual;
+                for (uint32_t p = rotulo->pendencias; p != 0; p = fluxo.pendencias[p - 1].anterior) {
+                    fluxo_resolver(&fluxo, &fluxo.pendencias[p - 1], rotulo);
+                }
+                rotulo->pendencias = 0;
+            }
+        }
+        if (interpretada.global.texto != NULL) {
+            uint32_t posicao = tabela_rotulos_obter(rotulos, interpretada.global.texto, interpretada.global.tamanho); // Pode realocar o vetor
+            rotulos->rotulos[posicao].global = 1;
+        }
+        if (interpretada.secao != SECAO_INDEFINIDA) secao = interpretada.secao;
+        if (interpretada.tamanho == 0) continue;
+        if (endereco_atual > UINT32_MAX - 2 * 4 * MAXIMO_INSTRUCOES_LINHA || endereco_atual > INT32_MAX) {
+            erro_linha(&atual, "O programa excede o espaço de endereçamento");
+            resultado = -1;
+            break;
+        }
+        uint32_t endereco_linha = endereco_atual;
+        if (interpretada.quantidade == 0) { // Instrução inválida: a palavra fica zerada
+            fluxo_acrescentar_palavra(&fluxo, 0);
+            endereco_atual += 4;
+        }
+
+        for (int k = 0; k < interpretada.quantidade; k++) {
+            uint32_t palavra = 0;
+            const DescritorInstrucao *descritor = interpretada.descritores[k];
+            Operandos *operandos = &interpretada.operandos[k];
+            atual.endereco = endereco_atual;
+            if (operandos->simbolo.texto != NULL) {
+                uint32_t posicao = tabela_rotulos_obter(rotulos, operandos->simbolo.texto, operandos->simbolo.tamanho);
+                Rotulo *rotulo = &rotulos->rotulos[posicao];
+                if (rotulo->endereco == -1) { // Referência para frente: fica pendente
+                    if (fluxo.quantidade_pendencias == fluxo.capacidade_pendencias) {
+                        size_t capacidade = fluxo.capacidade_pendencias ? fluxo.capacidade_pendencias * 2 : 64;
+                        Pendencia *novas = realloc(fluxo.pendencias, capacidade * sizeof(Pendencia));
+                        if (novas == NULL) memoria_insuficiente("as referências pendentes");
+                        fluxo.pendencias = novas;
+                        fluxo.capacidade_pendencias = capacidade;
+                    }
+                    Pendencia *pendencia = &fluxo.pendencias[fluxo.quantidade_pendencias++];
+                    pendencia->endereco = endereco_atual;
+                    pendencia->numero_linha = numero_linha;
+                    pendencia->rotulo = posicao;
+                    pendencia->anterior = rotulo->pendencias;
+                    pendencia->instrucao = (uint8_t)(descritor - tabela_instrucoes);
+                    pendencia->rd = (uint8_t)operandos->rd;
+                    pendencia->rs1 = (uint8_t)operandos->rs1;
+                    pendencia->rs2 = (uint8_t)operandos->rs2;
+                    pendencia->texto_linha = strndup(inicio_linha, strcspn(inicio_linha, "\n\r"));
+                    if (pendencia->texto_linha == NULL) memoria_insuficiente("as referências pendentes");
+                    rotulo->pendencias = (uint32_t)fluxo.quantidade_pendencias;
+                    descritor = NULL; // A palavra é gravada quando o rótulo for definido
+                } else if (descritor->formato == FORMATO_B && rotulo->endereco - (int)endereco_atual < -4096) {
+                    // Branch para trás fora do alcance: já se sabe que precisa ser relaxado.
+                    // Para frente não há como saber ao ler a linha, e o alcance é verificado ao resolver.
+                    uint32_t palavras[2] = { 0, 0 };
+                    codificar_branch_relaxado(descritor, operandos, rotulo->endereco, &atual, rotulo->nome, (int)rotulo->tamanho, palavras);
+                    fluxo_acrescentar_palavra(&fluxo, palavras[0]);
+                    fluxo_acrescentar_palavra(&fluxo, palavras[1]);
+                    endereco_atual += 8;
+                    continue;
+                } else if (resolver_referencia(descritor, rotulo->endereco, &atual, operandos->simbolo.texto,
+                                               (int)operandos->simbolo.tamanho, &operandos->imm) != 0) {
+                    descritor = NULL;
+                }
+            }
+            // Como na montagem em duas passagens, %hi/%lo nunca são comprimidos
+            uint16_t comprimida;
+            int relativo_pc = descritor != NULL && (descritor->formato == FORMATO_B || descritor->formato == FORMATO_J);
+            if (comprimir && descritor != NULL && (operandos->simbolo.texto == NULL || relativo_pc) &&
+                comprimir_instrucao(descritor, operandos, &comprimida)) {
+                gravar_meia_palavra_le(fluxo_reservar(&fluxo, 2), comprimida);
+                endereco_atual += 2;
+                continue;
+            }
+            if (descritor != NULL) palavra = codificar_instrucao(descritor, operandos);
+            fluxo_acrescentar_palavra(&fluxo, palavra);
+            endereco_atual += 4;
+        }
+        if (dados.base_fixa && !dados.separada && !codigo_sobreposto && endereco_atual > dados.base) {
+            atual.endereco = endereco_linha;
+            erro_linha(&atual, "O código ultrapassa o início da seção .data (0x%08X)", dados.base);
+            codigo_sobreposto = 1;
+        }
+        fluxo_descarregar(&fluxo, 0);
+    }
+    if (ferror(entrada)) {
+        fprintf(stderr, "Erro ao ler o arquivo de entrada.\n");
+        resultado = -1;
+    }
+
+    // Sem base fixa, a seção de dados fica logo após o código, agora com tamanho conhecido
+    dados_definir_base(&dados, endereco_atual);
+    for (uint32_t r = 0; r < rotulos->quantidade; r++) {
+        Rotulo *rotulo = &rotulos->rotulos[r];
+        if (rotulo->dados && rotulo->endereco == -1) fluxo_definir_rotulo_dados(&fluxo, rotulo, &dados);
+    }
+    if (resultado == 0 && dados.quantidade_itens > 0 && (uint64_t)dados.base + dados.tamanho > TAMANHO_MAXIMO_DADOS) {
+        const ItemDados *item = &dados.itens[dados.quantidade_itens - 1];
+        diagnosticos_adicionar(diagnosticos, item->numero_linha, item->deslocamento, item->texto_linha,
+                               "O programa excede o espaço de endereçamento");
+    }
+    resolver_referencias_dados(rotulos, &dados, diagnosticos);
+
+    // Referências que nunca foram resolvidas
+    for (size_t p = fluxo.primeira_pendente; p < fluxo.quantidade_pendencias; p++) {
+        Pendencia *pendencia = &fluxo.pendencias[p];
+        if (pendencia->texto_linha == NULL) continue;
+        const Rotulo *rotulo = &rotulos->rotulos[pendencia->rotulo];
+        diagnosticos_adicionar(diagnosticos, pendencia->numero_linha, pendencia->endereco, pendencia->texto_linha,
+                               "Rótulo '%s' não encontrado", rotulo->nome);
+        free(pendencia->texto_linha);
+    }
+    fluxo.quantidade_pendencias = 0;
+    ESTAT_CONTAR(linhas, numero_linha);
+    diagnosticos_ordenar(diagnosticos);
+    if (diagnosticos->quantidade > 0) resultado = -1;
+
+    uint64_t tamanho_total = tamanho_imagem(endereco_atual, &dados);
+    if (resultado == 0 && fluxo.saida == NULL) {
+        if (saida_abrir(&escritor, nome_arquivo_saida, formato, tamanho_total) != 0) resultado = -1;
+        else fluxo.saida = &escritor;
+    }
+    if (resultado == 0) {
+        fluxo_descarregar(&fluxo, 1);
+        if (tamanho_total > endereco_atual) {
+            saida_escrever_repetido(&escritor, 0, dados.base - endereco_atual);
+            dados_escrever(&escritor, &dados);
+        }
+    }
+    if (fluxo.saida != NULL && saida_fechar(&escritor) != 0) resultado = -1;
+    if (resultado != 0 && fluxo.saida != NULL && strcmp(nome_arquivo_saida, "-") != 0) {
+        remove(nome_arquivo_saida); // Não deixa uma saída incompleta para trás
+    }
+    if (resultado == 0 && nome_arquivo_dados != NULL && escrever_dados(nome_arquivo_dados, formato, &dados) != 0) resultado = -1;
+
+    free(linha_lida);
+    free(fluxo.janela);
+    free(fluxo.pendencias);
+    free(aguardando);
+    dados_liberar(&dados);
+    arena_liberar(&textos);
+    return resultado;
+}
+
+// --- Objetos Relocáveis e Ligação ---
+// Com -c, cada fonte vira um objeto relocável e o executável é produzido depois por --ligar.
+// O formato do objeto é próprio e simples, todo em palavras de 32 bits little-endian:
+//   cabeçalho:  "RVO1", versão, bytes de código, número de símbolos, de relocações e bytes de nomes
+//   código:     a imagem montada a partir do endereço 0, com os campos relocáveis zerados
+//   símbolos:   (posição do nome, valor, flags) para cada rótulo do arquivo, definido ou externo
+//   relocações: (endereço, índice do símbolo, tipo)
+//   nomes:      os nomes dos símbolos, cada um terminado em '\0'
+// A ligação posiciona os objetos um após o outro, na ordem da linha de comando, resolve os
+// símbolos externos pelos globais (.globl) dos demais objetos e aplica as relocações.
+#define MAGICO_OBJETO "RVO1"
+#define VERSAO_OBJETO 1
+#define TAMANHO_CABECALHO_OBJETO 24
+#define SIMBOLO_GLOBAL   0x1 // Declarado com .globl
+#define SIMBOLO_DEFINIDO 0x2 // Definido neste objeto (senão, é externo)
+
+// Grava o objeto relocável com o código montado, os rótulos e as relocações da segunda passagem.
+// Os rótulos externos referenciados pelas relocações entram na tabela como indefinidos.
+// Retorna 0 em caso de sucesso ou -1 em caso de erro.
+static int escrever_objeto(const char *nome_arquivo_saida, const uint8_t *codigo, size_t tamanho_codigo,
+                    TabelaRotulos *rotulos, const ListaRelocacoes *relocacoes) {
+    uint32_t *simbolos_relocacoes = malloc((relocacoes->quantidade ? relocacoes->quantidade : 1) * sizeof(uint32_t));
+    if (simbolos_relocacoes == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o objeto.\n");
+        return -1;
+    }
+    for (size_t i = 0; i < relocacoes->quantidade; i++) {
+        simbolos_relocacoes[i] = tabela_rotulos_obter(rotulos, relocacoes->itens[i].nome, relocacoes->itens[i].tamanho);
+    }
+    size_t tamanho_nomes = 0;
+    for (uint32_t i = 0; i < rotulos->quantidade; i++) tamanho_nomes += rotulos->rotulos[i].tamanho + 1;
+
+    size_t tamanho = TAMANHO_CABECALHO_OBJETO + tamanho_codigo + 12 * (size_t)rotulos->quantidade + 12 * relocacoes->quantidade + tamanho_nomes;
+    uint8_t *objeto = malloc(tamanho);
+    if (objeto == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o objeto.\n");
+        free(simbolos_relocacoes);
+        return -1;
+    }
+    memcpy(objeto, MAGICO_OBJETO, 4);
+    gravar_palavra_le(objeto + 4, VERSAO_OBJETO);
+    gravar_palavra_le(objeto + 8, (uint32_t)tamanho_codigo);
+    gravar_palavra_le(objeto + 12, rotulos->quantidade);
+    gravar_palavra_le(objeto + 16, (uint32_t)relocacoes->quantidade);
+    gravar_palavra_le(objeto + 20, (uint32_t)tamanho_nomes);
+    uint8_t *cursor = objeto + TAMANHO_CABECALHO_OBJETO;
+    memcpy(cursor, codigo, tamanho_codigo);
+    cursor += tamanho_codigo;
+
+    char *nomes = (char *)objeto + tamanho - tamanho_nomes;
+    uint32_t posicao_nome = 0;
+    for (uint32_t i = 0; i < rotulos->quantidade; i++, cursor += 12) {
+        const Rotulo *rotulo = &rotulos->rotulos[i];
+        gravar_palavra_le(cursor, posicao_nome);
+        gravar_palavra_le(cursor + 4, rotulo->endereco == -1 ? 0 : (uint32_t)rotulo->endereco);
+        gravar_palavra_le(cursor + 8, (rotulo->global ? SIMBOLO_GLOBAL : 0) | (rotulo->endereco != -1 ? SIMBOLO_DEFINIDO : 0));
+        memcpy(nomes + posicao_nome, rotulo->nome, rotulo->tamanho);
+        nomes[posicao_nome + rotulo->tamanho] = '\0';
+        posicao_nome += rotulo->tamanho + 1;
+    }
+    for (size_t i = 0; i < relocacoes->quantidade; i++, cursor += 12) {
+        gravar_palavra_le(cursor, relocacoes->itens[i].endereco);
+        gravar_palavra_le(cursor + 4, simbolos_relocacoes[i]);
+        gravar_palavra_le(cursor + 8, relocacoes->itens[i].tipo);
+    }
+    free(simbolos_relocacoes);
+
+    // O objeto já está pronto em memória: basta gravá-lo como bytes crus
+    EscritorSaida escritor;
+    int resultado = saida_abrir(&escritor, nome_arquivo_saida, buscar_formato_saida("bin"), tamanho);
+    if (resultado == 0) {
+        saida_escrever(&escritor, objeto, tamanho);
+        resultado = saida_fechar(&escritor);
+    }
+    free(objeto);
+    return resultado;
+}
+
+// Um objeto de entrada da ligação, com as tabelas apontando para dentro do arquivo carregado
+typedef struct {
+    const char *nome_arquivo;
+    Fonte conteudo;              // Arquivo inteiro, em memória
+    uint32_t base;               // Endereço do código do objeto na imagem ligada
+    uint32_t tamanho_codigo, numero_simbolos, numero_relocacoes, tamanho_nomes;
+    const uint8_t *codigo, *simbolos, *relocacoes;
+    const char *nomes;
+} ObjetoLigacao;
+
+// Carrega um objeto e valida toda a sua estrutura, para que a ligação possa confiar nela.
+// Retorna 0 em caso de sucesso ou -1 (com a mensagem de erro já impressa).
+static int carregar_objeto(const char *nome_arquivo, ObjetoLigacao *objeto) {
+    objeto->nome_arquivo = nome_arquivo;
+    if (carregar_fonte(nome_arquivo, &objeto->conteudo, NULL) != 0) return -1;
+    const uint8_t *dados = (const uint8_t *)objeto->conteudo.texto;
+    size_t tamanho = objeto->conteudo.tamanho;
+    if (tamanho < TAMANHO_CABECALHO_OBJETO || memcmp(dados, MAGICO_OBJETO, 4) != 0 || ler_palavra_le(dados + 4) != VERSAO_OBJETO) {
+        fprintf(stderr, "Erro: '%s' não é um objeto relocável deste montador (gere-o com -c).\n", nome_arquivo);
+        return -1;
+    }
+    objeto->tamanho_codigo = ler_palavra_le(dados + 8);
+    objeto->numero_simbolos = ler_palavra_le(dados + 12);
+    objeto->numero_relocacoes = ler_palavra_le(dados + 16);
+    objeto->tamanho_nomes = ler_palavra_le(dados + 20);
+    uint64_t esperado = TAMANHO_CABECALHO_OBJETO + (uint64_t)objeto->tamanho_codigo + 12 * (uint64_t)objeto->numero_simbolos +
+                        12 * (uint64_t)objeto->numero_relocacoes + objeto->tamanho_nomes;
+    objeto->codigo = dados + TAMANHO_CABECALHO_OBJETO;
+    objeto->simbolos = objeto->codigo + objeto->tamanho_codigo;
+    objeto->relocacoes = objeto->simbolos + 12 * (size_t)objeto->numero_simbolos;
+    objeto->nomes = (const char *)objeto->relocacoes + 12 * (size_t)objeto->numero_relocacoes;
+    int valido = esperado == tamanho && objeto->tamanho_codigo % 2 == 0 && // Com --rvc, múltiplo de 2 bytes
+                 (objeto->tamanho_nomes == 0 || objeto->nomes[objeto->tamanho_nomes - 1] == '\0');
+    for (uint32_t i = 0; valido && i < objeto->numero_simbolos; i++) {
+        const uint8_t *simbolo = objeto->simbolos + 12 * (size_t)i;
+        valido = ler_palavra_le(simbolo) < objeto->tamanho_nomes && ler_palavra_le(simbolo + 4) <= objeto->tamanho_codigo;
+    }
+    for (uint32_t i = 0; valido && i < objeto->numero_relocacoes; i++) {
+        const uint8_t *relocacao = objeto->relocacoes + 12 * (size_t)i;
+        uint32_t endereco = ler_palavra_le(relocacao), tipo = ler_palavra_le(relocacao + 8);
+        valido = endereco % 2 == 0 && endereco + 4 <= (uint64_t)objeto->tamanho_codigo && ler_palavra_le(relocacao + 4) < objeto->numero_simbolos &&
+                 tipo >= RELOCACAO_BRANCH && tipo < NUMERO_TIPOS_RELOCACAO;
+    }
+    if (!valido) {
+        fprintf(stderr, "Erro: O objeto '%s' está corrompido.\n", nome_arquivo);
+        return -1;
+    }
+    return 0;
+}
+
+// Campo corrigido por cada tipo de relocação: um descritor apenas com o formato (opcode e
+// functs zerados), para reaproveitar os codificadores, e os bits da instrução que não mudam
+static const struct {
+    DescritorInstrucao campo;
+    uint32_t preservados;
+} campos_relocacao[NUMERO_TIPOS_RELOCACAO] = {
+    [RELOCACAO_BRANCH] = { { "branch", FORMATO_B, 0, 0, 0, OPERANDOS_NENHUM }, 0x01FFF07F },
+    [RELOCACAO_JAL]    = { { "jal",    FORMATO_J, 0, 0, 0, OPERANDOS_NENHUM }, 0x00000FFF },
+    [RELOCACAO_HI20]   = { { "%hi",    FORMATO_U, 0, 0, 0, OPERANDOS_NENHUM }, 0x00000FFF },
+    [RELOCACAO_LO12_I] = { { "%lo",    FORMATO_I, 0, 0, 0, OPERANDOS_NENHUM }, 0x000FFFFF },
+    [RELOCACAO_LO12_S] = { { "%lo",    FORMATO_S, 0, 0, 0, OPERANDOS_NENHUM }, 0x01FFF07F },
+};
+
+// Preenche o campo da instrução em 'atual->endereco' com a referência a 'endereco_destino'.
+// Retorna 0 ou -1 (deslocamento fora do alcance, registrado em 'atual').
+static int aplicar_relocacao(uint8_t *imagem, TipoRelocacao tipo, int endereco_destino, LinhaAtual *atual, const char *nome) {
+    const DescritorInstrucao *campo = &campos_relocacao[tipo].campo;
+    Operandos operandos = { 0, 0, 0, 0, { NULL, 0 } };
+    if (resolver_referencia(campo, endereco_destino, atual, nome, (int)strlen(nome), &operandos.imm) != 0) return -1;
+    uint8_t *instrucao = imagem + atual->endereco;
+    uint32_t preservados = ler_palavra_le(instrucao) & campos_relocacao[tipo].preservados;
+    gravar_palavra_le(instrucao, preservados | codificar_instrucao(campo, &operandos));
+    return 0;
+}
+
+// Liga os objetos (na ordem dada, a partir do endereço 0) e grava a imagem resultante em
+// 'nome_arquivo_saida', no formato 'formato'. Retorna 0 em caso de sucesso ou 1.
+SOMENTE_LINHA_COMANDO int ligar_objetos(char *const *nomes_objetos, size_t quantidade, const char *nome_arquivo_saida, const FormatoSaida *formato) {
+    ObjetoLigacao *objetos = calloc(quantidade ? quantidade : 1, sizeof(ObjetoLigacao));
+    if (objetos == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para a ligação.\n");
+        return 1;
+    }
+    TabelaRotulos globais;
+    memset(&globais, 0, sizeof(globais));
+    ListaDiagnosticos diagnosticos = { NULL, 0, 0 };
+    uint8_t *imagem = NULL;
+    uint64_t tamanho_total = 0;
+    int erros = 0;
+
+    for (size_t i = 0; i < quantidade; i++) {
+        if (carregar_objeto(nomes_objetos[i], &objetos[i]) != 0) { erros++; continue; }
+        objetos[i].base = (uint32_t)tamanho_total;
+        tamanho_total += objetos[i].tamanho_codigo;
+        if (tamanho_total > INT32_MAX) {
+            fprintf(stderr, "Erro: O programa ligado excede o espaço de endereçamento.\n");
+            erros++;
+            break;
+        }
+    }
+    if (erros != 0) goto fim;
+
+    // Símbolos globais definidos, com seus endereços finais
+    for (size_t i = 0; i < quantidade; i++) {
+        const ObjetoLigacao *objeto = &objetos[i];
+        for (uint32_t s = 0; s < objeto->numero_simbolos; s++) {
+            const uint8_t *simbolo = objeto->simbolos + 12 * (size_t)s;
+            if ((ler_palavra_le(simbolo + 8) & (SIMBOLO_GLOBAL | SIMBOLO_DEFINIDO)) != (SIMBOLO_GLOBAL | SIMBOLO_DEFINIDO)) continue;
+            const char *nome = objeto->nomes + ler_palavra_le(simbolo);
+            if (tabela_rotulos_inserir(&globais, nome, strlen(nome), (int)(objeto->base + ler_palavra_le(simbolo + 4))) != 0) {
+                fprintf(stderr, "Erro: Símbolo global '%s' definido mais de uma vez (também em '%s').\n", nome, objeto->nome_arquivo);
+                erros++;
+            }
+        }
+    }
+
+    imagem = malloc(tamanho_total ? tamanho_total : 1);
+    if (imagem == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o código ligado.\n");
+        erros++;
+        goto fim;
+    }
+    for (size_t i = 0; i < quantidade; i++) memcpy(imagem + objetos[i].base, objetos[i].codigo, objetos[i].tamanho_codigo);
 
-// Função para adicionar um rótulo à tabela
-void adicionar_rotulo(const char *nome_rotulo, int endereco_rotulo) {
-    if (contador_rotulos < MAX_ROTULOS) {
-        strcpy(rotulos[contador_rotulos].nome, nome_rotulo);
-        rotulos[contador_rotulos].endereco = endereco_rotulo;
-        contador_rotulos++;
-    } else {
-        fprintf(stderr, "Erro: Limite de rótulos excedido. Aumente MAX_ROTULOS.\n");
+    // Relocações: símbolos definidos no próprio objeto valem mesmo sem .globl
+    for (size_t i = 0; i < quantidade; i++) {
+        const ObjetoLigacao *objeto = &objetos[i];
+        for (uint32_t r = 0; r < objeto->numero_relocacoes; r++) {
+            const uint8_t *relocacao = objeto->relocacoes + 12 * (size_t)r;
+            const uint8_t *simbolo = objeto->simbolos + 12 * (size_t)ler_palavra_le(relocacao + 4);
+            const char *nome = objeto->nomes + ler_palavra_le(simbolo);
+            uint32_t endereco = objeto->base + ler_palavra_le(relocacao);
+            int endereco_destino = (ler_palavra_le(simbolo + 8) & SIMBOLO_DEFINIDO)
+                                       ? (int)(objeto->base + ler_palavra_le(simbolo + 4))
+                                       : tabela_rotulos_buscar(&globais, nome, strlen(nome));
+            LinhaAtual atual = { NULL, &diagnosticos, 0, endereco, objeto->nome_arquivo };
+            if (endereco_destino == -1) {
+                erro_linha(&atual, "Símbolo '%s' não definido em nenhum objeto", nome);
+            } else {
+                aplicar_relocacao(imagem, (TipoRelocacao)ler_palavra_le(relocacao + 8), endereco_destino, &atual, nome);
+            }
+        }
+    }
+    for (size_t i = 0; i < diagnosticos.quantidade; i++) {
+        const Diagnostico *item = &diagnosticos.itens[i];
+        fprintf(stderr, "Erro em '%s' (0x%04X): %s.\n", item->texto_linha, item->endereco, item->mensagem);
+    }
+    erros += (int)diagnosticos.quantidade;
+    if (erros == 0 && escrever_saida(nome_arquivo_saida, formato, imagem, tamanho_total) != 0) erros++;
+
+fim:
+    for (size_t i = 0; i < quantidade; i++) free(objetos[i].conteudo.texto);
+    free(objetos);
+    free(imagem);
+    diagnosticos_liberar(&diagnosticos);
+    tabela_rotulos_liberar(&globais);
+    return erros == 0 ? 0 : 1;
+}
+
+// --- Interface de Biblioteca (montador.h) ---
+// A montagem em memória usada pela linha de comando, pela montagem em lote e por quem inclui
+// o montador como biblioteca. Todo o estado fica no contexto; as únicas tabelas globais (o
+// hash dos mnemônicos, as tabelas de formatação da saída e a classificação usada pelo
+// analisador léxico) são preenchidas uma única vez, com pthread_once, e depois só são lidas.
+struct MontadorContexto {
+    int threads;
+    int comprimir;                      // 1 = usa instruções comprimidas (RVC) quando possível
+    int64_t base_dados;                 // Endereço da seção .data (-1 = logo após o código)
+    int dados_separados;                // 1 = a seção .data vai para um arquivo próprio (--dados)
+    int sem_arquivos;                   // 1 = .incbin é recusado (montador_montar)
+    TabelaRotulos rotulos;
+    ProgramaIR programa;
+    ListaDiagnosticos diagnosticos;
+    int passagem_com_erros;             // 1 ou 2 se a última montagem falhou em uma passagem
+    MontadorDiagnostico *registros;     // Visão pública de 'diagnosticos'
+    size_t capacidade_registros;
+    char *fonte;                        // Cópia do fonte do chamador, terminada em '\0'
+    size_t capacidade_fonte;
+    uint8_t *imagem;                    // Código montado, quando não vai para o buffer do chamador
+    size_t capacidade_imagem;
+    Listagem *listagem;                 // Textos pedidos à segunda passagem (NULL = nenhum)
+};
+
+static pthread_once_t inicializacao_tabelas = PTHREAD_ONCE_INIT;
+
+static void inicializar_tabelas(void) {
+    inicializar_analisador_lexico();
+    inicializar_tabela_instrucoes();
+    inicializar_tabelas_saida();
+}
+
+MontadorContexto *montador_criar(void) {
+    pthread_once(&inicializacao_tabelas, inicializar_tabelas);
+    MontadorContexto *contexto = calloc(1, sizeof(MontadorContexto));
+    if (contexto != NULL) {
+        contexto->threads = 1;
+        contexto->base_dados = -1;
     }
+    return contexto;
 }
 
-// Função para buscar o endereço de um rótulo
-int buscar_endereco_rotulo(const char *nome_rotulo) {
-    for (int i = 0; i < contador_rotulos; i++) {
-        if (strcmp(rotulos[i].nome, nome_rotulo) == 0) {
-            return rotulos[i].endereco;
+void montador_destruir(MontadorContexto *contexto) {
+    if (contexto == NULL) return;
+    tabela_rotulos_liberar(&contexto->rotulos);
+    programa_ir_liberar(&contexto->programa);
+    diagnosticos_liberar(&contexto->diagnosticos);
+    free(contexto->registros);
+    free(contexto->fonte);
+    free(contexto->imagem);
+    free(contexto);
+}
+
+void montador_definir_threads(MontadorContexto *contexto, int threads) {
+    contexto->threads = threads > 1 ? threads : 1;
+}
+
+// Reserva 'tamanho' bytes em um buffer do contexto, que só cresce
+static void *contexto_reservar(void *buffer, size_t *capacidade, size_t tamanho) {
+    if (tamanho <= *capacidade) return buffer;
+    void *novo = realloc(buffer, tamanho);
+    if (novo == NULL) memoria_insuficiente("a montagem");
+    *capacidade = tamanho;
+    return novo;
+}
+
+// Monta 'fonte' com o estado do contexto, reaproveitando a memória da montagem anterior.
+// O código vai para 'imagem' (little-endian, até 'capacidade' bytes, que precisam comportar
+// também a seção de dados) ou, se ela for NULL, para contexto->imagem; *tamanho recebe o
+// número de bytes do código. A seção de dados fica em contexto->programa.dados. Com
+// 'relocacoes', gera o código de um objeto relocável.
+static MontadorResultado montar_fonte(MontadorContexto *contexto, const Fonte *fonte, uint8_t *imagem, size_t capacidade,
+                                      size_t *tamanho, ListaRelocacoes *relocacoes) {
+    SecaoDados *dados = &contexto->programa.dados;
+    tabela_rotulos_limpar(&contexto->rotulos);
+    contexto->programa.quantidade = 0;
+    dados_limpar(dados);
+    dados->base_fixa = contexto->base_dados >= 0;
+    dados->base = dados->base_fixa ? (uint32_t)contexto->base_dados : 0;
+    dados->separada = contexto->dados_separados;
+    dados->sem_arquivos = contexto->sem_arquivos;
+    diagnosticos_liberar(&contexto->diagnosticos);
+    contexto->passagem_com_erros = 0;
+    *tamanho = 0;
+
+    // Primeira Passagem: Coleta rótulos e interpreta as instruções
+    MarcaTempo inicio = estatisticas_marcar();
+    int erros = primeira_passagem(fonte, &contexto->rotulos, &contexto->programa, &contexto->diagnosticos, contexto->comprimir, contexto->threads);
+    estatisticas_fase("primeira_passagem", inicio);
+    if (erros == 0 && relocacoes != NULL && dados->quantidade_itens > 0) {
+        const ItemDados *item = &dados->itens[0];
+        diagnosticos_adicionar(&contexto->diagnosticos, item->numero_linha, item->deslocamento, item->texto_linha,
+                               "A seção .data não é suportada em objetos relocáveis (-c)");
+        erros = 1;
+    }
+    if (erros != 0) {
+        contexto->passagem_com_erros = 1;
+        return MONTADOR_ERRO_FONTE;
+    }
+
+    *tamanho = contexto->programa.tamanho;
+    if (imagem == NULL) {
+        contexto->imagem = contexto_reservar(contexto->imagem, &contexto->capacidade_imagem, *tamanho ? *tamanho : 1);
+        imagem = contexto->imagem;
+    } else if (tamanho_imagem((uint32_t)*tamanho, dados) > capacidade) {
+        return MONTADOR_ERRO_CAPACIDADE;
+    }
+
+    // Segunda Passagem: Resolve rótulos e monta o código
+    inicio = estatisticas_marcar();
+    erros = segunda_passagem(fonte, &contexto->rotulos, &contexto->programa, imagem, &contexto->diagnosticos, relocacoes,
+                             contexto->listagem, contexto->threads);
+    estatisticas_fase("segunda_passagem", inicio);
+    if (erros != 0) {
+        contexto->passagem_com_erros = 2;
+        return MONTADOR_ERRO_FONTE;
+    }
+    return MONTADOR_OK;
+}
+
+static MontadorResultado montar_memoria(MontadorContexto *contexto, const char *fonte, size_t tamanho,
+                                        uint32_t *palavras, size_t capacidade, size_t *quantidade) {
+    contexto->sem_arquivos = 1; // A biblioteca não abre arquivos em nome de quem a usa
+    diagnosticos_liberar(&contexto->diagnosticos);
+    if (tamanho > UINT32_MAX) return MONTADOR_ERRO_TAMANHO; // A IR guarda posições de 32 bits no fonte
+
+    // As passagens e as mensagens de erro contam com o '\0' no final do fonte
+    contexto->fonte = contexto_reservar(contexto->fonte, &contexto->capacidade_fonte, tamanho + 1);
+    memcpy(contexto->fonte, fonte, tamanho);
+    contexto->fonte[tamanho] = '\0';
+    Fonte copia = { contexto->fonte, tamanho, 0 };
+
+    // Sem buffer, a capacidade é 0: a montagem só informa o tamanho. O destino não pode ser
+    // NULL, que para montar_fonte quer dizer "use contexto->imagem"
+    uint32_t vazio;
+    if (palavras == NULL) {
+        palavras = &vazio;
+        capacidade = 0;
+    }
+    size_t tamanho_codigo;
+    MontadorResultado resultado = montar_fonte(contexto, &copia, (uint8_t *)palavras, capacidade * 4, &tamanho_codigo, NULL);
+    // Sem instruções comprimidas, o código é sempre um número inteiro de palavras; a seção de
+    // dados pode terminar no meio de uma, completada com zeros
+    const SecaoDados *dados = &contexto->programa.dados;
+    uint64_t tamanho_total = resultado == MONTADOR_ERRO_FONTE ? tamanho_codigo : tamanho_imagem((uint32_t)tamanho_codigo, dados);
+    *quantidade = (size_t)((tamanho_total + 3) / 4);
+    if (resultado == MONTADOR_OK) {
+        uint8_t *bytes = (uint8_t *)palavras;
+        if (tamanho_total > tamanho_codigo) {
+            memset(bytes + tamanho_codigo, 0, *quantidade * 4 - tamanho_codigo);
+            dados_copiar(dados, bytes + dados->base);
         }
+        // O programa é gravado em little-endian; a interface entrega palavras na ordem da máquina
+        for (size_t i = 0; i < *quantidade; i++) palavras[i] = ler_palavra_le((const uint8_t *)&palavras[i]);
     }
-    return -1; // Rótulo não encontrado
+    return resultado;
 }
 
-// --- Funções Auxiliares ---
-// Converte o nome de um registrador (ABI ou xN) para seu número (0-31)
-int obter_numero_registrador(const char *nome_reg) {
-    if (strcmp(nome_reg, "zero") == 0) return 0;
-    if (strcmp(nome_reg, "ra") == 0) return 1;
-    if (strcmp(nome_reg, "sp") == 0) return 2;
-    if (strcmp(nome_reg, "gp") == 0) return 3;
-    if (strcmp(nome_reg, "tp") == 0) return 4;
-    if (strcmp(nome_reg, "t0") == 0) return 5;
-    if (strcmp(nome_reg, "t1") == 0) return 6;
-    if (strcmp(nome_reg, "t2") == 0) return 7;
-    if (strcmp(nome_reg, "s0") == 0 || strcmp(nome_reg, "fp") == 0) return 8; // fp é alias para s0
-    if (strcmp(nome_reg, "s1") == 0) return 9;
-    if (strcmp(nome_reg, "a0") == 0) return 10;
-    if (strcmp(nome_reg, "a1") == 0) return 11;
-    if (strcmp(nome_reg, "a2") == 0) return 12;
-    if (strcmp(nome_reg, "a3") == 0) return 13;
-    if (strcmp(nome_reg, "a4") == 0) return 14;
-    if (strcmp(nome_reg, "a5") == 0) return 15;
-    if (strcmp(nome_reg, "a6") == 0) return 16;
-    if (strcmp(nome_reg, "a7") == 0) return 17;
-    if (strcmp(nome_reg, "s2") == 0) return 18;
-    if (strcmp(nome_reg, "s3") == 0) return 19;
-    if (strcmp(nome_reg, "s4") == 0) return 20;
-    if (strcmp(nome_reg, "s5") == 0) return 21;
-    if (strcmp(nome_reg, "s6") == 0) return 22;
-    if (strcmp(nome_reg, "s7") == 0) return 23;
-    if (strcmp(nome_reg, "s8") == 0) return 24;
-    if (strcmp(nome_reg, "s9") == 0) return 25;
-    if (strcmp(nome_reg, "s10") == 0) return 26;
-    if (strcmp(nome_reg, "s11") == 0) return 27;
-    if (strcmp(nome_reg, "t3") == 0) return 28;
-    if (strcmp(nome_reg, "t4") == 0) return 29;
-    if (strcmp(nome_reg, "t5") == 0) return 30;
-    if (strcmp(nome_reg, "t6") == 0) return 31;
-    
-    // Tenta converter de "xN" para N
-    if (nome_reg[0] == 'x') {
-        int num_reg = atoi(&nome_reg[1]);
-        if (num_reg >= 0 && num_reg <= 31) {
-            return num_reg;
-        }
-    }
-    return -1; // Nome de registrador inválido
+MontadorResultado montador_montar(MontadorContexto *contexto, const char *fonte, size_t tamanho,
+                                  uint32_t *palavras, size_t capacidade, size_t *quantidade) {
+    *quantidade = 0;
+    RetornoMemoria *anterior = retorno_memoria;
+    RetornoMemoria retorno = { .liberar = NULL };
+    if (setjmp(retorno.ponto) != 0) { // Faltou memória em algum ponto da montagem
+        retorno_memoria = anterior;
+        *quantidade = 0;
+        return MONTADOR_ERRO_MEMORIA;
+    }
+    retorno_memoria = &retorno;
+    MontadorResultado resultado = montar_memoria(contexto, fonte, tamanho, palavras, capacidade, quantidade);
+    retorno_memoria = anterior;
+    return resultado;
 }
 
-// Converte um número decimal para uma string binária com um número específico de bits
-void dec_para_bin_n_bits(int num_bits, int decimal, char *string_binaria) {
-    for (int i = num_bits - 1; i >= 0; i--) {
-        string_binaria[num_bits - 1 - i] = ((decimal >> i) & 1) ? '1' : '0';
+const MontadorDiagnostico *montador_diagnosticos(MontadorContexto *contexto, size_t *quantidade) {
+    const ListaDiagnosticos *lista = &contexto->diagnosticos;
+    *quantidade = 0;
+    if (lista->quantidade == 0) return NULL;
+    if (lista->quantidade * sizeof(MontadorDiagnostico) > contexto->capacidade_registros) {
+        MontadorDiagnostico *registros = realloc(contexto->registros, lista->quantidade * sizeof(MontadorDiagnostico));
+        if (registros == NULL) return NULL;
+        contexto->registros = registros;
+        contexto->capacidade_registros = lista->quantidade * sizeof(MontadorDiagnostico);
     }
-    string_binaria[num_bits] = '\0'; // Terminador nulo
+    *quantidade = lista->quantidade;
+    for (size_t i = 0; i < lista->quantidade; i++) {
+        const Diagnostico *item = &lista->itens[i];
+        contexto->registros[i] = (MontadorDiagnostico){ item->numero_linha, item->endereco, item->mensagem, item->texto_linha };
+    }
+    return contexto->registros;
 }
 
-// --- Função da Primeira Passagem (Coleta de Rótulos) ---
-// Lê o arquivo de entrada, identifica todos os rótulos e armazena seus nomes e endereços.
-// Endereços são contados em bytes, assumindo 4 bytes por instrução.
-void primeira_passagem(const char *nome_arquivo_entrada) {
-    FILE *arquivo_entrada = fopen(nome_arquivo_entrada, "r");
-    if (arquivo_entrada == NULL) {
-        perror("Erro ao abrir o arquivo de entrada na primeira passagem");
-        exit(1);
+// --- Montagem em Lote ---
+// Monta vários arquivos em um único processo, sem eco no console. O manifesto tem um par
+// "entrada [saida]" por linha (linhas vazias e comentários com '#' são ignorados); sem saída,
+// é usado o nome da entrada com a extensão do formato. Cada arquivo é uma tarefa independente,
+// com sua própria tabela de rótulos, e as tarefas são distribuídas entre as threads com roubo
+// de trabalho. As mensagens de erro ficam guardadas e são impressas no resumo final, em ordem.
+typedef struct {
+    const char *entrada;
+    char *saida;
+    const FormatoSaida *formato;    // NULL = objeto relocável (-c)
+    int comprimir;                  // 1 = usa instruções comprimidas (--rvc)
+    int64_t base_dados;             // Endereço da seção .data (-1 = logo após o código)
+    int resultado;                  // 0 = montado, 1 = com erro
+    size_t instrucoes;
+    size_t bytes;
+    ListaDiagnosticos diagnosticos;
+} TrabalhoLote;
+
+// Monta um arquivo do lote (executada em paralelo; não usa estado global mutável)
+static void tarefa_montar_arquivo(void *contexto, size_t indice) {
+    TrabalhoLote *trabalho = &((TrabalhoLote *)contexto)[indice];
+    trabalho->resultado = 1;
+    Fonte fonte;
+    if (mapear_fonte(trabalho->entrada, &fonte, &trabalho->diagnosticos) != 0) return; // O erro sai no resumo
+    MontadorContexto *montagem = montador_criar();
+    if (montagem == NULL) {
+        diagnosticos_erro_arquivo(&trabalho->diagnosticos, "Memória insuficiente para montar '%s'", trabalho->entrada);
+        fonte_liberar(&fonte);
+        return;
+    }
+
+    ListaRelocacoes relocacoes = { NULL, 0, 0 };
+    int objeto = (trabalho->formato == NULL);
+    size_t tamanho;
+    montagem->comprimir = trabalho->comprimir;
+    montagem->base_dados = trabalho->base_dados;
+    if (montar_fonte(montagem, &fonte, NULL, 0, &tamanho, objeto ? &relocacoes : NULL) == MONTADOR_OK &&
+        (objeto ? escrever_objeto(trabalho->saida, montagem->imagem, tamanho, &montagem->rotulos, &relocacoes)
+                : escrever_programa(trabalho->saida, trabalho->formato, montagem->imagem, (uint32_t)tamanho, &montagem->programa.dados)) == 0) {
+        trabalho->resultado = 0;
+        trabalho->instrucoes = montagem->programa.quantidade;
+        trabalho->bytes = (size_t)tamanho_imagem((uint32_t)tamanho, &montagem->programa.dados);
     }
+    diagnosticos_anexar(&trabalho->diagnosticos, &montagem->diagnosticos, 0, 0);
+    relocacoes_liberar(&relocacoes);
+    montador_destruir(montagem);
+    fonte_liberar(&fonte);
+}
+
+// Nome de saída padrão: a entrada com a extensão trocada por 'extensao' (ex.: a do formato)
+static char *nome_com_extensao(const char *entrada, const char *extensao) {
+    const char *barra = strrchr(entrada, '/');
+    const char *ponto = strrchr(entrada, '.');
+    size_t base = (ponto != NULL && (barra == NULL || ponto > barra)) ? (size_t)(ponto - entrada) : strlen(entrada);
+    char *nome = malloc(base + strlen(extensao) + 1);
+    if (nome == NULL) memoria_insuficiente("o nome de saída");
+    memcpy(nome, entrada, base);
+    strcpy(nome + base, extensao);
+    return nome;
+}
 
-    char linha[256];
-    int endereco_atual = 0; // Endereço da instrução atual em bytes
+// Monta todos os arquivos do manifesto usando até 'threads' threads. 'formato' pode ser NULL
+// (formato escolhido pela extensão de cada saída); com 'objeto', cada arquivo vira um objeto
+// relocável (".o" por padrão) e, com 'comprimir', usa instruções comprimidas. 'base_dados' é o
+// endereço da seção .data de todos os arquivos (-1 = logo após o código de cada um).
+// Imprime o resumo e retorna 0 se todos os arquivos foram montados ou 1 caso contrário.
+SOMENTE_LINHA_COMANDO int montar_lote(const char *nome_manifesto, const FormatoSaida *formato, int objeto, int comprimir, int64_t base_dados, int threads) {
+    Fonte manifesto;
+    if (carregar_fonte(nome_manifesto, &manifesto, NULL) != 0) return 1;
 
-    while (fgets(linha, sizeof(linha), arquivo_entrada) != NULL) {
-        // Remove nova linha e espaços em branco no final
-        linha[strcspn(linha, "\n\r")] = 0; 
-        char *inicio_linha = linha;
-        while (*inicio_linha == ' ' || *inicio_linha == '\t') inicio_linha++; // Pula espaços no início
+    TrabalhoLote *trabalhos = NULL;
+    size_t quantidade = 0, capacidade = 0;
+    char *estado_linhas = NULL;
+    for (char *linha = strtok_r(manifesto.texto, "\n", &estado_linhas); linha != NULL; linha = strtok_r(NULL, "\n", &estado_linhas)) {
+        linha[strcspn(linha, "#")] = '\0';
+        char *estado_tokens = NULL;
+        char *entrada = strtok_r(linha, " \t\r", &estado_tokens);
+        if (entrada == NULL) continue;
+        char *saida = strtok_r(NULL, " \t\r", &estado_tokens);
 
-        // Ignora linhas vazias ou comentários
-        if (strlen(inicio_linha) == 0 || inicio_linha[0] == '#' || inicio_linha[0] == ';') {
-            continue;
+        if (quantidade == capacidade) {
+            capacidade = capacidade ? capacidade * 2 : 64;
+            TrabalhoLote *novos = realloc(trabalhos, capacidade * sizeof(TrabalhoLote));
+            if (novos == NULL) memoria_insuficiente("o manifesto");
+            trabalhos = novos;
         }
-        
-        // Cria uma cópia da linha para tokenização, pois strtok modifica a string
-        char linha_temporaria[256];
-        strcpy(linha_temporaria, inicio_linha);
-
-        char *token = strtok(linha_temporaria, " ,\t"); // Delimitadores: espaço, vírgula, tabulação
-        if (token == NULL) continue;
-
-        // Verifica se o primeiro token é um rótulo (termina com ':')
-        char *ponteiro_dois_pontos = strchr(token, ':');
-        if (ponteiro_dois_pontos != NULL) {
-            *ponteiro_dois_pontos = '\0'; // Remove o ':' para obter o nome do rótulo
-            adicionar_rotulo(token, endereco_atual);
-            
-            // Avança para o próximo token, que seria a instrução (se houver na mesma linha)
-            token = strtok(NULL, " ,\t"); 
-            if (token == NULL) { // Rótulo em uma linha própria
-                continue; 
-            }
+        TrabalhoLote *trabalho = &trabalhos[quantidade++];
+        memset(trabalho, 0, sizeof(*trabalho));
+        trabalho->entrada = entrada;
+        trabalho->comprimir = comprimir;
+        trabalho->base_dados = base_dados;
+        if (objeto) {
+            trabalho->saida = saida ? strdup(saida) : nome_com_extensao(entrada, ".o");
+        } else if (saida != NULL) {
+            trabalho->saida = strdup(saida);
+            trabalho->formato = formato ? formato : formato_pela_extensao(saida);
+        } else {
+            trabalho->formato = formato ? formato : buscar_formato_saida("mif");
+            trabalho->saida = nome_com_extensao(entrada, trabalho->formato->extensao);
         }
-        // Se não era um rótulo ou se havia uma instrução após o rótulo,
-        // esta linha contém uma instrução que ocupará 4 bytes.
-        endereco_atual += 4;
+        if (trabalho->saida == NULL) memoria_insuficiente("o manifesto");
     }
-    fclose(arquivo_entrada);
+
+    executar_em_paralelo(quantidade, threads, tarefa_montar_arquivo, trabalhos);
+
+    // Resumo, na ordem do manifesto
+    size_t montados = 0;
+    for (size_t i = 0; i < quantidade; i++) {
+        TrabalhoLote *trabalho = &trabalhos[i];
+        if (trabalho->resultado == 0) {
+            montados++;
+            printf("OK     %s -> %s (%zu instruções, %zu bytes)\n", trabalho->entrada, trabalho->saida, trabalho->instrucoes, trabalho->bytes);
+        } else {
+            printf("FALHA  %s", trabalho->entrada);
+            if (trabalho->diagnosticos.quantidade > 0) printf(" (%zu erro(s))", trabalho->diagnosticos.quantidade);
+            printf("\n");
+            fflush(stdout);
+            diagnosticos_imprimir(&trabalho->diagnosticos);
+            fflush(stderr);
+        }
+        diagnosticos_liberar(&trabalho->diagnosticos);
+        free(trabalho->saida);
+    }
+    printf("Lote: %zu de %zu arquivo(s) montado(s), %zu com falha.\n", montados, quantidade, quantidade - montados);
+
+    free(trabalhos);
+    free(manifesto.texto);
+    return montados == quantidade ? 0 : 1;
 }
 
-// --- Função da Segunda Passagem (Geração do Código Binário) ---
-// Lê o arquivo de entrada novamente, traduz cada instrução para seu formato binário
-// e escreve o resultado no arquivo de saída.
-void segunda_passagem(const char *nome_arquivo_entrada, const char *nome_arquivo_saida) {
-    FILE *arquivo_entrada = NULL;
-    FILE *arquivo_saida = NULL;
-    char linha[256];
-    int endereco_atual = 0; // Endereço da instrução atual em bytes
-
-    arquivo_entrada = fopen(nome_arquivo_entrada, "r");
-    if (arquivo_entrada == NULL) {
-        perror("Erro ao abrir o arquivo de entrada na segunda passagem");
-        return;
+// --- Simulador (--executar) ---
+// Executa a imagem montada, para conferir o comportamento de um programa sem um simulador
+// externo. Antes da execução, o código é decodificado uma única vez, pelas mesmas tabelas da
+// montagem (decodificar_instrucao e descomprimir_instrucao), para um cache com uma entrada por
+// instrução, em ordem de endereço e com os imediatos já prontos: destinos de branches e jal
+// viram distâncias em entradas e auipc vira uma constante. A execução só despacha de entrada
+// em entrada (a seguinte é sempre a próxima do vetor, qualquer que seja o tamanho da
+// instrução), com goto computado no GCC e no Clang, em que cada rotina salta direto para a
+// próxima, e com um switch nos demais compiladores ou com -DMONTADOR_DESPACHO_SWITCH.
+// A imagem fica no endereço 0 de uma memória de tamanho configurável (--mem) e o sp começa no
+// fim dela. As chamadas de sistema (ecall) seguem as do RARS, pelo número em a7: 1 imprime o
+// inteiro em a0, 4 a string em a0, 11 o caractere em a0, 10 encerra e 93 encerra com o código
+// em a0. A execução também termina quando o pc chega ao fim do código.
+#define MEMORIA_PADRAO_SIMULADOR (16u << 20)
+#define SEM_ENTRADA UINT32_MAX
+
+// Operações do simulador: as instruções reais da tabela (pelo mnemônico) e as internas
+#define OPERACOES_SIMULADOR(X)                                                                                      \
+    X(ADD, "add") X(SUB, "sub") X(SLL, "sll") X(SLT, "slt") X(SLTU, "sltu") X(XOR, "xor") X(SRL, "srl")               \
+    X(SRA, "sra") X(OR, "or") X(AND, "and")                                                                         \
+    X(MUL, "mul") X(MULH, "mulh") X(MULHSU, "mulhsu") X(MULHU, "mulhu") X(DIV, "div") X(DIVU, "divu")               \
+    X(REM, "rem") X(REMU, "remu")                                                                                   \
+    X(ADDI, "addi") X(SLTI, "slti") X(SLTIU, "sltiu") X(XORI, "xori") X(ORI, "ori") X(ANDI, "andi")                 \
+    X(SLLI, "slli") X(SRLI, "srli") X(SRAI, "srai")                                                                 \
+    X(LB, "lb") X(LH, "lh") X(LW, "lw") X(LBU, "lbu") X(LHU, "lhu") X(JALR, "jalr") X(ECALL, "ecall")               \
+    X(EBREAK, "ebreak") X(SB, "sb") X(SH, "sh") X(SW, "sw")                                                         \
+    X(BEQ, "beq") X(BNE, "bne") X(BLT, "blt") X(BGE, "bge") X(BLTU, "bltu") X(BGEU, "bgeu")                         \
+    X(LUI, "lui") X(AUIPC, "auipc") X(JAL, "jal")                                                                   \
+    X(ILEGAL, NULL)          /* Palavra que não é uma instrução */                                                  \
+    X(DESVIO_INVALIDO, NULL) /* Branch ou jal sem instrução no destino (imm = destino) */                           \
+    X(FIM, NULL)             /* Sentinela logo após a última instrução */
+
+#define OPERACAO_ENUM(nome, mnemonico) OP_##nome,
+typedef enum { OPERACOES_SIMULADOR(OPERACAO_ENUM) NUMERO_OPERACOES } OperacaoSimulador;
+
+#define OPERACAO_MNEMONICO(nome, mnemonico) mnemonico,
+static const char *const mnemonicos_operacoes[NUMERO_OPERACOES] = { OPERACOES_SIMULADOR(OPERACAO_MNEMONICO) };
+
+typedef struct {
+    int32_t imm;          // Imediato; em branches e jal, a distância em entradas até o destino; em lui e auipc, o valor final
+    uint32_t retorno;     // Endereço da instrução seguinte (o valor de ligação de jal e jalr)
+    uint8_t operacao;     // OperacaoSimulador
+    uint8_t rd, rs1, rs2; // rd = 32 (registrador descartável) quando a instrução escreve em x0
+} InstrucaoDecodificada;
+
+typedef struct {
+    uint8_t *memoria;
+    size_t tamanho_memoria;
+    uint32_t tamanho_codigo;      // Arredondado para meias palavras
+    int comprimida;               // O código pode ter instruções de 16 bits
+    InstrucaoDecodificada *cache; // As instruções em ordem de endereço, mais a sentinela
+    uint32_t *enderecos;          // Endereço de cada entrada do cache
+    uint32_t *entradas;           // Entrada que começa em cada meia palavra do código (SEM_ENTRADA se nenhuma)
+    uint32_t numero_entradas;     // Sem contar a sentinela
+    uint8_t operacao_descritor[NUMERO_INSTRUCOES];
+} Simulador;
+
+typedef struct {
+    uint64_t instrucoes; // Instruções executadas
+    double segundos;
+    int codigo_saida;    // Pedido pelo programa (10: 0; 93: a0)
+    int erro;            // 1 se a execução terminou por um erro, descrito em 'mensagem'
+    uint32_t pc;         // Endereço da instrução que causou o erro
+    char mensagem[96];
+} ResultadoExecucao;
+
+// Decodifica a instrução no endereço 'pc' do código. Retorna o descritor (NULL se não é uma
+// instrução) e grava os operandos e o tamanho em bytes.
+static const DescritorInstrucao *decodificar_endereco(const Simulador *sim, uint32_t pc, Operandos *op, uint32_t *tamanho) {
+    const uint8_t *origem = sim->memoria + pc;
+    *tamanho = 4;
+    if (sim->comprimida && pc + 2 <= sim->tamanho_codigo && (origem[0] & 0b11) != 0b11) {
+        *tamanho = 2;
+        return descomprimir_instrucao((uint16_t)(origem[0] | origem[1] << 8), op);
     }
+    return pc + 4 <= sim->tamanho_codigo ? decodificar_instrucao(ler_palavra_le(origem), op) : NULL;
+}
 
-    arquivo_saida = fopen(nome_arquivo_saida, "w");
-    if (arquivo_saida == NULL) {
-        perror("Erro ao abrir o arquivo de saída");
-        fclose(arquivo_entrada);
+// Preenche a entrada 'indice' com a instrução do seu endereço. O destino de branches e jal
+// fica provisoriamente em 'imm', como endereço, até resolver_destino.
+static void preencher_entrada(Simulador *sim, uint32_t indice) {
+    InstrucaoDecodificada *e = &sim->cache[indice];
+    uint32_t pc = sim->enderecos[indice], tamanho;
+    Operandos op;
+    const DescritorInstrucao *d = decodificar_endereco(sim, pc, &op, &tamanho);
+    e->retorno = pc + tamanho;
+    if (d == NULL) {
+        e->operacao = OP_ILEGAL;
         return;
     }
+    e->operacao = sim->operacao_descritor[d - tabela_instrucoes];
+    e->rd = (uint8_t)(op.rd != 0 ? op.rd : 32);
+    e->rs1 = (uint8_t)op.rs1;
+    e->rs2 = (uint8_t)op.rs2;
+    e->imm = op.imm;
+    if (d->formato == FORMATO_B || d->formato == FORMATO_J) {
+        e->imm = (int32_t)(pc + (uint32_t)op.imm);
+    } else if (d->formato == FORMATO_U) {
+        e->imm = (int32_t)(((uint32_t)op.imm << 12) + (d->opcode == 0b0010111 ? pc : 0)); // auipc soma o próprio endereço
+    } else if (d->operandos == OPERANDOS_RD_RS1_SHAMT) {
+        e->imm = op.imm & 0x1F;
+    }
+}
+
+// Troca o endereço de destino de um branch ou jal pela distância até a entrada do destino
+static void resolver_destino(Simulador *sim, uint32_t indice) {
+    InstrucaoDecodificada *e = &sim->cache[indice];
+    if ((e->operacao < OP_BEQ || e->operacao > OP_BGEU) && e->operacao != OP_JAL) return;
+    uint32_t destino = (uint32_t)e->imm;
+    if (destino <= sim->tamanho_codigo && sim->entradas[destino >> 1] != SEM_ENTRADA) {
+        e->imm = (int32_t)(sim->entradas[destino >> 1] - indice);
+    } else {
+        e->operacao = OP_DESVIO_INVALIDO;
+    }
+}
 
-    while (fgets(linha, sizeof(linha), arquivo_entrada) != NULL) {
-        // Remove nova linha e espaços em branco no final
-        linha[strcspn(linha, "\n\r")] = 0;
-        char *inicio_linha = linha;
-        while (*inicio_linha == ' ' || *inicio_linha == '\t') inicio_linha++;
+// Decodifica o código inteiro, seguindo-o do início ao fim
+static void construir_cache(Simulador *sim) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i <= sim->tamanho_codigo >> 1; i++) sim->entradas[i] = SEM_ENTRADA;
+    for (uint32_t pc = 0; pc < sim->tamanho_codigo; pc = sim->cache[n++].retorno) {
+        sim->enderecos[n] = pc;
+        sim->entradas[pc >> 1] = n;
+        preencher_entrada(sim, n);
+    }
+    sim->enderecos[n] = sim->tamanho_codigo;
+    sim->entradas[sim->tamanho_codigo >> 1] = n;
+    sim->cache[n] = (InstrucaoDecodificada){ 0, sim->tamanho_codigo, OP_FIM, 0, 0, 0 };
+    sim->numero_entradas = n;
+    for (uint32_t i = 0; i < n; i++) resolver_destino(sim, i);
+}
 
-        // Ignora linhas vazias ou comentários
-        if (strlen(inicio_linha) == 0 || inicio_linha[0] == '#' || inicio_linha[0] == ';') {
-            continue;
+// Um store no código redecodifica as instruções que ele alterou. Se alguma mudou de tamanho,
+// o cache inteiro é reconstruído e os índices das entradas mudam: retorna 1 nesse caso.
+static int atualizar_codigo(Simulador *sim, uint32_t endereco, uint32_t bytes) {
+    uint32_t meia = endereco >> 1;
+    while (sim->entradas[meia] == SEM_ENTRADA) meia--; // Instrução que contém o endereço (a de 0 sempre existe)
+    for (uint32_t i = sim->entradas[meia]; i < sim->numero_entradas && sim->enderecos[i] < endereco + bytes; i++) {
+        uint32_t tamanho = sim->cache[i].retorno - sim->enderecos[i];
+        preencher_entrada(sim, i);
+        if (sim->cache[i].retorno - sim->enderecos[i] != tamanho) {
+            construir_cache(sim);
+            return 1;
         }
-        
-        char linha_temporaria[256];
-        strcpy(linha_temporaria, inicio_linha);
+        resolver_destino(sim, i);
+    }
+    return 0;
+}
 
-        char *token = strtok(linha_temporaria, " ,\t");
-        if (token == NULL) continue;
+// Um branch sem instrução no destino só é um erro se for tomado (jal é sempre)
+static int desvio_tomado(const Simulador *sim, uint32_t pc, const uint32_t *x) {
+    Operandos op;
+    uint32_t tamanho;
+    const DescritorInstrucao *d = decodificar_endereco(sim, pc, &op, &tamanho);
+    if (d->formato == FORMATO_J) return 1;
+    uint32_t a = x[op.rs1], b = x[op.rs2];
+    switch (d->funct3) {
+    case 0b000: return a == b;
+    case 0b001: return a != b;
+    case 0b100: return (int32_t)a < (int32_t)b;
+    case 0b101: return (int32_t)a >= (int32_t)b;
+    case 0b110: return a < b;
+    default:    return a >= b;
+    }
+}
 
-        char *instrucao_mnemonica = token;
-        // Se o primeiro token for um rótulo, pegue o próximo token como a instrução
-        if (strchr(instrucao_mnemonica, ':') != NULL) {
-            instrucao_mnemonica = strtok(NULL, " ,\t");
-            if (instrucao_mnemonica == NULL) { // Linha continha apenas um rótulo
-                continue;
-            }
+// Trata um ecall. Retorna 0 para continuar, 1 se o programa pediu para encerrar ou -1 (com a
+// mensagem em 'resultado') se a chamada não é suportada.
+static int chamada_sistema(const Simulador *sim, const uint32_t *x, ResultadoExecucao *resultado) {
+    uint32_t a0 = x[10];
+    switch (x[17]) {
+    case 1: // Imprime inteiro
+        printf("%d", (int)(int32_t)a0);
+        return 0;
+    case 4: { // Imprime string terminada em '\0'
+        const uint8_t *fim = a0 < sim->tamanho_memoria ? memchr(sim->memoria + a0, '\0', sim->tamanho_memoria - a0) : NULL;
+        if (fim == NULL) {
+            snprintf(resultado->mensagem, sizeof(resultado->mensagem), "String em 0x%08x sem '\\0' dentro da memória", a0);
+            return -1;
         }
-        
-        uint32_t binario_instrucao = 0; // Valor binário da instrução
-        int instrucao_valida = 1;       // Flag para verificar se a instrução foi processada corretamente
-
-        // --- Instruções tipo R ---
-        // Formato: funct7 | rs2 | rs1 | funct3 | rd | opcode
-        if (strcmp(instrucao_mnemonica, "add") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-            if (rd == -1 || rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'add'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (rs2 << 20) | (rs1 << 15) | (0b000 << 12) | (rd << 7) | 0b0110011;
-        } else if (strcmp(instrucao_mnemonica, "sub") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-            if (rd == -1 || rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'sub'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0100000 << 25) | (rs2 << 20) | (rs1 << 15) | (0b000 << 12) | (rd << 7) | 0b0110011;
-        } else if (strcmp(instrucao_mnemonica, "xor") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-            if (rd == -1 || rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'xor'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (rs2 << 20) | (rs1 << 15) | (0b100 << 12) | (rd << 7) | 0b0110011;
-        } else if (strcmp(instrucao_mnemonica, "or") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-            if (rd == -1 || rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'or'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (rs2 << 20) | (rs1 << 15) | (0b110 << 12) | (rd << 7) | 0b0110011;
-        } else if (strcmp(instrucao_mnemonica, "and") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-            if (rd == -1 || rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'and'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (rs2 << 20) | (rs1 << 15) | (0b111 << 12) | (rd << 7) | 0b0110011;
-        // Instruções de shift (tipo R, mas com shamt no lugar de rs2 para o opcode específico)
-        // Formato SLLI/SRLI: 0000000 | shamt | rs1 | funct3 | rd | OPCODE (OP-IMM-SHIFT)
-        } else if (strcmp(instrucao_mnemonica, "slli") == 0) { // RV32I shamt é de 5 bits [24:20]
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *shamt_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int shamt = atoi(shamt_txt);
-            if (rd == -1 || rs1 == -1 || shamt < 0 || shamt > 31) { fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'slli'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (shamt << 20) | (rs1 << 15) | (0b001 << 12) | (rd << 7) | 0b0010011; // Opcode OP-IMM
-        } else if (strcmp(instrucao_mnemonica, "srli") == 0) { // RV32I shamt é de 5 bits [24:20]
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *shamt_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int shamt = atoi(shamt_txt);
-            if (rd == -1 || rs1 == -1 || shamt < 0 || shamt > 31) { fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'srli'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = (0b0000000 << 25) | (shamt << 20) | (rs1 << 15) | (0b101 << 12) | (rd << 7) | 0b0010011; // Opcode OP-IMM
-
-        // --- Instruções tipo I ---
-        // Formato: immediate[11:0] | rs1 | funct3 | rd | opcode
-        } else if (strcmp(instrucao_mnemonica, "addi") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rs1_txt = strtok(NULL, " ,\t"); char *imm_txt = strtok(NULL, " ,\t");
-            int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int imm = atoi(imm_txt);
-            if (rd == -1 || rs1 == -1 || imm < -2048 || imm > 2047) { fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'addi'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else binario_instrucao = ((imm & 0xFFF) << 20) | (rs1 << 15) | (0b000 << 12) | (rd << 7) | 0b0010011;
-        } else if (strcmp(instrucao_mnemonica, "lw") == 0) { // Formato: lw rd, offset(rs1)
-            char *rd_txt = strtok(NULL, " ,\t"); char *offset_rs1_txt = strtok(NULL, " ,\t"); // Pega "offset(rs1)"
-            char *offset_txt = strtok(offset_rs1_txt, "("); 
-            char *rs1_txt = strtok(NULL, ")");
-            if (rd_txt == NULL || offset_txt == NULL || rs1_txt == NULL) { fprintf(stderr, "Erro em 0x%04X: Formato inválido para 'lw'. Use 'lw rd, offset(rs1)'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else {
-                int rd = obter_numero_registrador(rd_txt); int rs1 = obter_numero_registrador(rs1_txt); int offset = atoi(offset_txt);
-                if (rd == -1 || rs1 == -1 || offset < -2048 || offset > 2047) { fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'lw'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-                else binario_instrucao = ((offset & 0xFFF) << 20) | (rs1 << 15) | (0b010 << 12) | (rd << 7) | 0b0000011; // Opcode LOAD
-            }
-        } else if (strcmp(instrucao_mnemonica, "jalr") == 0) { // Formato: jalr rd, rs1, offset  ou jalr rd, offset(rs1)
-            char *rd_txt = strtok(NULL, " ,\t");
-            char *arg2_txt = strtok(NULL, " ,\t"); // Pode ser rs1 ou offset(rs1)
-            char *arg3_txt = strtok(NULL, " ,\t"); // Pode ser offset ou NULL
-            
-            int rd = -1, rs1 = -1, offset = 0;
-            if (rd_txt) rd = obter_numero_registrador(rd_txt);
-
-            if (arg3_txt != NULL) { // Formato jalr rd, rs1, offset
-                if (arg2_txt) rs1 = obter_numero_registrador(arg2_txt);
-                offset = atoi(arg3_txt);
-            } else if (arg2_txt != NULL) { // Formato jalr rd, offset(rs1) ou jalr rd, rs1 (offset=0)
-                char *temp_rs1_txt = strchr(arg2_txt, '(');
-                if (temp_rs1_txt != NULL) { // Formato offset(rs1)
-                    *temp_rs1_txt = '\0'; // Separa offset
-                    offset = atoi(arg2_txt);
-                    rs1 = obter_numero_registrador(temp_rs1_txt + 1);
-                    // Remove ')' do final de rs1_txt se presente
-                    char* fecha_parenteses = strchr(temp_rs1_txt + 1, ')');
-                    if (fecha_parenteses) *fecha_parenteses = '\0';
-
-                } else { // Formato jalr rd, rs1 (offset implícito 0)
-                    rs1 = obter_numero_registrador(arg2_txt);
-                    offset = 0;
-                }
-            }
+        fwrite(sim->memoria + a0, 1, (size_t)(fim - (sim->memoria + a0)), stdout);
+        return 0;
+    }
+    case 11: // Imprime caractere
+        putchar((int)(a0 & 0xFF));
+        return 0;
+    case 10: // Encerra
+        resultado->codigo_saida = 0;
+        return 1;
+    case 93: // Encerra com código
+        resultado->codigo_saida = (int)(int32_t)a0;
+        return 1;
+    }
+    snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Chamada de sistema %u (a7) não suportada", x[17]);
+    return -1;
+}
 
-            if (rd == -1 || rs1 == -1 || offset < -2048 || offset > 2047) {
-                fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'jalr'. Linha: %s\n", endereco_atual, inicio_linha);
-                instrucao_valida = 0;
-            } else {
-                binario_instrucao = ((offset & 0xFFF) << 20) | (rs1 << 15) | (0b000 << 12) | (rd << 7) | 0b1100111; // Opcode JALR
-            }
-        
-        // --- Instruções tipo S ---
-        // Formato: imm[11:5] | rs2 | rs1 | funct3 | imm[4:0] | opcode
-        } else if (strcmp(instrucao_mnemonica, "sw") == 0) { // Formato: sw rs2, offset(rs1)
-            char *rs2_txt = strtok(NULL, " ,\t"); 
-            char *offset_rs1_txt = strtok(NULL, " ,\t"); // Pega "offset(rs1)"
-            char *offset_txt = strtok(offset_rs1_txt, "(");
-            char *rs1_txt = strtok(NULL, ")");
-            if (rs2_txt == NULL || offset_txt == NULL || rs1_txt == NULL) { fprintf(stderr, "Erro em 0x%04X: Formato inválido para 'sw'. Use 'sw rs2, offset(rs1)'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else {
-                int rs2 = obter_numero_registrador(rs2_txt); int rs1 = obter_numero_registrador(rs1_txt); int offset = atoi(offset_txt);
-                if (rs2 == -1 || rs1 == -1 || offset < -2048 || offset > 2047) { fprintf(stderr, "Erro em 0x%04X: Parâmetro inválido para 'sw'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-                else {
-                    uint32_t imm_11_5 = (offset >> 5) & 0x7F; // bits 11 a 5 do imediato
-                    uint32_t imm_4_0  = offset & 0x1F;        // bits 4 a 0 do imediato
-                    binario_instrucao = (imm_11_5 << 25) | (rs2 << 20) | (rs1 << 15) | (0b010 << 12) | (imm_4_0 << 7) | 0b0100011; // Opcode STORE
-                }
-            }
+#if defined(__GNUC__) && !defined(MONTADOR_DESPACHO_SWITCH)
+#define ROTINA(nome) rotina_##nome
+#define DESPACHAR() goto *rotinas[e->operacao]
+#else
+#define ROTINA(nome) case OP_##nome
+#define DESPACHAR() goto despacho
+#endif
+#define CONTINUAR() do { if (--restantes == 0) goto limite_atingido; DESPACHAR(); } while (0)
+#define PROXIMA() do { e++; CONTINUAR(); } while (0)
+#define DESVIAR_SE(condicao) do { e += (condicao) ? e->imm : 1; CONTINUAR(); } while (0)
+#define SALTAR_PARA(endereco)                                                                              \
+    do {                                                                                                   \
+        destino = (endereco);                                                                              \
+        if (destino > sim.tamanho_codigo || sim.entradas[destino >> 1] == SEM_ENTRADA) goto desvio_invalido; \
+        e = cache + sim.entradas[destino >> 1];                                                            \
+        CONTINUAR();                                                                                       \
+    } while (0)
+#define ACESSAR(bytes) \
+    uint32_t endereco = x[e->rs1] + (uint32_t)e->imm; \
+    if (endereco > limites_memoria[bytes]) { endereco_invalido = endereco; goto acesso_invalido; }
+#define ARMAZENAR(bytes, gravar)                                                                           \
+    do {                                                                                                   \
+        ACESSAR(bytes)                                                                                     \
+        gravar;                                                                                            \
+        if (endereco < sim.tamanho_codigo) {                                                               \
+            uint32_t seguinte = e->retorno;                                                                \
+            if (atualizar_codigo(&sim, endereco, bytes)) SALTAR_PARA(seguinte);                            \
+        }                                                                                                  \
+        PROXIMA();                                                                                         \
+    } while (0)
 
-        // --- Instruções tipo B ---
-        // Formato: imm[12] | imm[10:5] | rs2 | rs1 | funct3 | imm[4:1] | imm[11] | opcode
-        } else if (strcmp(instrucao_mnemonica, "beq") == 0 || strcmp(instrucao_mnemonica, "bne") == 0) {
-            char *rs1_txt = strtok(NULL, " ,\t"); char *rs2_txt = strtok(NULL, " ,\t"); char *rotulo_destino_txt = strtok(NULL, " ,\t");
-            if (rs1_txt == NULL || rs2_txt == NULL || rotulo_destino_txt == NULL) { fprintf(stderr, "Erro em 0x%04X: Formato inválido para '%s'. Linha: %s\n", endereco_atual, instrucao_mnemonica, inicio_linha); instrucao_valida = 0; }
-            else {
-                int rs1 = obter_numero_registrador(rs1_txt); int rs2 = obter_numero_registrador(rs2_txt);
-                int endereco_destino = buscar_endereco_rotulo(rotulo_destino_txt);
-                if (rs1 == -1 || rs2 == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para '%s'. Linha: %s\n", endereco_atual, instrucao_mnemonica, inicio_linha); instrucao_valida = 0; }
-                else if (endereco_destino == -1) { fprintf(stderr, "Erro em 0x%04X: Rótulo '%s' não encontrado. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0; }
-                else {
-                    int deslocamento = endereco_destino - endereco_atual; 
-                    // O deslocamento para branches é em múltiplos de 2 bytes (1 bit implícito 0 à direita)
-                    // O campo imediato de 13 bits (incluindo o implícito) pode representar de -4096 a +4094 bytes.
-                    if (deslocamento % 2 != 0) { fprintf(stderr, "Erro em 0x%04X: Deslocamento do branch '%s' não é múltiplo de 2. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0; }
-                    else if (deslocamento < -4096 || deslocamento > 4094) { fprintf(stderr, "Erro em 0x%04X: Deslocamento do branch '%s' fora do alcance. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0;}
-                    else {
-                        // Extração dos bits do imediato conforme formato B
-                        uint32_t imm_12   = (deslocamento >> 12) & 0x1;  // bit 12 do deslocamento
-                        uint32_t imm_10_5 = (deslocamento >> 5)  & 0x3F; // bits 10 a 5
-                        uint32_t imm_4_1  = (deslocamento >> 1)  & 0xF;  // bits 4 a 1
-                        uint32_t imm_11   = (deslocamento >> 11) & 0x1;  // bit 11
-                        
-                        uint32_t funct3 = (strcmp(instrucao_mnemonica, "beq") == 0) ? 0b000 : 0b001; // beq ou bne
-
-                        binario_instrucao = (imm_12 << 31) | (imm_10_5 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (imm_4_1 << 8) | (imm_11 << 7) | 0b1100011; // Opcode BRANCH
-                    }
-                }
-            }
-        
-        // --- Instruções tipo U ---
-        // Formato: immediate[31:12] | rd | opcode
-        } else if (strcmp(instrucao_mnemonica, "lui") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *imm_txt = strtok(NULL, " ,\t");
-            if (rd_txt == NULL || imm_txt == NULL) { fprintf(stderr, "Erro em 0x%04X: Formato inválido para 'lui'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else {
-                int rd = obter_numero_registrador(rd_txt); 
-                long imm_val = strtol(imm_txt, NULL, 0); // Permite hex (0x), octal (0), decimal
-                
-                // LUI carrega um imediato de 20 bits nos bits superiores (31 a 12) de rd.
-                // O valor fornecido (imm_val) é o que vai para esses bits.
-                if (rd == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'lui'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-                // Verifica se o imediato cabe em 20 bits (signed or unsigned interpretation of immediate can vary by assembler convention, typically it's the direct 20-bit value)
-                // Aqui, vamos assumir que o valor fornecido é o valor exato dos 20 bits superiores.
-                else binario_instrucao = ((imm_val & 0xFFFFF) << 12) | (rd << 7) | 0b0110111; // Opcode LUI
-            }
+// Executa o código de 'tamanho' bytes (com instruções de 16 bits se 'comprimida') em uma memória
+// de 'tamanho_memoria' bytes, com a seção 'dados' (se não for NULL) na sua base, até o programa
+// encerrar, ocorrer um erro ou serem executadas 'limite' instruções (0 = sem limite). Retorna 0
+// com o resultado preenchido, ou -1 (com a mensagem já impressa) se a memória não comporta o
+// programa ou falta memória no hospedeiro.
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-crossjumping", "no-gcse"))) // Senão o GCC funde os saltos de despacho de todas as rotinas em um só
+#endif
+SOMENTE_LINHA_COMANDO int executar_imagem(const uint8_t *imagem, size_t tamanho, const SecaoDados *dados, int comprimida, size_t tamanho_memoria,
+                    uint64_t limite, ResultadoExecucao *resultado) {
+    Simulador sim;
+    memset(&sim, 0, sizeof(sim));
+    memset(resultado, 0, sizeof(*resultado));
+    uint64_t tamanho_programa = tamanho_imagem((uint32_t)tamanho, dados);
+    if (tamanho_memoria < 4 || tamanho_memoria > ((size_t)1 << 32) || tamanho_programa > tamanho_memoria) {
+        fprintf(stderr, "Erro: A memória do simulador (%zu bytes) deve ter até 4 GiB e comportar o programa (%llu bytes).\n",
+                tamanho_memoria, (unsigned long long)tamanho_programa);
+        return -1;
+    }
+    sim.tamanho_memoria = tamanho_memoria;
+    sim.tamanho_codigo = (uint32_t)((tamanho + 1) & ~(size_t)1);
+    sim.comprimida = comprimida;
+    size_t maximo_entradas = sim.tamanho_codigo / 2 + 1;
+    sim.memoria = calloc(tamanho_memoria, 1);
+    sim.cache = malloc(maximo_entradas * sizeof(InstrucaoDecodificada));
+    sim.enderecos = malloc(maximo_entradas * sizeof(uint32_t));
+    sim.entradas = malloc(maximo_entradas * sizeof(uint32_t));
+    if (sim.memoria == NULL || sim.cache == NULL || sim.enderecos == NULL || sim.entradas == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para o simulador.\n");
+        free(sim.memoria);
+        free(sim.cache);
+        free(sim.enderecos);
+        free(sim.entradas);
+        return -1;
+    }
+    memcpy(sim.memoria, imagem, tamanho);
+    if (tamanho_programa > tamanho) dados_copiar(dados, sim.memoria + dados->base);
 
-        // --- Instruções tipo J (jal) ---
-        // Formato: imm[20] | imm[10:1] | imm[11] | imm[19:12] | rd | opcode
-        } else if (strcmp(instrucao_mnemonica, "jal") == 0) {
-            char *rd_txt = strtok(NULL, " ,\t"); char *rotulo_destino_txt = strtok(NULL, " ,\t");
-            if (rd_txt == NULL || rotulo_destino_txt == NULL) { fprintf(stderr, "Erro em 0x%04X: Formato inválido para 'jal'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-            else {
-                int rd = obter_numero_registrador(rd_txt);
-                int endereco_destino = buscar_endereco_rotulo(rotulo_destino_txt);
-                if (rd == -1) { fprintf(stderr, "Erro em 0x%04X: Registrador inválido para 'jal'. Linha: %s\n", endereco_atual, inicio_linha); instrucao_valida = 0; }
-                else if (endereco_destino == -1) { fprintf(stderr, "Erro em 0x%04X: Rótulo '%s' não encontrado. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0; }
-                else {
-                    int deslocamento = endereco_destino - endereco_atual;
-                    // O deslocamento para JAL é em múltiplos de 2 bytes.
-                    // O campo imediato de 21 bits (incluindo o implícito 0 à direita) pode representar +/- 1MB.
-                    if (deslocamento % 2 != 0) { fprintf(stderr, "Erro em 0x%04X: Deslocamento do JAL '%s' não é múltiplo de 2. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0; }
-                    // 20 bits para o imediato, deslocamento pode ser até 2^20 * 2 bytes = +/-1MB
-                    else if (deslocamento < -(1 << 20) || deslocamento >= (1 << 20) ) { fprintf(stderr, "Erro em 0x%04X: Deslocamento JAL '%s' fora do alcance. Linha: %s\n", endereco_atual, rotulo_destino_txt, inicio_linha); instrucao_valida = 0; }
-                    else {
-                        // Extração dos bits do imediato conforme formato J
-                        // deslocamento já é o valor em bytes.
-                        uint32_t imm20    = (deslocamento >> 20) & 0x1;    // bit 20 do deslocamento
-                        uint32_t imm10_1  = (deslocamento >> 1)  & 0x3FF;  // bits 10 a 1
-                        uint32_t imm11    = (deslocamento >> 11) & 0x1;    // bit 11
-                        uint32_t imm19_12 = (deslocamento >> 12) & 0xFF;   // bits 19 a 12
-                        
-                        binario_instrucao = (imm20 << 31) | (imm10_1 << 21) | (imm11 << 20) | (imm19_12 << 12) | (rd << 7) | 0b1101111; // Opcode JAL
-                    }
-                }
-            }
+    // Operação de cada descritor da tabela (as pseudoinstruções nunca saem da decodificação)
+    memset(sim.operacao_descritor, OP_ILEGAL, sizeof(sim.operacao_descritor));
+    for (int i = 0; i < NUMERO_OPERACOES; i++) {
+        if (mnemonicos_operacoes[i] != NULL) sim.operacao_descritor[buscar_instrucao(mnemonicos_operacoes[i]) - tabela_instrucoes] = (uint8_t)i;
+    }
+    construir_cache(&sim);
+
+    InstrucaoDecodificada *const cache = sim.cache;
+    InstrucaoDecodificada *e = cache;
+    uint8_t *const memoria = sim.memoria;
+    const uint32_t limites_memoria[5] = { 0, (uint32_t)(tamanho_memoria - 1), (uint32_t)(tamanho_memoria - 2), 0,
+                                          (uint32_t)(tamanho_memoria - 4) }; // Último endereço válido para cada largura
+    uint32_t x[33] = { 0 }; // x[32] recebe as escritas em x0
+    x[2] = (uint32_t)(tamanho_memoria & ~(size_t)15);
+    uint64_t inicial = limite ? limite : UINT64_MAX, restantes = inicial;
+    uint32_t endereco_invalido = 0, destino = 0;
+#if defined(__GNUC__) && !defined(MONTADOR_DESPACHO_SWITCH)
+#define ENDERECO_ROTINA(nome, mnemonico) &&rotina_##nome,
+    static void *const rotinas[NUMERO_OPERACOES] = { OPERACOES_SIMULADOR(ENDERECO_ROTINA) };
+#endif
+    struct timespec inicio, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+
+    DESPACHAR();
+#if !defined(__GNUC__) || defined(MONTADOR_DESPACHO_SWITCH)
+despacho:
+    switch (e->operacao) {
+#endif
+    ROTINA(ADD):    x[e->rd] = x[e->rs1] + x[e->rs2]; PROXIMA();
+    ROTINA(SUB):    x[e->rd] = x[e->rs1] - x[e->rs2]; PROXIMA();
+    ROTINA(SLL):    x[e->rd] = x[e->rs1] << (x[e->rs2] & 31); PROXIMA();
+    ROTINA(SLT):    x[e->rd] = (int32_t)x[e->rs1] < (int32_t)x[e->rs2]; PROXIMA();
+    ROTINA(SLTU):   x[e->rd] = x[e->rs1] < x[e->rs2]; PROXIMA();
+    ROTINA(XOR):    x[e->rd] = x[e->rs1] ^ x[e->rs2]; PROXIMA();
+    ROTINA(SRL):    x[e->rd] = x[e->rs1] >> (x[e->rs2] & 31); PROXIMA();
+    ROTINA(SRA):    x[e->rd] = (uint32_t)((int32_t)x[e->rs1] >> (x[e->rs2] & 31)); PROXIMA();
+    ROTINA(OR):     x[e->rd] = x[e->rs1] | x[e->rs2]; PROXIMA();
+    ROTINA(AND):    x[e->rd] = x[e->rs1] & x[e->rs2]; PROXIMA();
+    ROTINA(MUL):    x[e->rd] = x[e->rs1] * x[e->rs2]; PROXIMA();
+    ROTINA(MULH):   x[e->rd] = (uint32_t)(((int64_t)(int32_t)x[e->rs1] * (int32_t)x[e->rs2]) >> 32); PROXIMA();
+    ROTINA(MULHSU): x[e->rd] = (uint32_t)(((int64_t)(int32_t)x[e->rs1] * (int64_t)x[e->rs2]) >> 32); PROXIMA();
+    ROTINA(MULHU):  x[e->rd] = (uint32_t)(((uint64_t)x[e->rs1] * x[e->rs2]) >> 32); PROXIMA();
+    ROTINA(DIV): { // Divisão por zero e o estouro de INT32_MIN / -1 não causam exceção no RISC-V
+        int32_t a = (int32_t)x[e->rs1], b = (int32_t)x[e->rs2];
+        x[e->rd] = b == 0 ? UINT32_MAX : (a == INT32_MIN && b == -1) ? (uint32_t)a : (uint32_t)(a / b);
+        PROXIMA();
+    }
+    ROTINA(DIVU):   x[e->rd] = x[e->rs2] == 0 ? UINT32_MAX : x[e->rs1] / x[e->rs2]; PROXIMA();
+    ROTINA(REM): {
+        int32_t a = (int32_t)x[e->rs1], b = (int32_t)x[e->rs2];
+        x[e->rd] = b == 0 ? (uint32_t)a : (a == INT32_MIN && b == -1) ? 0 : (uint32_t)(a % b);
+        PROXIMA();
+    }
+    ROTINA(REMU):   x[e->rd] = x[e->rs2] == 0 ? x[e->rs1] : x[e->rs1] % x[e->rs2]; PROXIMA();
+    ROTINA(ADDI):   x[e->rd] = x[e->rs1] + (uint32_t)e->imm; PROXIMA();
+    ROTINA(SLTI):   x[e->rd] = (int32_t)x[e->rs1] < e->imm; PROXIMA();
+    ROTINA(SLTIU):  x[e->rd] = x[e->rs1] < (uint32_t)e->imm; PROXIMA();
+    ROTINA(XORI):   x[e->rd] = x[e->rs1] ^ (uint32_t)e->imm; PROXIMA();
+    ROTINA(ORI):    x[e->rd] = x[e->rs1] | (uint32_t)e->imm; PROXIMA();
+    ROTINA(ANDI):   x[e->rd] = x[e->rs1] & (uint32_t)e->imm; PROXIMA();
+    ROTINA(SLLI):   x[e->rd] = x[e->rs1] << e->imm; PROXIMA();
+    ROTINA(SRLI):   x[e->rd] = x[e->rs1] >> e->imm; PROXIMA();
+    ROTINA(SRAI):   x[e->rd] = (uint32_t)((int32_t)x[e->rs1] >> e->imm); PROXIMA();
+    ROTINA(LB):  { ACESSAR(1) x[e->rd] = (uint32_t)(int8_t)memoria[endereco]; PROXIMA(); }
+    ROTINA(LH):  { ACESSAR(2) x[e->rd] = (uint32_t)(int16_t)(memoria[endereco] | memoria[endereco + 1] << 8); PROXIMA(); }
+    ROTINA(LW):  { ACESSAR(4) x[e->rd] = ler_palavra_le(memoria + endereco); PROXIMA(); }
+    ROTINA(LBU): { ACESSAR(1) x[e->rd] = memoria[endereco]; PROXIMA(); }
+    ROTINA(LHU): { ACESSAR(2) x[e->rd] = (uint32_t)(memoria[endereco] | memoria[endereco + 1] << 8); PROXIMA(); }
+    ROTINA(SB):     ARMAZENAR(1, memoria[endereco] = (uint8_t)x[e->rs2]);
+    ROTINA(SH):     ARMAZENAR(2, gravar_meia_palavra_le(memoria + endereco, (uint16_t)x[e->rs2]));
+    ROTINA(SW):     ARMAZENAR(4, gravar_palavra_le(memoria + endereco, x[e->rs2]));
+    ROTINA(BEQ):    DESVIAR_SE(x[e->rs1] == x[e->rs2]);
+    ROTINA(BNE):    DESVIAR_SE(x[e->rs1] != x[e->rs2]);
+    ROTINA(BLT):    DESVIAR_SE((int32_t)x[e->rs1] < (int32_t)x[e->rs2]);
+    ROTINA(BGE):    DESVIAR_SE((int32_t)x[e->rs1] >= (int32_t)x[e->rs2]);
+    ROTINA(BLTU):   DESVIAR_SE(x[e->rs1] < x[e->rs2]);
+    ROTINA(BGEU):   DESVIAR_SE(x[e->rs1] >= x[e->rs2]);
+    ROTINA(AUIPC):
+    ROTINA(LUI):    x[e->rd] = (uint32_t)e->imm; PROXIMA();
+    ROTINA(JAL):    x[e->rd] = e->retorno; e += e->imm; CONTINUAR();
+    ROTINA(JALR): {
+        uint32_t base = x[e->rs1]; // Lido antes de escrever rd, que pode ser o mesmo registrador
+        x[e->rd] = e->retorno;
+        SALTAR_PARA((base + (uint32_t)e->imm) & ~1u);
+    }
+    ROTINA(ECALL): {
+        int chamada = chamada_sistema(&sim, x, resultado);
+        if (chamada < 0) goto erro;
+        if (chamada > 0) { restantes--; goto encerrado; } // O ecall de saída também conta
+        PROXIMA();
+    }
+    ROTINA(EBREAK):
+        snprintf(resultado->mensagem, sizeof(resultado->mensagem), "ebreak");
+        goto erro;
+    ROTINA(ILEGAL): {
+        uint32_t pc = sim.enderecos[e - cache];
+        if (pc + 4 <= sim.tamanho_codigo) snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Instrução ilegal 0x%08x", ler_palavra_le(memoria + pc));
+        else snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Instrução ilegal ou incompleta no fim do código");
+        goto erro;
+    }
+    ROTINA(DESVIO_INVALIDO):
+        if (!desvio_tomado(&sim, sim.enderecos[e - cache], x)) PROXIMA();
+        destino = (uint32_t)e->imm;
+        goto desvio_invalido;
+    ROTINA(FIM):
+        goto encerrado;
+#if !defined(__GNUC__) || defined(MONTADOR_DESPACHO_SWITCH)
+    }
+#endif
+
+desvio_invalido:
+    snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Desvio para 0x%08x, fora do código ou no meio de uma instrução", destino);
+    goto erro;
+acesso_invalido:
+    snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Acesso à memória fora dos limites (endereço 0x%08x)", endereco_invalido);
+    goto erro;
+limite_atingido:
+    snprintf(resultado->mensagem, sizeof(resultado->mensagem), "Limite de %llu instruções atingido", (unsigned long long)inicial);
+erro:
+    resultado->erro = 1;
+    resultado->pc = sim.enderecos[e - sim.cache];
+encerrado:
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    resultado->instrucoes = inicial - restantes;
+    resultado->segundos = (fim.tv_sec - inicio.tv_sec) + (fim.tv_nsec - inicio.tv_nsec) * 1e-9;
+    free(sim.memoria);
+    free(sim.cache);
+    free(sim.enderecos);
+    free(sim.entradas);
+    return 0;
+}
+
+// --- Modo de Observação (--observar) ---
+// Mantém o fonte, a tabela de rótulos e a IR da última montagem em memória e monta de novo a
+// cada mudança do arquivo de entrada. Quando a mudança se limita a linhas de instrução da seção
+// .text (sem rótulos nem diretivas) e não altera o total de bytes dessas linhas, os endereços
+// de todo o resto continuam valendo: só as linhas alteradas são interpretadas e codificadas de
+// novo, e a IR e os dados só têm as posições no fonte deslocadas. Nos demais casos (ou com
+// --rvc), o fonte é montado por inteiro, reaproveitando a memória do contexto.
+// Nos formatos de largura fixa (bin, vmem e texto), só os trechos da imagem que mudaram são
+// regravados no arquivo de saída; nos demais, ou se o tamanho da imagem mudou, ele é reescrito.
+// A mudança é percebida com inotify no diretório do arquivo, o que inclui os editores que gravam
+// um arquivo novo e o renomeiam; sem inotify, a data de modificação é consultada periodicamente.
+#define INTERVALO_CONSULTA_MS 100   // Sem inotify: intervalo entre as consultas ao arquivo
+#define DISTANCIA_JUNTAR_TRECHOS 64 // Trechos alterados a menos desta distância são regravados juntos
 
+typedef struct {
+    const char *nome;        // Arquivo observado
+    const char *nome_base;   // Nome sem o diretório, comparado com os eventos do inotify
+    int inotify;             // -1 = consulta periódica
+    struct stat estado;      // Data de modificação, tamanho e i-node vistos por último (consulta periódica)
+} Vigia;
+
+typedef struct {
+    const char *nome_saida;
+    const FormatoSaida *formato;
+    MontadorContexto *montagem;
+    int estado_valido;       // 1 se os rótulos e a IR do contexto correspondem a 'fonte'
+    Fonte fonte;             // Fonte da última montagem sem erros (texto NULL = nenhuma)
+    uint8_t *imagem;         // Imagem gravada na saída: código, zeros e dados (NULL = nenhuma)
+    size_t tamanho_imagem;
+    int regravar_tudo;       // 1 se a última escrita falhou e o arquivo pode não corresponder a 'imagem'
+} Observacao;
+
+static void vigia_iniciar(Vigia *vigia, const char *nome) {
+    const char *barra = strrchr(nome, '/');
+    vigia->nome = nome;
+    vigia->nome_base = barra ? barra + 1 : nome;
+    vigia->inotify = -1;
+    if (stat(nome, &vigia->estado) != 0) memset(&vigia->estado, 0, sizeof(vigia->estado));
+#ifdef __linux__
+    size_t tamanho_diretorio = barra ? (barra == nome ? 1 : (size_t)(barra - nome)) : 1;
+    char *diretorio = malloc(tamanho_diretorio + 1);
+    if (diretorio == NULL) return;
+    memcpy(diretorio, barra ? nome : ".", tamanho_diretorio);
+    diretorio[tamanho_diretorio] = '\0';
+    int descritor = inotify_init1(IN_CLOEXEC);
+    if (descritor >= 0 && inotify_add_watch(descritor, diretorio, IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) vigia->inotify = descritor;
+    else if (descritor >= 0) close(descritor);
+    free(diretorio);
+#endif
+}
+
+// Espera até o arquivo observado ser gravado (ou substituído)
+static void vigia_aguardar(Vigia *vigia) {
+#ifdef __linux__
+    while (vigia->inotify >= 0) {
+        union { struct inotify_event evento; char bytes[4096]; } buffer; // Alinhado para os eventos
+        ssize_t lidos = read(vigia->inotify, &buffer, sizeof(buffer));
+        if (lidos < 0 && errno == EINTR) continue;
+        if (lidos <= 0) { // Sem eventos (por exemplo, o diretório deixou de existir): passa a consultar
+            close(vigia->inotify);
+            vigia->inotify = -1;
+            break;
+        }
+        int relevante = 0;
+        for (char *p = buffer.bytes; p < buffer.bytes + lidos; ) {
+            const struct inotify_event *evento = (const struct inotify_event *)p;
+            if (evento->len > 0 && strcmp(evento->name, vigia->nome_base) == 0) relevante = 1;
+            p += sizeof(struct inotify_event) + evento->len;
+        }
+        if (!relevante) continue;
+        // Os eventos que já chegaram (um editor que grava em partes) valem pela mesma remontagem
+        struct pollfd pendente = { vigia->inotify, POLLIN, 0 };
+        while (poll(&pendente, 1, 0) > 0 && read(vigia->inotify, &buffer, sizeof(buffer)) > 0) {}
+        return;
+    }
+#endif
+    for (;;) {
+        struct timespec intervalo = { 0, INTERVALO_CONSULTA_MS * 1000000L };
+        nanosleep(&intervalo, NULL);
+        struct stat estado;
+        if (stat(vigia->nome, &estado) != 0) continue; // Sendo substituído: tenta na próxima consulta
+        if (estado.st_mtim.tv_sec != vigia->estado.st_mtim.tv_sec || estado.st_mtim.tv_nsec != vigia->estado.st_mtim.tv_nsec ||
+            estado.st_size != vigia->estado.st_size || estado.st_ino != vigia->estado.st_ino) {
+            vigia->estado = estado;
+            return;
+        }
+    }
+}
+
+static double milissegundos_desde(const struct timespec *inicio) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (agora.tv_sec - inicio->tv_sec) * 1e3 + (agora.tv_nsec - inicio->tv_nsec) * 1e-6;
+}
+
+static int inicio_de_linha(const char *texto, size_t posicao) {
+    return posicao == 0 || texto[posicao - 1] == '\n';
+}
+
+static uint32_t contar_linhas(const char *inicio, const char *fim) {
+    uint32_t linhas = 0;
+    while ((inicio = memchr(inicio, '\n', fim - inicio)) != NULL) {
+        linhas++;
+        inicio++;
+    }
+    return linhas;
+}
+
+// Índice da primeira instrução da IR cuja linha começa em 'posicao' do fonte ou depois
+static size_t primeira_instrucao_desde(const ProgramaIR *programa, uint32_t posicao) {
+    size_t inicio = 0, fim = programa->quantidade;
+    while (inicio < fim) {
+        size_t meio = inicio + (fim - inicio) / 2;
+        if (programa->instrucoes[meio].linha < posicao) inicio = meio + 1;
+        else fim = meio;
+    }
+    return inicio;
+}
+
+// Interpreta as linhas [inicio, fim) do fonte, a primeira de número 'numero_linha', como linhas
+// da seção .text a partir de 'endereco', acrescentando as instruções a 'programa' e os erros a
+// 'diagnosticos'. Retorna -1 se alguma linha define um rótulo, usa .globl ou muda de seção, o
+// que exige a montagem completa; senão, 0.
+static int observacao_interpretar(const Fonte *fonte, const char *inicio, const char *fim, uint32_t numero_linha, uint32_t endereco,
+                                  ProgramaIR *programa, ListaDiagnosticos *diagnosticos) {
+    SecaoDados dados; // Diretivas de dados na .text são erros: nada chega a ser guardado aqui
+    memset(&dados, 0, sizeof(dados));
+    int resultado = 0;
+    Lexico lexico;
+    lexico_iniciar(&lexico, inicio, fim);
+
+    for (; lexico.posicao < fim && resultado == 0; lexico_proxima_linha(&lexico), numero_linha++) {
+        const char *inicio_linha = lexico_linha(&lexico);
+        if (inicio_linha == NULL) continue;
+        LinhaAtual atual = { &lexico, diagnosticos, numero_linha, endereco, inicio_linha };
+        LinhaInterpretada interpretada;
+        interpretar_linha(&atual, SECAO_TEXTO, &dados, &interpretada);
+        if (interpretada.rotulo.texto != NULL || interpretada.global.texto != NULL || interpretada.secao != SECAO_INDEFINIDA) {
+            resultado = -1;
         } else {
-            fprintf(stderr, "Instrução desconhecida em 0x%04X: '%s'. Linha: %s\n", endereco_atual, instrucao_mnemonica, inicio_linha);
-            instrucao_valida = 0;
+            endereco += adicionar_instrucoes(programa, &interpretada, inicio_linha, (uint32_t)(inicio_linha - fonte->texto),
+                                             numero_linha, endereco, 0);
         }
+    }
+    dados_liberar(&dados);
+    return resultado;
+}
+
+// Aponta para 'novo' um ponteiro de 'antigo' que fica fora da região alterada
+static const char *observacao_reposicionar(const char *ponteiro, const char *antigo, const char *novo, size_t fim_antigo, size_t fim_novo) {
+    size_t posicao = (size_t)(ponteiro - antigo);
+    return posicao >= fim_antigo ? novo + (posicao - fim_antigo) + fim_novo : novo + posicao;
+}
+
+// Tenta remontar só as linhas que diferem entre obs->fonte e 'novo'. Retorna -1 se a mudança
+// exige a montagem completa (nada foi alterado); 1 se a codificação das linhas novas deu erros,
+// que ficam em 'diagnosticos' (o estado continua o do fonte anterior); 0 se o contexto passou a corresponder
+// a 'novo'. Os bytes [*inicio_codigo, *fim_codigo) de montagem->imagem foram então recodificados.
+static int observacao_remontar_linhas(Observacao *obs, const Fonte *novo, ListaDiagnosticos *diagnosticos,
+                                      uint32_t *linhas_interpretadas, size_t *inicio_codigo, size_t *fim_codigo) {
+    MontadorContexto *montagem = obs->montagem;
+    ProgramaIR *programa = &montagem->programa;
+    const char *a = obs->fonte.texto, *n = novo->texto;
+    size_t tamanho_a = obs->fonte.tamanho, tamanho_n = novo->tamanho;
+    if (!obs->estado_valido || montagem->comprimir) return -1;
 
-        if (instrucao_valida) {
-            char byte_binario_txt[9]; // 8 bits + terminador nulo
+    // Região alterada, em linhas inteiras: [inicio, fim_a) no fonte anterior e [inicio, fim_n) no novo
+    size_t menor = tamanho_a < tamanho_n ? tamanho_a : tamanho_n;
+    size_t inicio = 0, comum = 0;
+    while (menor - inicio >= 4096 && memcmp(a + inicio, n + inicio, 4096) == 0) inicio += 4096;
+    while (inicio < menor && a[inicio] == n[inicio]) inicio++;
+    while (!inicio_de_linha(a, inicio)) inicio--;
+    while (menor - inicio - comum >= 4096 && memcmp(a + tamanho_a - comum - 4096, n + tamanho_n - comum - 4096, 4096) == 0) comum += 4096;
+    while (comum < menor - inicio && a[tamanho_a - 1 - comum] == n[tamanho_n - 1 - comum]) comum++;
+    size_t fim_a = tamanho_a - comum, fim_n = tamanho_n - comum;
+    while (fim_a < tamanho_a && !(inicio_de_linha(a, fim_a) && inicio_de_linha(n, fim_n))) {
+        fim_a++;
+        fim_n++;
+    }
 
-            // Ordem dos bytes: Little-endian (byte menos significativo primeiro)
-            // Byte 0: bits 7-0 da instrução
-            // Byte 1: bits 15-8 da instrução
-            // Byte 2: bits 23-16 da instrução
-            // Byte 3: bits 31-24 da instrução
+    // As linhas anteriores não podem ter rótulos, .globl, mudança de seção nem dados (que, lidos
+    // como .text, dão erro); as instruções delas são [primeira, ultima) na IR
+    size_t primeira = primeira_instrucao_desde(programa, (uint32_t)inicio);
+    size_t ultima = primeira_instrucao_desde(programa, (uint32_t)fim_a);
+    uint32_t numero_linha = primeira < programa->quantidade
+        ? programa->instrucoes[primeira].numero_linha - contar_linhas(a + inicio, a + programa->instrucoes[primeira].linha)
+        : 1 + contar_linhas(a, a + inicio);
+    ProgramaIR anteriores, novas;
+    memset(&anteriores, 0, sizeof(anteriores));
+    memset(&novas, 0, sizeof(novas));
+    ListaDiagnosticos erros_anteriores = { NULL, 0, 0 };
+    int resultado = observacao_interpretar(&obs->fonte, a + inicio, a + fim_a, numero_linha, 0, &anteriores, &erros_anteriores);
+    if (erros_anteriores.quantidade > 0) resultado = -1;
+    diagnosticos_liberar(&erros_anteriores);
+    programa_ir_liberar(&anteriores);
+    if (resultado != 0) return -1;
 
-            uint8_t byte0 = (binario_instrucao >> 0)  & 0xFF;
-            uint8_t byte1 = (binario_instrucao >> 8)  & 0xFF;
-            uint8_t byte2 = (binario_instrucao >> 16) & 0xFF;
-            uint8_t byte3 = (binario_instrucao >> 24) & 0xFF;
+    uint32_t endereco = primeira < ultima ? programa->instrucoes[primeira].endereco : 0;
+    uint32_t tamanho_anterior = primeira < ultima
+        ? (ultima < programa->quantidade ? programa->instrucoes[ultima].endereco : programa->tamanho) - endereco : 0;
+    // Sem instruções antes, a seção das linhas não é conhecida: só comentários e linhas em branco
+    // servem. Com erros de interpretação, a montagem completa os informa nos endereços de antes do
+    // relaxamento, como na montagem normal.
+    if (observacao_interpretar(novo, n + inicio, n + fim_n, numero_linha, endereco, &novas, diagnosticos) != 0 ||
+        diagnosticos->quantidade > 0 || (primeira == ultima && novas.quantidade > 0)) {
+        diagnosticos_liberar(diagnosticos);
+        programa_ir_liberar(&novas);
+        return -1;
+    }
+    *linhas_interpretadas = contar_linhas(n + inicio, n + fim_n) + (fim_n > inicio && n[fim_n - 1] != '\n');
 
-            dec_para_bin_n_bits(8, byte0, byte_binario_txt);
-            fprintf(arquivo_saida, "%s\n", byte_binario_txt);
+    // Branches para destinos fora do alcance ocupam 8 bytes, como no relaxamento; os endereços
+    // fora da região só continuam valendo se o total de bytes não mudou
+    uint32_t tamanho_novo = 0;
+    for (size_t i = 0; i < novas.quantidade; i++) {
+        InstrucaoIR *ir = &novas.instrucoes[i];
+        ir->endereco = endereco + tamanho_novo;
+        if (ir->tamanho_simbolo != 0 && tabela_instrucoes[ir->instrucao].formato == FORMATO_B) {
+            int destino = tabela_rotulos_buscar(&montagem->rotulos, n + ir->simbolo, ir->tamanho_simbolo);
+            int deslocamento = destino - (int)ir->endereco;
+            if (destino != -1 && (deslocamento < -4096 || deslocamento > 4094)) ir->tamanho = 8;
+        }
+        tamanho_novo += ir->tamanho;
+    }
+    if (tamanho_novo != tamanho_anterior) {
+        programa_ir_liberar(&novas);
+        return -1;
+    }
+    codificar_intervalo(novo, &montagem->rotulos, &novas, 0, novas.quantidade, montagem->imagem, diagnosticos, NULL);
+    if (diagnosticos->quantidade > 0) { // Desfaz a codificação parcial
+        memcpy(montagem->imagem + endereco, obs->imagem + endereco, tamanho_anterior);
+        programa_ir_liberar(&novas);
+        return 1;
+    }
 
-            dec_para_bin_n_bits(8, byte1, byte_binario_txt);
-            fprintf(arquivo_saida, "%s\n", byte_binario_txt);
+    // Troca as instruções da região e desloca as posições no fonte de tudo o que vem depois
+    size_t removidas = ultima - primeira, quantidade = programa->quantidade - removidas + novas.quantidade;
+    if (quantidade > programa->capacidade) {
+        InstrucaoIR *maior = realloc(programa->instrucoes, quantidade * sizeof(InstrucaoIR));
+        if (maior == NULL) memoria_insuficiente("a representação intermediária");
+        programa->instrucoes = maior;
+        programa->capacidade = quantidade;
+    }
+    memmove(programa->instrucoes + primeira + novas.quantidade, programa->instrucoes + ultima,
+            (programa->quantidade - ultima) * sizeof(InstrucaoIR));
+    if (novas.quantidade > 0) memcpy(programa->instrucoes + primeira, novas.instrucoes, novas.quantidade * sizeof(InstrucaoIR));
+    programa->quantidade = quantidade;
+    int64_t delta_bytes = (int64_t)fim_n - (int64_t)fim_a;
+    int64_t delta_linhas = (int64_t)contar_linhas(n + inicio, n + fim_n) - (int64_t)contar_linhas(a + inicio, a + fim_a);
+    if (delta_bytes != 0 || delta_linhas != 0) {
+        for (size_t i = primeira + novas.quantidade; i < quantidade; i++) {
+            InstrucaoIR *ir = &programa->instrucoes[i];
+            ir->linha = (uint32_t)(ir->linha + delta_bytes);
+            if (ir->tamanho_simbolo != 0) ir->simbolo = (uint32_t)(ir->simbolo + delta_bytes);
+            ir->numero_linha = (uint32_t)(ir->numero_linha + delta_linhas);
+        }
+    }
+    if (novas.quantidade != removidas) {
+        for (uint32_t r = 0; r < montagem->rotulos.quantidade; r++) {
+            Rotulo *rotulo = &montagem->rotulos.rotulos[r];
+            if (!rotulo->dados && rotulo->instrucao >= ultima) rotulo->instrucao = (uint32_t)(rotulo->instrucao + novas.quantidade - removidas);
+        }
+    }
 
-            dec_para_bin_n_bits(8, byte2, byte_binario_txt);
-            fprintf(arquivo_saida, "%s\n", byte_binario_txt);
+    // Os itens e referências de dados apontam para o texto do fonte
+    SecaoDados *dados = &programa->dados;
+    for (size_t i = 0; i < dados->quantidade_itens; i++) {
+        ItemDados *item = &dados->itens[i];
+        if (item->texto_linha == NULL) continue;
+        if ((size_t)(item->texto_linha - a) >= fim_a) item->numero_linha = (uint32_t)(item->numero_linha + delta_linhas);
+        item->texto_linha = observacao_reposicionar(item->texto_linha, a, n, fim_a, fim_n);
+    }
+    for (size_t i = 0; i < dados->quantidade_referencias; i++) {
+        ReferenciaDados *referencia = &dados->referencias[i];
+        if ((size_t)(referencia->texto_linha - a) >= fim_a) referencia->numero_linha = (uint32_t)(referencia->numero_linha + delta_linhas);
+        referencia->texto_linha = observacao_reposicionar(referencia->texto_linha, a, n, fim_a, fim_n);
+        referencia->simbolo = observacao_reposicionar(referencia->simbolo, a, n, fim_a, fim_n);
+    }
+    programa_ir_liberar(&novas);
+    *inicio_codigo = endereco;
+    *fim_codigo = endereco + tamanho_novo;
+    return 0;
+}
 
-            dec_para_bin_n_bits(8, byte3, byte_binario_txt);
-            fprintf(arquivo_saida, "%s\n", byte_binario_txt);
-            
-            endereco_atual += 4; // Avança para o próximo endereço de instrução
-        } else {
-            // Se a instrução for inválida, não incremente o endereço_atual aqui
-            // pois a primeira passagem já contou todas as instruções válidas (ou linhas que pareciam instruções).
-            // Se uma instrução for inválida na segunda passagem, algo deu errado ou o erro é na instrução em si.
-            // A contagem de endereço_atual deve ser consistente com a primeira passagem.
-            // Para simplificar, vamos avançar o endereço_atual de qualquer forma para manter a sincronia,
-            // mas idealmente, um erro aqui deveria parar a montagem ou ser tratado de forma mais robusta.
-            // Para este exemplo, se uma instrução for inválida, ela não será escrita no arquivo de saída
-            // e o endereço_atual continua sendo incrementado para a próxima linha do arquivo de entrada.
-             endereco_atual += 4; // Mesmo que inválida, contamos para manter o endereço_atual sincronizado com a primeira passagem
+// Leva o arquivo de saída ao conteúdo de obs->imagem, que só difere da imagem gravada
+// anteriormente nos bytes [inicio, fim). 'anterior' tem os bytes antigos desse trecho (a partir
+// de 'inicio'); NULL se o arquivo precisa ser reescrito. *regravados recebe os bytes da imagem
+// escritos. Retorna 0 ou -1.
+static int observacao_gravar(Observacao *obs, const uint8_t *anterior, size_t inicio, size_t fim, size_t *regravados) {
+    const uint8_t *nova = obs->imagem;
+    *regravados = 0;
+    if (anterior == NULL || obs->regravar_tudo || obs->formato->largura_fixa == 0) {
+        *regravados = obs->tamanho_imagem;
+        obs->regravar_tudo = escrever_saida(obs->nome_saida, obs->formato, nova, obs->tamanho_imagem) != 0;
+        return obs->regravar_tudo ? -1 : 0;
+    }
+    anterior -= inicio; // Indexado como a imagem
+    for (size_t i = inicio; i < fim; ) {
+        size_t bloco = fim - i < 4096 ? fim - i : 4096;
+        if (memcmp(nova + i, anterior + i, bloco) == 0) {
+            i += bloco;
+            continue;
+        }
+        while (nova[i] == anterior[i]) i++;
+        size_t fim_trecho = i + 1;
+        for (size_t j = fim_trecho; j < fim && j - fim_trecho < DISTANCIA_JUNTAR_TRECHOS; j++) {
+            if (nova[j] != anterior[j]) fim_trecho = j + 1;
         }
+        if (saida_regravar(obs->nome_saida, obs->formato, nova, obs->tamanho_imagem, i, fim_trecho) != 0) {
+            obs->regravar_tudo = 1;
+            return -1;
+        }
+        *regravados += fim_trecho - i;
+        i = fim_trecho;
     }
+    return 0;
+}
 
-    fclose(arquivo_entrada);
-    fclose(arquivo_saida);
-    printf("Montagem concluída! Arquivo '%s' gerado.\n", nome_arquivo_saida);
+// Monta 'novo' por inteiro com o contexto e grava a imagem. Retorna 0 ou -1 (erros já impressos).
+static int observacao_montar_tudo(Observacao *obs, const Fonte *novo, size_t *regravados) {
+    MontadorContexto *montagem = obs->montagem;
+    size_t tamanho_codigo;
+    if (montar_fonte(montagem, novo, NULL, 0, &tamanho_codigo, NULL) != MONTADOR_OK) {
+        obs->estado_valido = 0;
+        diagnosticos_imprimir(&montagem->diagnosticos);
+        return -1;
+    }
+    obs->estado_valido = 1;
+
+    const SecaoDados *dados = &montagem->programa.dados;
+    size_t tamanho = (size_t)tamanho_imagem((uint32_t)tamanho_codigo, dados);
+    uint8_t *imagem = malloc(tamanho ? tamanho : 1);
+    if (imagem == NULL) memoria_insuficiente("a imagem do programa");
+    memcpy(imagem, montagem->imagem, tamanho_codigo);
+    if (tamanho > tamanho_codigo) {
+        memset(imagem + tamanho_codigo, 0, tamanho - tamanho_codigo);
+        dados_copiar(dados, imagem + dados->base);
+    }
+    uint8_t *anterior = obs->imagem != NULL && obs->tamanho_imagem == tamanho ? obs->imagem : NULL;
+    uint8_t *descartada = obs->imagem;
+    obs->imagem = imagem;
+    obs->tamanho_imagem = tamanho;
+    int resultado = observacao_gravar(obs, anterior, 0, tamanho, regravados);
+    free(descartada);
+    return resultado;
+}
+
+// Lê o fonte de novo e atualiza a saída, pelo caminho incremental quando possível
+static void observacao_atualizar(Observacao *obs, const char *nome_entrada) {
+    struct timespec inicio;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    Fonte novo;
+    if (carregar_fonte(nome_entrada, &novo, NULL) != 0) return;
+    if (obs->fonte.texto != NULL && novo.tamanho == obs->fonte.tamanho && memcmp(novo.texto, obs->fonte.texto, novo.tamanho) == 0) {
+        free(novo.texto); // Gravado sem mudanças
+        return;
+    }
+
+    ListaDiagnosticos diagnosticos = { NULL, 0, 0 };
+    uint32_t linhas = 0;
+    size_t inicio_codigo = 0, fim_codigo = 0, regravados = 0;
+    int resultado = obs->fonte.texto != NULL
+        ? observacao_remontar_linhas(obs, &novo, &diagnosticos, &linhas, &inicio_codigo, &fim_codigo) : -1;
+    if (resultado == 0) {
+        size_t tamanho = fim_codigo - inicio_codigo;
+        uint8_t *anterior = malloc(tamanho ? tamanho : 1);
+        if (anterior == NULL) memoria_insuficiente("a imagem do programa");
+        memcpy(anterior, obs->imagem + inicio_codigo, tamanho);
+        memcpy(obs->imagem + inicio_codigo, obs->montagem->imagem + inicio_codigo, tamanho);
+        int gravado = observacao_gravar(obs, anterior, inicio_codigo, fim_codigo, &regravados);
+        free(anterior);
+        free(obs->fonte.texto);
+        obs->fonte = novo;
+        if (gravado == 0) {
+            printf("Remontagem incremental: %u linha(s) interpretada(s), %zu byte(s) regravado(s) em %.2f ms.\n",
+                   linhas, regravados, milissegundos_desde(&inicio));
+        }
+    } else if (resultado == 1) {
+        diagnosticos_imprimir(&diagnosticos);
+        fprintf(stderr, "Montagem com erros; '%s' não foi alterado.\n", obs->nome_saida);
+        free(novo.texto);
+    } else if (observacao_montar_tudo(obs, &novo, &regravados) == 0) {
+        free(obs->fonte.texto);
+        obs->fonte = novo;
+        printf("Montagem completa: %zu byte(s) regravado(s) em %.2f ms.\n", regravados, milissegundos_desde(&inicio));
+    } else {
+        if (!obs->estado_valido) fprintf(stderr, "Montagem com erros; '%s' não foi alterado.\n", obs->nome_saida);
+        free(novo.texto);
+    }
+    diagnosticos_liberar(&diagnosticos);
+    fflush(stdout);
+}
+
+// Monta 'nome_entrada' em 'nome_saida' e continua montando a cada mudança do arquivo, até o
+// processo ser interrompido. Só retorna (com 1) se não conseguir começar.
+SOMENTE_LINHA_COMANDO int observar(const char *nome_entrada, const char *nome_saida, const FormatoSaida *formato, int comprimir, int64_t base_dados, int threads) {
+    Observacao obs;
+    memset(&obs, 0, sizeof(obs));
+    obs.nome_saida = nome_saida;
+    obs.formato = formato;
+    obs.montagem = montador_criar();
+    if (obs.montagem == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para a montagem.\n");
+        return 1;
+    }
+    montador_definir_threads(obs.montagem, threads);
+    obs.montagem->comprimir = comprimir;
+    obs.montagem->base_dados = base_dados;
+
+    Vigia vigia;
+    vigia_iniciar(&vigia, nome_entrada);
+    observacao_atualizar(&obs, nome_entrada);
+    printf("Observando '%s' (%s); '%s' é atualizado a cada mudança. Ctrl+C encerra.\n", nome_entrada,
+           vigia.inotify >= 0 ? "inotify" : "consulta periódica", nome_saida);
+    fflush(stdout);
+    for (;;) {
+        vigia_aguardar(&vigia);
+        observacao_atualizar(&obs, nome_entrada);
+    }
+}
+
+// --- Relatório de Estatísticas ---
+// Imprime as estatísticas em 'destino', como texto ou (json = 1) como um objeto JSON
+SOMENTE_LINHA_COMANDO void estatisticas_imprimir(FILE *destino, int json) {
+    struct rusage uso;
+    long pico_kib = getrusage(RUSAGE_SELF, &uso) == 0 ? uso.ru_maxrss : -1; // Em KiB no Linux
+
+    if (json) {
+        fprintf(destino, "{\n  \"fases\": [");
+        for (size_t i = 0; i < estatisticas.numero_fases; i++) {
+            const TempoFase *fase = &estatisticas.fases[i];
+            fprintf(destino, "%s\n    { \"fase\": \"%s\", \"parede_s\": %.6f, \"cpu_s\": %.6f }",
+                    i ? "," : "", fase->nome, fase->parede, fase->cpu);
+        }
+        fprintf(destino, "\n  ],\n  \"memoria_pico_kib\": %ld,\n", pico_kib);
+#ifdef MONTADOR_ESTATISTICAS
+        fprintf(destino, "  \"contadores\": {\n    \"linhas\": %llu,\n    \"buscas_rotulos\": %llu,\n"
+                         "    \"sondagens_rotulos\": %llu,\n    \"bytes_escritos\": %llu,\n    \"instrucoes\": {",
+                (unsigned long long)estatisticas.linhas, (unsigned long long)estatisticas.buscas_rotulos,
+                (unsigned long long)estatisticas.sondagens_rotulos, (unsigned long long)estatisticas.bytes_escritos);
+        const char *separador = "";
+        for (size_t i = 0; i < NUMERO_INSTRUCOES; i++) {
+            unsigned long long quantidade = estatisticas.instrucoes[i];
+            if (quantidade == 0) continue;
+            fprintf(destino, "%s \"%s\": %llu", separador, tabela_instrucoes[i].mnemonico, quantidade);
+            separador = ",";
+        }
+        fprintf(destino, " }\n  }\n}\n");
+#else
+        fprintf(destino, "  \"contadores\": null\n}\n");
+#endif
+        return;
+    }
+
+    fprintf(destino, "\n--- Estatísticas ---\n%-32s %12s %12s\n", "fase", "parede (ms)", "CPU (ms)");
+    for (size_t i = 0; i < estatisticas.numero_fases; i++) {
+        const TempoFase *fase = &estatisticas.fases[i];
+        fprintf(destino, "%-32s %12.3f %12.3f\n", fase->nome, fase->parede * 1e3, fase->cpu * 1e3);
+    }
+    fprintf(destino, "Pico de memória: %ld KiB\n", pico_kib);
+#ifdef MONTADOR_ESTATISTICAS
+    unsigned long long buscas = estatisticas.buscas_rotulos, sondagens = estatisticas.sondagens_rotulos;
+    fprintf(destino, "Linhas lidas: %llu\n", (unsigned long long)estatisticas.linhas);
+    fprintf(destino, "Tabela de rótulos: %llu buscas, %llu sondagens (%.2f por busca)\n",
+            buscas, sondagens, buscas ? (double)sondagens / buscas : 0.0);
+    fprintf(destino, "Bytes escritos: %llu\n", (unsigned long long)estatisticas.bytes_escritos);
+    fprintf(destino, "Instruções por mnemônico:\n");
+    for (size_t i = 0; i < NUMERO_INSTRUCOES; i++) {
+        unsigned long long quantidade = estatisticas.instrucoes[i];
+        if (quantidade > 0) fprintf(destino, "  %-8s %llu\n", tabela_instrucoes[i].mnemonico, quantidade);
+    }
+#else
+    fprintf(destino, "(Contadores desativados: compile com -DMONTADOR_ESTATISTICAS para obtê-los.)\n");
+#endif
 }
 
+#ifndef MONTADOR_SEM_MAIN // Permite incluir o montador em outros programas (ex.: benchmarks)
 int main(int argc, char *argv[]) {
     const char *nome_arquivo_entrada = NULL;
     const char *nome_arquivo_saida = NULL;
+    const FormatoSaida *formato = NULL;
+    const char *nome_manifesto = NULL;
+    int threads = 0; // 0 = não informado
+    int em_fluxo = 0;
+    int objeto = 0; // -c: gera um objeto relocável
+    int comprimir = 0; // --rvc: usa instruções comprimidas
+    int ligar = 0;  // --ligar: liga objetos em vez de montar
+    int executar = 0; // --executar: simula o programa em vez de gravá-lo
+    int observando = 0; // --observar: monta de novo a cada mudança da entrada
+    size_t tamanho_memoria = MEMORIA_PADRAO_SIMULADOR;
+    uint64_t limite_instrucoes = 0; // 0 = sem limite
+    const char *nome_arquivo_dados = NULL; // --dados: a seção .data vai para um arquivo próprio
+    int64_t base_dados = -1; // --base-dados (-1 = logo após o código)
+    const char *nome_listagem = NULL, *nome_mapa = NULL, *nome_filtro = NULL; // --listagem, --mapa e --gtkwave
+    int estatisticas_json = 0;
+    int posicionais = 0;
+    char **arquivos = argv + 1; // Nomes de arquivos, compactados no início de argv
+    char *nome_objeto_padrao = NULL;
+    MarcaTempo inicio_total;
 
-    // Verifica o número de argumentos para determinar os nomes dos arquivos
-    if (argc == 2) { // Apenas o arquivo de entrada foi fornecido
-        nome_arquivo_entrada = argv[1];
-        nome_arquivo_saida = "resposta.mif"; 
-        printf("INFO: Nome do arquivo de saída não fornecido. Usando '%s' como padrão.\n\n", nome_arquivo_saida);
-    } else if (argc == 3) { // Ambos os arquivos foram fornecidos
-        nome_arquivo_entrada = argv[1];
-        nome_arquivo_saida = argv[2]; // O usuário especifica o nome completo, incluindo a extensão
-    } else { // Número incorreto de argumentos
-        fprintf(stderr, "Uso: %s <arquivo_entrada.asm> [nome_arquivo_saida.mif]\n", argv[0]);
+    // Separa as opções dos nomes de arquivos
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            formato = buscar_formato_saida(argv[++i]);
+            if (formato == NULL) {
+                fprintf(stderr, "Erro: Formato de saída '%s' desconhecido.\n", argv[i]);
+                posicionais = -1;
+                break;
+            }
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads < 1) {
+                fprintf(stderr, "Erro: Número de threads inválido '%s'.\n", argv[i]);
+                posicionais = -1;
+                break;
+            }
+        } else if (strcmp(argv[i], "--fluxo") == 0) {
+            em_fluxo = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            objeto = 1;
+        } else if (strcmp(argv[i], "--rvc") == 0) {
+            comprimir = 1;
+        } else if (strcmp(argv[i], "--ligar") == 0) {
+            ligar = 1;
+        } else if (strcmp(argv[i], "--executar") == 0) {
+            executar = 1;
+        } else if (strcmp(argv[i], "--observar") == 0) {
+            observando = 1;
+        } else if ((strcmp(argv[i], "--mem") == 0 || strcmp(argv[i], "--limite") == 0) && i + 1 < argc) {
+            int memoria = (argv[i][2] == 'm');
+            char *fim;
+            unsigned long long valor = strtoull(argv[++i], &fim, 0);
+            if (memoria && (*fim == 'K' || *fim == 'M' || *fim == 'G')) {
+                valor <<= (*fim == 'K' ? 10 : *fim == 'M' ? 20 : 30);
+                fim++;
+            }
+            if (*fim != '\0' || argv[i][0] == '-' || (memoria && valor == 0)) {
+                fprintf(stderr, "Erro: Valor inválido '%s' para %s.\n", argv[i], argv[i - 1]);
+                posicionais = -1;
+                break;
+            }
+            if (memoria) tamanho_memoria = (size_t)valor;
+            else limite_instrucoes = valor;
+        } else if (strcmp(argv[i], "--dados") == 0 && i + 1 < argc) {
+            nome_arquivo_dados = argv[++i];
+        } else if (strcmp(argv[i], "--listagem") == 0 && i + 1 < argc) {
+            nome_listagem = argv[++i];
+        } else if (strcmp(argv[i], "--mapa") == 0 && i + 1 < argc) {
+            nome_mapa = argv[++i];
+        } else if (strcmp(argv[i], "--gtkwave") == 0 && i + 1 < argc) {
+            nome_filtro = argv[++i];
+        } else if (strcmp(argv[i], "--base-dados") == 0 && i + 1 < argc) {
+            char *fim;
+            unsigned long long valor = strtoull(argv[++i], &fim, 0);
+            if (*fim != '\0' || argv[i][0] == '-') {
+                fprintf(stderr, "Erro: Valor inválido '%s' para %s.\n", argv[i], argv[i - 1]);
+                posicionais = -1;
+                break;
+            }
+            if (valor > INT32_MAX) { // Os endereços dos rótulos são int (ver TAMANHO_MAXIMO_DADOS)
+                fprintf(stderr, "Erro: %s precisa ser menor que 0x80000000 (o programa fica nos primeiros 2 GiB).\n", argv[i - 1]);
+                posicionais = -1;
+                break;
+            }
+            base_dados = (int64_t)valor;
+        } else if (strcmp(argv[i], "--lote") == 0 && i + 1 < argc) {
+            nome_manifesto = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=json") == 0) {
+            estatisticas.ativas = 1;
+            estatisticas_json = (argv[i][7] == '=');
+        } else {
+            arquivos[posicionais++] = argv[i]; // Nunca ultrapassa o argumento atual
+        }
+    }
+    if (posicionais > 2 && !ligar) posicionais = -1;
+    // Objetos e ligação não têm seção .data; --dados vale só para uma montagem com arquivo de saída
+    if (((objeto || ligar) && (base_dados >= 0 || nome_arquivo_dados != NULL)) ||
+        (nome_arquivo_dados != NULL && (executar || nome_manifesto != NULL))) posicionais = -1;
+    if (posicionais >= 1) nome_arquivo_entrada = arquivos[0];
+    if (posicionais == 2) nome_arquivo_saida = arquivos[1]; // O usuário especifica o nome completo, incluindo a extensão
+
+    if (ligar && posicionais >= 2 && !objeto && !em_fluxo && nome_manifesto == NULL) { // Ligação: saída seguida dos objetos
+        pthread_once(&inicializacao_tabelas, inicializar_tabelas);
+        if (formato == NULL) formato = formato_pela_extensao(arquivos[0]);
+        inicio_total = estatisticas_marcar();
+        int resultado = ligar_objetos(arquivos + 1, (size_t)posicionais - 1, arquivos[0], formato);
+        estatisticas_fase("ligacao", inicio_total);
+        if (resultado == 0 && strcmp(arquivos[0], "-") != 0) {
+            printf("Ligação concluída! Arquivo '%s' gerado a partir de %d objeto(s).\n", arquivos[0], posicionais - 1);
+        } else if (resultado != 0) {
+            fprintf(stderr, "Ligação abortada devido a erros.\n");
+        }
+        if (estatisticas.ativas) {
+            fflush(stdout);
+            estatisticas_imprimir(stderr, estatisticas_json);
+        }
+        return resultado;
+    }
+
+    if (nome_manifesto != NULL && posicionais == 0 && !ligar) { // Montagem em lote: por padrão, uma thread por processador
+        if (threads == 0) {
+            long processadores = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = processadores > 0 ? (int)processadores : 1;
+        }
+        MarcaTempo inicio_lote = estatisticas_marcar();
+        pthread_once(&inicializacao_tabelas, inicializar_tabelas);
+        int resultado = montar_lote(nome_manifesto, formato, objeto, comprimir, base_dados, threads);
+        estatisticas_fase("lote", inicio_lote);
+        if (estatisticas.ativas) {
+            fflush(stdout);
+            estatisticas_imprimir(stderr, estatisticas_json);
+        }
+        return resultado;
+    }
+    if (threads == 0) threads = 1;
+
+    if (nome_arquivo_entrada != NULL && strcmp(nome_arquivo_entrada, "-") == 0) em_fluxo = 1;
+    int listar = nome_listagem != NULL || nome_mapa != NULL || nome_filtro != NULL;
+    if (posicionais < 1 || nome_manifesto != NULL || ligar || (objeto && em_fluxo) || (listar && (em_fluxo || observando)) ||
+        (executar && (posicionais != 1 || objeto || em_fluxo)) ||
+        (observando && (objeto || em_fluxo || executar || nome_arquivo_dados != NULL ||
+                        (posicionais == 2 && strcmp(arquivos[1], "-") == 0)))) { // Uso incorreto
+        fprintf(stderr, "Uso: %s [-f formato] [-j threads] [--fluxo] [--rvc] [--dados arquivo] [--base-dados endereço] [--stats[=json]]\n"
+                        "       [--listagem arquivo] [--mapa arquivo] [--gtkwave arquivo] <arquivo_entrada.asm> [nome_arquivo_saida.mif]\n", argv[0]);
+        fprintf(stderr, "     %s -c [-j threads] [--rvc] [--stats[=json]] [--listagem arquivo] [--mapa arquivo] [--gtkwave arquivo]\n"
+                        "       <arquivo_entrada.asm> [objeto.o]\n", argv[0]);
+        fprintf(stderr, "     %s [-f formato] [--stats[=json]] --ligar <nome_arquivo_saida> <objeto.o>...\n", argv[0]);
+        fprintf(stderr, "     %s [-f formato | -c] [-j threads] [--rvc] [--base-dados endereço] [--stats[=json]] --lote <manifesto>\n", argv[0]);
+        fprintf(stderr, "     %s --executar [-j threads] [--rvc] [--mem bytes] [--limite instruções] [--base-dados endereço] [--stats[=json]]\n"
+                        "       <arquivo_entrada.asm>\n", argv[0]);
+        fprintf(stderr, "     %s --observar [-f formato] [-j threads] [--rvc] [--base-dados endereço]\n"
+                        "       <arquivo_entrada.asm> [nome_arquivo_saida.mif]\n", argv[0]);
         fprintf(stderr, "Se [nome_arquivo_saida.mif] não for especificado, será usado 'resposta.mif' por padrão.\n");
+        fprintf(stderr, "Sem -f, o formato é escolhido pela extensão da saída (.mif, .bin, .hex, .vmem; outras: texto).\n");
+        fprintf(stderr, "Com -j N, fontes grandes são interpretados e codificados em N threads.\n");
+        fprintf(stderr, "Com --fluxo (ou com '-' como entrada, lendo da entrada padrão), o fonte é montado em uma\n");
+        fprintf(stderr, "única passagem, sem ser guardado em memória. Use '-' como saída para a saída padrão.\n");
+        fprintf(stderr, "Com --stats, os tempos de cada fase (e, se compilado com -DMONTADOR_ESTATISTICAS, os\n");
+        fprintf(stderr, "contadores internos) são impressos em stderr ao final; --stats=json usa o formato JSON.\n");
+        fprintf(stderr, "Com --lote, monta cada par 'entrada [saida]' do manifesto (um por linha), sem eco, em\n");
+        fprintf(stderr, "paralelo (-j N; por padrão, uma thread por processador), e imprime um resumo ao final.\n");
+        fprintf(stderr, "Com -c, gera um objeto relocável (por padrão, a entrada com extensão '.o'); rótulos não\n");
+        fprintf(stderr, "definidos no arquivo e referências %%hi/%%lo viram relocações. --ligar junta os objetos,\n");
+        fprintf(stderr, "resolve os rótulos declarados com .globl e grava o programa no formato da saída.\n");
+        fprintf(stderr, "Com --rvc, as instruções que têm forma comprimida (extensão C) ocupam 16 bits.\n");
+        fprintf(stderr, "Com --executar, o programa montado é executado no simulador embutido, com uma memória\n");
+        fprintf(stderr, "de --mem bytes (sufixos K, M e G; padrão 16M), até um ecall de saída (a7 = 10 ou 93) ou\n");
+        fprintf(stderr, "o fim do código; --limite interrompe a execução após o número dado de instruções.\n");
+        fprintf(stderr, "Com --observar, a saída é atualizada a cada gravação da entrada, até Ctrl+C; quando só\n");
+        fprintf(stderr, "linhas de instrução mudam, apenas elas são remontadas e regravadas (bin, vmem e texto).\n");
+        fprintf(stderr, "--listagem grava o endereço, o código e o texto de cada linha do fonte; --mapa, os rótulos\n");
+        fprintf(stderr, "em ordem de endereço; --gtkwave, um filtro de tradução do GTKWave para o sinal do PC. Não\n");
+        fprintf(stderr, "valem com --fluxo nem --observar.\n");
+        fprintf(stderr, "A seção .data (diretivas .word, .half, .byte, .space, .align e .incbin) fica logo após o\n");
+        fprintf(stderr, "código, ou em --base-dados (abaixo de 0x80000000: código e dados ficam nos primeiros 2 GiB);\n");
+        fprintf(stderr, "com --dados, vai para um arquivo próprio, no formato da saída.\n");
+        fprintf(stderr, "Formatos disponíveis:\n");
+        for (size_t i = 0; i < NUMERO_FORMATOS_SAIDA; i++) {
+            fprintf(stderr, "  %-6s %s\n", formatos_saida[i].nome, formatos_saida[i].descricao);
+        }
         return 1; // Termina o programa se o uso for incorreto
     }
+    if (nome_arquivo_saida == NULL && !executar) { // Apenas o arquivo de entrada foi fornecido
+        nome_arquivo_saida = objeto ? (nome_objeto_padrao = nome_com_extensao(nome_arquivo_entrada, ".o")) : "resposta.mif";
+        printf("INFO: Nome do arquivo de saída não fornecido. Usando '%s' como padrão.\n\n", nome_arquivo_saida);
+    }
+    if (formato == NULL && !executar) formato = formato_pela_extensao(nome_arquivo_saida);
+    int saida_padrao = executar || strcmp(nome_arquivo_saida, "-") == 0; // stdout é do código ou do programa: nada de ecos lá
+    if (observando) return observar(nome_arquivo_entrada, nome_arquivo_saida, formato, comprimir, base_dados, threads);
+    inicio_total = estatisticas_marcar();
 
-    // (O restante da função main continua como antes)
-    // Imprime o nome do arquivo de entrada e seu conteúdo
-    printf("%s:\n", nome_arquivo_entrada);
-    FILE *arquivo_asm_para_imprimir = fopen(nome_arquivo_entrada, "r");
-    if (arquivo_asm_para_imprimir == NULL) {
-        perror("Erro ao abrir arquivo de entrada para leitura inicial");
+    if (em_fluxo) { // Passagem única: sem eco do fonte, que não fica em memória
+        FILE *entrada = strcmp(nome_arquivo_entrada, "-") == 0 ? stdin : fopen(nome_arquivo_entrada, "rb");
+        if (entrada == NULL) {
+            diagnosticos_erro_arquivo(NULL, "Não foi possível abrir o arquivo de entrada '%s': %s", nome_arquivo_entrada, strerror(errno));
+            return 1;
+        }
+        pthread_once(&inicializacao_tabelas, inicializar_tabelas);
+        TabelaRotulos rotulos;
+        memset(&rotulos, 0, sizeof(rotulos));
+        ListaDiagnosticos diagnosticos = { NULL, 0, 0 };
+        MarcaTempo inicio = estatisticas_marcar();
+        int resultado = montar_fluxo(entrada, &rotulos, nome_arquivo_saida, formato, &diagnosticos, comprimir,
+                                     base_dados, nome_arquivo_dados) == 0 ? 0 : 1;
+        estatisticas_fase("fluxo", inicio);
+        if (diagnosticos.quantidade > 0) {
+            diagnosticos_imprimir(&diagnosticos);
+            fprintf(stderr, "Montagem abortada devido a erros.\n");
+        } else if (resultado == 0 && !saida_padrao) {
+            printf("Montagem concluída! Arquivo '%s' gerado.\n", nome_arquivo_saida);
+            if (nome_arquivo_dados != NULL) printf("Seção .data gravada em '%s'.\n", nome_arquivo_dados);
+        }
+        if (entrada != stdin) fclose(entrada);
+        diagnosticos_liberar(&diagnosticos);
+        tabela_rotulos_liberar(&rotulos);
+        estatisticas_fase("total", inicio_total);
+        if (estatisticas.ativas) {
+            fflush(stdout);
+            estatisticas_imprimir(stderr, estatisticas_json);
+        }
+        return resultado;
+    }
+
+    // Lê o arquivo de entrada uma única vez
+    MarcaTempo inicio = estatisticas_marcar();
+    Fonte fonte;
+    if (mapear_fonte(nome_arquivo_entrada, &fonte, NULL) != 0) {
         return 1;
     }
-    char buffer_linha[256];
-    // Zera buffer_linha para evitar problemas com strlen em arquivos vazios ou muito curtos
-    buffer_linha[0] = '\0';
-    while (fgets(buffer_linha, sizeof(buffer_linha), arquivo_asm_para_imprimir)) {
-        fputs(buffer_linha, stdout); // Imprime a linha incluindo sua nova linha
+    estatisticas_fase("leitura", inicio);
+
+    // Imprime o nome do arquivo de entrada e seu conteúdo
+    inicio = estatisticas_marcar();
+    if (!saida_padrao) {
+        printf("%s:\n", nome_arquivo_entrada);
+        fwrite(fonte.texto, 1, fonte.tamanho, stdout);
+        // Garante uma nova linha após o conteúdo do asm se o arquivo não terminar com uma,
+        // ou para espaçamento consistente.
+        if (fonte.tamanho > 0 && fonte.texto[fonte.tamanho - 1] != '\n') {
+            printf("\n");
+        }
+        printf("\n"); // Linha extra para separar a listagem do arquivo da próxima saída
     }
-    fclose(arquivo_asm_para_imprimir);
-    // Garante uma nova linha após o conteúdo do asm se o arquivo não terminar com uma,
-    // ou para espaçamento consistente.
-    if (strlen(buffer_linha) > 0 && buffer_linha[strlen(buffer_linha)-1] != '\n') {
-        printf("\n");
+    estatisticas_fase("eco", inicio);
+
+    MontadorContexto *montagem = montador_criar();
+    if (montagem == NULL) {
+        fprintf(stderr, "Erro: Memória insuficiente para a montagem.\n");
+        fonte_liberar(&fonte);
+        return 1;
     }
-    printf("\n"); // Linha extra para separar a listagem do arquivo da próxima saída
+    montador_definir_threads(montagem, threads);
+    montagem->comprimir = comprimir;
+    montagem->base_dados = base_dados;
+    montagem->dados_separados = nome_arquivo_dados != NULL;
+    Listagem listagem = { nome_listagem != NULL, nome_mapa != NULL, nome_filtro != NULL, { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+    if (listar) montagem->listagem = &listagem;
+    ListaRelocacoes relocacoes = { NULL, 0, 0 };
+    size_t tamanho;
+    int erros, resultado = 1;
 
+    if (montar_fonte(montagem, &fonte, NULL, 0, &tamanho, objeto ? &relocacoes : NULL) != MONTADOR_OK) {
+        diagnosticos_imprimir(&montagem->diagnosticos);
+        fprintf(stderr, "Montagem abortada devido a erros na %s passagem.\n", montagem->passagem_com_erros == 1 ? "primeira" : "segunda");
+        goto fim;
+    }
+    inicio = estatisticas_marcar();
+    if ((nome_listagem != NULL && texto_gravar(nome_listagem, &listagem.listagem) != 0) ||
+        (nome_mapa != NULL && texto_gravar(nome_mapa, &listagem.mapa) != 0) ||
+        (nome_filtro != NULL && texto_gravar(nome_filtro, &listagem.filtro) != 0)) {
+        goto fim;
+    }
+    estatisticas_fase("listagem", inicio);
 
-    // Primeira Passagem: Coleta rótulos
-    primeira_passagem(nome_arquivo_entrada);
+    if (executar) { // Executa a imagem em vez de gravá-la; o código de saída é o do programa
+        ResultadoExecucao execucao;
+        inicio = estatisticas_marcar();
+        if (executar_imagem(montagem->imagem, tamanho, &montagem->programa.dados, comprimir, tamanho_memoria, limite_instrucoes, &execucao) == 0) {
+            fflush(stdout);
+            if (execucao.erro) fprintf(stderr, "\nErro de execução em 0x%08x: %s.\n", execucao.pc, execucao.mensagem);
+            fprintf(stderr, "\nExecução: %llu instruções em %.3f s (%.1f milhões de instruções/s), código de saída %d.\n",
+                    (unsigned long long)execucao.instrucoes, execucao.segundos,
+                    execucao.segundos > 0 ? execucao.instrucoes / execucao.segundos * 1e-6 : 0.0, execucao.codigo_saida);
+            resultado = execucao.erro ? 1 : execucao.codigo_saida;
+        }
+        estatisticas_fase("execucao", inicio);
+        goto fim;
+    }
 
-    // Segunda Passagem: Monta o código e resolve rótulos
-    segunda_passagem(nome_arquivo_entrada, nome_arquivo_saida);
+    inicio = estatisticas_marcar();
+    if (objeto) erros = escrever_objeto(nome_arquivo_saida, montagem->imagem, tamanho, &montagem->rotulos, &relocacoes);
+    else erros = escrever_programa(nome_arquivo_saida, formato, montagem->imagem, (uint32_t)tamanho, &montagem->programa.dados);
+    if (erros == 0 && nome_arquivo_dados != NULL) erros = escrever_dados(nome_arquivo_dados, formato, &montagem->programa.dados);
+    estatisticas_fase("escrita", inicio);
+    if (erros != 0) {
+        goto fim;
+    }
+    resultado = 0;
+    if (saida_padrao) goto fim;
+    printf("Montagem concluída! Arquivo '%s' gerado.\n", nome_arquivo_saida);
+    if (nome_arquivo_dados != NULL) printf("Seção .data gravada em '%s'.\n", nome_arquivo_dados);
+    if (nome_listagem != NULL) printf("Listagem gravada em '%s'.\n", nome_listagem);
+    if (nome_mapa != NULL) printf("Mapa de símbolos gravado em '%s'.\n", nome_mapa);
+    if (nome_filtro != NULL) printf("Filtro do GTKWave gravado em '%s'.\n", nome_filtro);
 
-    // Imprime o nome do arquivo de saída e seu conteúdo
+    // Imprime o nome do arquivo de saída e seu conteúdo (apenas formatos de texto), formatando
+    // de novo a imagem que está em memória em vez de reler o arquivo
+    if (objeto || strcmp(formato->nome, "bin") == 0) goto fim;
+    inicio = estatisticas_marcar();
     printf("\n%s:\n", nome_arquivo_saida);
-    FILE *arquivo_bin_para_imprimir = fopen(nome_arquivo_saida, "r");
-    if (arquivo_bin_para_imprimir == NULL) {
-        fprintf(stderr, "Aviso: Não foi possível abrir '%s' para ler seu conteúdo. Pode não ter sido gerado ou estar vazio devido a erros na montagem.\n", nome_arquivo_saida);
-    } else {
-        char buffer_linha_bin[32]; // Linhas do binário/mif são curtas
-        buffer_linha_bin[0] = '\0';
-        while (fgets(buffer_linha_bin, sizeof(buffer_linha_bin), arquivo_bin_para_imprimir)) {
-            fputs(buffer_linha_bin, stdout);
-        }
-        fclose(arquivo_bin_para_imprimir);
-         // Garante uma nova linha no final da impressão do arquivo de saída se necessário
-        if (strlen(buffer_linha_bin) > 0 && buffer_linha_bin[strlen(buffer_linha_bin)-1] != '\n') {
-            printf("\n");
-        }
-    }
+    escrever_programa("-", formato, montagem->imagem, (uint32_t)tamanho, &montagem->programa.dados);
+    estatisticas_fase("eco", inicio);
 
-    return 0;
+fim:
+    listagem_liberar(&listagem);
+    relocacoes_liberar(&relocacoes);
+    montador_destruir(montagem);
+    fonte_liberar(&fonte);
+    free(nome_objeto_padrao);
+    estatisticas_fase("total", inicio_total);
+    if (estatisticas.ativas) {
+        fflush(stdout); // O relatório vem depois do eco
+        estatisticas_imprimir(stderr, estatisticas_json);
+    }
+    return resultado;
 }
+#endif
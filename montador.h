@@ -0,0 +1,57 @@
+// Interface de biblioteca do montador RV32I (com a extensão M).
+// Monta um fonte que está em memória para um buffer de palavras fornecido pelo chamador, sem
+// arquivos e sem imprimir nada: os erros ficam disponíveis como registros estruturados. Nenhuma
+// função encerra o programa: a falta de memória vira o resultado MONTADOR_ERRO_MEMORIA.
+//
+// Todo o estado de uma montagem fica no contexto. Contextos diferentes podem ser usados ao
+// mesmo tempo em threads diferentes; um mesmo contexto não deve ser usado por duas threads
+// ao mesmo tempo. Reutilizar o contexto entre montagens reaproveita a memória já alocada.
+//
+// Compilação como biblioteca (sem o main da linha de comando):
+//   gcc -O2 -pthread -DMONTADOR_SEM_MAIN -c montador.c
+// O objeto exporta apenas as funções montador_* abaixo; o resto do montador é interno.
+#ifndef MONTADOR_H
+#define MONTADOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct MontadorContexto MontadorContexto;
+
+typedef enum {
+    MONTADOR_OK = 0,
+    MONTADOR_ERRO_FONTE,      // O fonte tem erros (ver montador_diagnosticos)
+    MONTADOR_ERRO_CAPACIDADE, // O buffer não comporta o programa; *quantidade informa o necessário
+    MONTADOR_ERRO_TAMANHO,    // O fonte excede 4 GiB
+    MONTADOR_ERRO_MEMORIA     // Faltou memória; o contexto continua válido e pode ser reutilizado
+} MontadorResultado;
+
+typedef struct {
+    uint32_t numero_linha;   // Linha do fonte, a partir de 1
+    uint32_t endereco;       // Endereço (em bytes) da instrução da linha
+    const char *mensagem;
+    const char *texto_linha; // Texto da linha, sem o fim de linha
+} MontadorDiagnostico;
+
+// Cria um contexto (NULL se faltar memória). Não é preciso nenhuma inicialização global.
+MontadorContexto *montador_criar(void);
+void montador_destruir(MontadorContexto *contexto);
+
+// Número de threads usadas para interpretar e codificar fontes grandes (padrão: 1)
+void montador_definir_threads(MontadorContexto *contexto, int threads);
+
+// Monta os 'tamanho' bytes de 'fonte' (que não precisa terminar em '\0'), gravando uma
+// instrução por palavra, na ordem dos bytes da máquina, a partir do endereço 0. A seção
+// .data, se houver, vem logo após o código (alinhada), com a última palavra completada com zeros.
+// .incbin não é aceito (é um erro do fonte): a biblioteca não lê arquivos.
+// *quantidade recebe o número de palavras do programa, mesmo quando 'capacidade' não basta.
+// 'palavras' pode ser NULL (capacidade 0) para só consultar o tamanho: um programa não vazio
+// responde MONTADOR_ERRO_CAPACIDADE com *quantidade preenchido.
+MontadorResultado montador_montar(MontadorContexto *contexto, const char *fonte, size_t tamanho,
+                                  uint32_t *palavras, size_t capacidade, size_t *quantidade);
+
+// Erros da última montagem, em ordem de linha. Válidos até a próxima montagem no contexto.
+// Se faltar memória para a lista, retorna NULL com *quantidade = 0.
+const MontadorDiagnostico *montador_diagnosticos(MontadorContexto *contexto, size_t *quantidade);
+
+#endif
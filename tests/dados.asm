@@ -0,0 +1,26 @@
+# Seção .data com todas as diretivas de dados. Os arquivos de .incbin são relativos ao
+# diretório atual: o teste monta a partir de tests/
+.text
+    la a0, palavras
+    lw a1, 4(a0)
+    lui t0, %hi(texto)
+    lbu a2, %lo(texto)(t0)
+    jal x0, fim
+
+.data
+palavras: .word 0x12345678, -1, fim, texto
+meias:    .half 0xBEEF, -2
+bytes:    .byte 1, 2, 255
+          .align 2
+espaco:   .space 5, 0xAA
+          .align 3
+texto:    .incbin "dados_incluido.bin"
+          .incbin dados_incluido.bin, 1, 2
+vazio:    .incbin "dados_vazio.bin"
+depois:   .byte 0x7F
+          .align 2
+          .word vazio, depois
+
+.text
+fim:
+    addi a0, x0, 0
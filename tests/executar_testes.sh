@@ -0,0 +1,164 @@
+#!/bin/sh
+# Testes de regressão do montador: monta os fontes de tests/ e compara o que é gerado com
+# os arquivos esperados, byte a byte. Os .bin só de código (li_limites, relaxacao, rvc) foram
+# conferidos com o llvm-mc (-mattr=+m,+c), e o .hex com o llvm-objcopy; os que têm seção
+# .data, pelas regras de posicionamento. Variantes (-j 4, --fluxo) precisam dar o mesmo resultado.
+#
+# Com CC="gcc -fsanitize=address,undefined", roda os mesmos casos sob os sanitizers.
+#
+# Execução (de qualquer diretório; compila montador.c com $CC, ou gcc, a cada execução):
+#   tests/executar_testes.sh
+#   MONTADOR=./montador tests/executar_testes.sh   # usa um montador já compilado
+set -u
+
+testes=$(cd "$(dirname "$0")" && pwd)
+raiz=$(dirname "$testes")
+temporario=$(mktemp -d)
+trap 'rm -rf "$temporario"' EXIT
+
+montador=${MONTADOR:-}
+if [ -z "$montador" ]; then
+    montador=$temporario/montador
+    ${CC:-gcc} -std=c11 -O2 -pthread -o "$montador" "$raiz/montador.c" || exit 1
+fi
+case $montador in
+    /*) ;;
+    */*) montador=$PWD/$montador ;; # Alguns testes rodam em outro diretório
+esac
+
+falhas=0
+registro=$temporario/registro.txt
+
+# Executa o montador sem o eco do fonte, guardando as mensagens de erro, que só são
+# mostradas se o teste falhar
+montar() {
+    "$montador" "$@" >/dev/null 2>>"$registro"
+}
+
+# verificar <nome> <esperado> <obtido>
+verificar() {
+    if cmp -s "$2" "$3"; then
+        echo "ok     $1"
+    else
+        echo "FALHA  $1"
+        sed 's/^/       /' "$registro"
+        falhas=$((falhas + 1))
+    fi
+    : >"$registro"
+}
+
+: >"$registro"
+
+# Pseudoinstruções: li nos limites de cada expansão e branches relaxados nos dois sentidos
+for teste in li_limites relaxacao; do
+    montar -f bin "$testes/$teste.asm" "$temporario/$teste.bin"
+    verificar "$teste" "$testes/$teste.bin" "$temporario/$teste.bin"
+    montar -f bin -j 4 "$testes/$teste.asm" "$temporario/$teste-j4.bin"
+    verificar "$teste (-j 4)" "$testes/$teste.bin" "$temporario/$teste-j4.bin"
+done
+
+# Formatos de saída: faixas de palavras repetidas no MIF (8 e 32 bits) e registros Intel HEX
+# (conferidos com o llvm-objcopy); um programa vazio ainda gera um MIF de uma palavra
+montar -f mif "$testes/formatos.asm" "$temporario/formatos.mif"
+verificar "formatos (-f mif)" "$testes/formatos.mif" "$temporario/formatos.mif"
+montar -f mif32 "$testes/formatos.asm" "$temporario/formatos_32.mif"
+verificar "formatos (-f mif32)" "$testes/formatos_32.mif" "$temporario/formatos_32.mif"
+montar -f ihex "$testes/formatos.asm" "$temporario/formatos.hex"
+verificar "formatos (-f ihex)" "$testes/formatos.hex" "$temporario/formatos.hex"
+montar -f mif "$testes/vazio.asm" "$temporario/vazio.mif"
+verificar "vazio (-f mif)" "$testes/vazio.mif" "$temporario/vazio.mif"
+
+# Montagem em fluxo (--fluxo): o mesmo resultado da montagem em duas passagens, com as
+# referências para frente (branch, jal, la, %hi/%lo e .word) corrigidas depois
+montar -f bin "$testes/fluxo.asm" "$temporario/fluxo.bin"
+verificar "fluxo" "$testes/fluxo.bin" "$temporario/fluxo.bin"
+for teste in li_limites formatos fluxo; do
+    montar -f mif "$testes/$teste.asm" "$temporario/$teste-duas.mif"
+    montar -f mif --fluxo "$testes/$teste.asm" "$temporario/$teste-fluxo.mif"
+    verificar "$teste (--fluxo)" "$temporario/$teste-duas.mif" "$temporario/$teste-fluxo.mif"
+done
+montar -f bin --base-dados 0x1000 "$testes/fluxo.asm" "$temporario/fluxo-base.bin"
+montar -f bin --fluxo --base-dados 0x1000 - "$temporario/fluxo-base-entrada.bin" <"$testes/fluxo.asm"
+verificar "fluxo (--fluxo --base-dados, entrada padrão)" "$temporario/fluxo-base.bin" "$temporario/fluxo-base-entrada.bin"
+
+# Montagem em lote (--lote, em paralelo): o resumo sai na ordem do manifesto, um arquivo que
+# falta ou tem erros não impede os demais e o código de saída indica a falha
+mkdir "$temporario/lote"
+cp "$testes/li_limites.asm" "$testes/relaxacao.asm" "$testes/fluxo.asm" "$testes/lote_erro.asm" "$temporario/lote"
+if (cd "$temporario/lote" && "$montador" -f bin -j 4 --lote "$testes/lote.txt" >resumo.txt 2>erros.txt); then
+    echo "o lote terminou com código 0, apesar das falhas" >>"$registro"
+fi
+verificar "lote (resumo)" "$testes/lote.saida" "$temporario/lote/resumo.txt"
+# O motivo do erro de abertura vem do sistema (strerror) e fica de fora da comparação
+sed "s/^\(Erro: .*'\): .*\.\$/\1./" "$temporario/lote/erros.txt" >"$temporario/lote/erros_sem_motivo.txt"
+verificar "lote (erros)" "$testes/lote.erros" "$temporario/lote/erros_sem_motivo.txt"
+verificar "lote (li_limites)" "$testes/li_limites.bin" "$temporario/lote/li_limites-lote.bin"
+verificar "lote (relaxacao, nome derivado)" "$testes/relaxacao.bin" "$temporario/lote/relaxacao.bin"
+verificar "lote (fluxo)" "$testes/fluxo.bin" "$temporario/lote/fluxo-lote.bin"
+
+# Montagem separada: os dois objetos ligados devem dar o mesmo código da montagem dos dois
+# fontes juntos, em um único arquivo
+montar -c "$testes/ligacao_principal.asm" "$temporario/principal.o"
+montar -c "$testes/ligacao_rotinas.asm" "$temporario/rotinas.o"
+montar -f bin --ligar "$temporario/ligacao.bin" "$temporario/principal.o" "$temporario/rotinas.o"
+verificar "ligacao (-c + --ligar)" "$testes/ligacao.bin" "$temporario/ligacao.bin"
+cat "$testes/ligacao_principal.asm" "$testes/ligacao_rotinas.asm" >"$temporario/ligacao_unico.asm"
+montar -f bin "$temporario/ligacao_unico.asm" "$temporario/ligacao_unico.bin"
+verificar "ligacao (igual ao fonte único)" "$temporario/ligacao_unico.bin" "$temporario/ligacao.bin"
+
+# Instruções comprimidas (--rvc), misturadas às que não têm forma de 16 bits
+montar -f bin --rvc "$testes/rvc.asm" "$temporario/rvc.bin"
+verificar "rvc (--rvc)" "$testes/rvc.bin" "$temporario/rvc.bin"
+montar -f bin --rvc -j 4 "$testes/rvc.asm" "$temporario/rvc-j4.bin"
+verificar "rvc (--rvc -j 4)" "$testes/rvc.bin" "$temporario/rvc-j4.bin"
+
+# Simulador (--executar): o programa de exemplo imprime 35. O stderr traz o tempo de
+# execução, então só o stdout e o código de saída são comparados
+if "$montador" --executar "$raiz/program.asm" >"$temporario/program.saida" 2>>"$registro"; then
+    verificar "program.asm (--executar)" "$testes/program.saida" "$temporario/program.saida"
+else
+    echo "código de saída $?" >>"$registro"
+    verificar "program.asm (--executar)" "$testes/program.saida" /dev/null
+fi
+
+# Seção .data: todas as diretivas (inclusive .incbin de um trecho e de um arquivo vazio) e
+# rótulos de dados em .word, la e %hi/%lo, logo após o código e em --base-dados com --dados.
+# Os arquivos de .incbin são relativos ao diretório atual
+(
+    cd "$testes" || exit 1
+    montar -f bin dados.asm "$temporario/dados.bin"
+    montar -f bin -j 4 dados.asm "$temporario/dados-j4.bin"
+    montar -f bin --fluxo dados.asm "$temporario/dados-fluxo.bin"
+    montar -f bin --base-dados 0x1000 --dados "$temporario/dados_secao.bin" dados.asm "$temporario/dados_codigo.bin"
+)
+verificar "dados" "$testes/dados.bin" "$temporario/dados.bin"
+verificar "dados (-j 4)" "$testes/dados.bin" "$temporario/dados-j4.bin"
+verificar "dados (--fluxo)" "$testes/dados.bin" "$temporario/dados-fluxo.bin"
+verificar "dados (--base-dados, código)" "$testes/dados_codigo.bin" "$temporario/dados_codigo.bin"
+verificar "dados (--base-dados, --dados)" "$testes/dados_secao.bin" "$temporario/dados_secao.bin"
+
+# Listagem, mapa de símbolos e filtro do GTKWave: la de duas instruções, rótulos de dados,
+# instruções comprimidas e rótulos .globl (maiúsculos no mapa)
+for threads in 1 4; do
+    montar -f bin -j $threads --listagem "$temporario/fluxo.lst" --mapa "$temporario/fluxo.map" \
+        --gtkwave "$temporario/fluxo_gtkwave.txt" "$testes/fluxo.asm" "$temporario/fluxo-listagem.bin"
+    verificar "fluxo (--listagem, -j $threads)" "$testes/fluxo.lst" "$temporario/fluxo.lst"
+    verificar "fluxo (--mapa, -j $threads)" "$testes/fluxo.map" "$temporario/fluxo.map"
+    verificar "fluxo (--gtkwave, -j $threads)" "$testes/fluxo_gtkwave.txt" "$temporario/fluxo_gtkwave.txt"
+done
+montar -f bin --rvc --listagem "$temporario/rvc.lst" "$testes/rvc.asm" "$temporario/rvc-listagem.bin"
+verificar "rvc (--listagem)" "$testes/rvc.lst" "$temporario/rvc.lst"
+montar -c --mapa "$temporario/ligacao_principal.map" "$testes/ligacao_principal.asm" "$temporario/principal-mapa.o"
+verificar "ligacao_principal (-c --mapa)" "$testes/ligacao_principal.map" "$temporario/ligacao_principal.map"
+
+# Interface de biblioteca: o teste em C usa só montador.h, ligado ao objeto sem o main
+${CC:-gcc} -std=c11 -O2 -pthread -DMONTADOR_SEM_MAIN -c -o "$temporario/montador.o" "$raiz/montador.c" &&
+    ${CC:-gcc} -std=c11 -O2 -pthread -I"$raiz" -o "$temporario/teste_biblioteca" \
+        "$testes/teste_biblioteca.c" "$temporario/montador.o" || exit 1
+"$temporario/teste_biblioteca" || falhas=$((falhas + $?))
+
+if [ "$falhas" -ne 0 ]; then
+    echo "$falhas teste(s) com falha."
+    exit 1
+fi
+echo "Todos os testes passaram."
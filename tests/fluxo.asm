@@ -0,0 +1,24 @@
+# Referências para frente de todos os tipos, que a montagem em fluxo deixa pendentes
+inicio:
+    la a0, tabela          # lui + addi com %hi/%lo de um rótulo de dados
+    lw a1, 0(a0)
+    beq a1, x0, fim        # branch para frente
+    jal ra, rotina         # jal para frente
+    lui t0, %hi(valor)
+    addi t0, t0, %lo(valor)
+laco:
+    addi a1, a1, -1
+    bne a1, x0, laco       # branch para trás
+    jal x0, fim
+rotina:
+    add a2, a1, a1
+    jalr x0, 0(ra)
+fim:
+    jal x0, inicio
+
+.data
+tabela: .word 3, valor, fim
+valor:  .half 7
+        .byte 1, 2
+        .align 2
+        .word inicio
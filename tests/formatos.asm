@@ -0,0 +1,14 @@
+# Sequências de palavras iguais viram faixas no MIF
+inicio:
+    addi x1, x0, 1
+    nop
+    nop
+    nop
+    nop
+    add x2, x1, x1
+    add x2, x1, x1
+    nop
+laco:
+    addi x1, x1, -1
+    bne x1, x0, laco
+    jal x0, inicio
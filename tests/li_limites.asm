@@ -0,0 +1,10 @@
+# li nos limites de cada expansão: só addi, lui + addi com o ajuste do %lo negativo,
+# só lui e valores negativos
+    li a0, 2047         # addi
+    li a1, 2048         # lui 1 + addi -2048
+    li a2, 0x7ffff800   # lui 0x80000 + addi -2048
+    li a3, 0x80000000   # lui
+    li a4, -1           # addi
+    li a5, -2048        # addi
+    li a6, -2049        # lui + addi
+    li a7, 0xffffffff   # igual a -1
@@ -0,0 +1,13 @@
+# Primeiro objeto da ligação: usa rótulos definidos em ligacao_rotinas.asm
+.globl principal
+principal:
+    li a0, 21
+    jal dobro                   # jal para rótulo externo
+    lui t0, %hi(constante)      # endereço absoluto de rótulo externo
+    lw t1, %lo(constante)(t0)
+    la t2, principal            # rótulo local, mas absoluto: também é relocado
+    beq a0, t1, fim
+    j principal
+fim:
+    li a7, 10
+    ecall
@@ -0,0 +1,9 @@
+# Segundo objeto da ligação: fica logo após o primeiro
+.globl dobro
+.globl constante
+dobro:
+    add a0, a0, a0
+    ret
+constante:
+    addi zero, zero, 42         # palavra usada como dado por principal
+    j principal                 # jal de volta para o outro objeto
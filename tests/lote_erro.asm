@@ -0,0 +1,3 @@
+# Um erro no meio do lote não impede a montagem dos demais arquivos
+addi x1, x0, 1
+foo x1
@@ -0,0 +1,1040 @@
+# Branches além de +/- 4 KiB: o beq para frente e o para trás viram bne + jal (8 bytes);
+# os que alcançam o destino continuam com 4 bytes
+inicio:
+    beq a0, a1, fim     # para frente, relaxado
+    beq a0, a1, perto   # dentro do alcance
+perto:
+    # 1030 instruções (4120 bytes) entre os dois branches relaxados
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+    addi t0, t0, 1
+fim:
+    beq a0, a1, inicio  # para trás, relaxado
+    bne a0, a1, fim     # dentro do alcance
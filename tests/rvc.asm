@@ -0,0 +1,33 @@
+# Instruções com forma comprimida (--rvc) misturadas a outras que não têm
+inicio:
+    addi a0, a0, 1      # c.addi
+    addi sp, sp, -64    # c.addi16sp
+    addi s0, sp, 8      # c.addi4spn
+    li a1, 5            # c.li
+    lui a2, 3           # c.lui
+    mv a3, a1           # c.mv
+    add a3, a3, a2      # c.add
+    sw a0, 4(s0)        # c.sw
+    lw a1, 4(s0)        # c.lw
+    sw ra, 12(sp)       # c.swsp
+    lw ra, 12(sp)       # c.lwsp
+    slli a0, a0, 3      # c.slli
+    srli s1, s1, 2      # c.srli
+    srai s1, s1, 1      # c.srai
+    andi a4, a4, 7      # c.andi
+    sub a4, a4, a5      # c.sub
+    xor a4, a4, a5      # c.xor
+    or a4, a4, a5       # c.or
+    and a4, a4, a5      # c.and
+    addi t0, t1, 100    # sem forma comprimida
+    mul a0, a1, a2      # extensão M, sem forma comprimida
+    beqz a0, fim        # c.beqz
+    bnez a1, inicio     # c.bnez
+    beq a0, a1, fim     # sem forma comprimida
+    j inicio            # c.j
+    jal fim             # c.jal
+    jr ra               # c.jr
+    jalr a0             # c.jalr
+fim:
+    nop                 # c.nop
+    ebreak              # c.ebreak
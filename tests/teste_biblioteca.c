@@ -0,0 +1,73 @@
+// Testes da interface de biblioteca (montador.h), ligados ao objeto compilado com
+// -DMONTADOR_SEM_MAIN, como um programa que usa o montador faria. Imprime uma linha por
+// verificação, no formato de tests/executar_testes.sh, e sai com o número de falhas.
+//
+// Compilação (a partir da raiz do repositório; o executar_testes.sh faz isso sozinho):
+//   gcc -std=c11 -O2 -pthread -DMONTADOR_SEM_MAIN -c montador.c
+//   gcc -std=c11 -O2 -pthread -I. -o teste_biblioteca tests/teste_biblioteca.c montador.o
+#include "montador.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int falhas;
+
+static void verificar(const char *nome, int condicao) {
+    printf("%s  %s\n", condicao ? "ok   " : "FALHA", nome);
+    if (!condicao) falhas++;
+}
+
+int main(void) {
+    MontadorContexto *contexto = montador_criar();
+    if (contexto == NULL) {
+        printf("FALHA  montador_criar\n");
+        return 1;
+    }
+
+    static const char programa[] = "addi x1, x0, 5\nadd x2, x1, x1\n";
+    static const uint32_t esperado[] = { 0x00500093, 0x00108133 };
+    uint32_t palavras[4];
+    size_t quantidade;
+
+    // Montagem normal: palavras na ordem da máquina
+    MontadorResultado resultado = montador_montar(contexto, programa, strlen(programa), palavras, 4, &quantidade);
+    verificar("biblioteca: montagem", resultado == MONTADOR_OK && quantidade == 2 &&
+                                      memcmp(palavras, esperado, sizeof(esperado)) == 0);
+
+    // Buffer pequeno demais: informa o tamanho necessário
+    resultado = montador_montar(contexto, programa, strlen(programa), palavras, 1, &quantidade);
+    verificar("biblioteca: capacidade insuficiente", resultado == MONTADOR_ERRO_CAPACIDADE && quantidade == 2);
+
+    // Sem buffer: só consulta o tamanho
+    resultado = montador_montar(contexto, programa, strlen(programa), NULL, 0, &quantidade);
+    verificar("biblioteca: buffer NULL", resultado == MONTADOR_ERRO_CAPACIDADE && quantidade == 2);
+    resultado = montador_montar(contexto, "", 0, NULL, 0, &quantidade);
+    verificar("biblioteca: programa vazio sem buffer", resultado == MONTADOR_OK && quantidade == 0);
+
+    // Erros do fonte: um registro por linha com erro
+    static const char com_erro[] = "addi x1, x0, 5\nfoo x1\n";
+    resultado = montador_montar(contexto, com_erro, strlen(com_erro), palavras, 4, &quantidade);
+    size_t numero_erros;
+    const MontadorDiagnostico *diagnosticos = montador_diagnosticos(contexto, &numero_erros);
+    verificar("biblioteca: diagnósticos", resultado == MONTADOR_ERRO_FONTE && numero_erros == 1 &&
+                                          diagnosticos[0].numero_linha == 2 && diagnosticos[0].endereco == 4 &&
+                                          strcmp(diagnosticos[0].texto_linha, "foo x1") == 0);
+
+    // .incbin lê um arquivo, o que a biblioteca não faz
+    static const char com_incbin[] = ".data\n.incbin \"/etc/passwd\"\n";
+    resultado = montador_montar(contexto, com_incbin, strlen(com_incbin), palavras, 4, &quantidade);
+    diagnosticos = montador_diagnosticos(contexto, &numero_erros);
+    verificar("biblioteca: .incbin recusado", resultado == MONTADOR_ERRO_FONTE && numero_erros == 1 &&
+                                              diagnosticos[0].numero_linha == 2);
+
+    // O contexto continua utilizável depois de um erro, e a montagem seguinte não tem diagnósticos
+    memset(palavras, 0, sizeof(palavras));
+    montador_definir_threads(contexto, 4);
+    resultado = montador_montar(contexto, programa, strlen(programa), palavras, 4, &quantidade);
+    montador_diagnosticos(contexto, &numero_erros);
+    verificar("biblioteca: reutilização do contexto", resultado == MONTADOR_OK && quantidade == 2 && numero_erros == 0 &&
+                                                      memcmp(palavras, esperado, sizeof(esperado)) == 0);
+
+    montador_destruir(contexto);
+    return falhas;
+}
@@ -0,0 +1 @@
+# Só comentários: o MIF ainda precisa de uma palavra (DEPTH=0 não é aceito pelo Quartus)